@@ -86,6 +86,9 @@ private:
 
 			void				_AdoptRegionData(BRegion& region);
 			bool				_SetSize(long newSize);
+			void				_SetToInternal(const clipping_rect& rect);
+	static	bool				_Overlaps(const clipping_rect& a,
+									const clipping_rect& b);
 
 			clipping_rect		_Convert(const BRect& rect) const;
 			clipping_rect		_ConvertToInternal(const BRect& rect) const;
@@ -14,6 +14,11 @@ namespace BPackageKit {
 namespace BHPKG {
 
 
+namespace BPrivate {
+	class ChunkCache;
+}
+
+
 class BBufferCache;
 class BDataOutput;
 class BPackageData;
@@ -47,6 +52,12 @@ public:
 			status_t			CreatePackageDataReader(BDataReader* dataReader,
 									const BPackageData& data,
 									BPackageDataReader*& _reader);
+			status_t			CreatePackageDataReader(BDataReader* dataReader,
+									const BPackageData& data,
+									BPrivate::ChunkCache* chunkCache,
+									uint64 chunkCacheID,
+									BPackageDataReader*& _reader);
+									// chunkCache may be NULL
 
 private:
 			BBufferCache*		fBufferCache;
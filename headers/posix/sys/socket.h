@@ -108,6 +108,11 @@ struct msghdr {
 	int			msg_flags;		/* flags */
 };
 
+struct mmsghdr {
+	struct msghdr	msg_hdr;	/* the message */
+	unsigned int	msg_len;	/* number of bytes transferred */
+};
+
 /* Flags for the msghdr.msg_flags field */
 #define MSG_OOB			0x0001	/* process out-of-band data */
 #define MSG_PEEK		0x0002	/* peek at incoming message */
@@ -120,6 +125,7 @@ struct msghdr {
 #define MSG_BCAST		0x0100	/* this message rec'd as broadcast */
 #define MSG_MCAST		0x0200	/* this message rec'd as multicast */
 #define	MSG_EOF			0x0400	/* data completes connection */
+#define MSG_WAITFORONE	0x0800	/* recvmmsg(): only block for the first */
 
 struct cmsghdr {
 	socklen_t	cmsg_len;
@@ -155,6 +161,8 @@ struct ucred {
 	gid_t	gid;	/* GID of sender */
 };
 
+struct timespec;
+
 
 #if __cplusplus
 extern "C" {
@@ -176,8 +184,12 @@ ssize_t recv(int socket, void *buffer, size_t length, int flags);
 ssize_t recvfrom(int socket, void *buffer, size_t bufferLength, int flags,
 			struct sockaddr *address, socklen_t *_addressLength);
 ssize_t recvmsg(int socket, struct msghdr *message, int flags);
+int		recvmmsg(int socket, struct mmsghdr *messages, unsigned int count,
+			int flags, struct timespec *timeout);
 ssize_t send(int socket, const void *buffer, size_t length, int flags);
 ssize_t	sendmsg(int socket, const struct msghdr *message, int flags);
+int		sendmmsg(int socket, struct mmsghdr *messages, unsigned int count,
+			int flags);
 ssize_t sendto(int socket, const void *message, size_t length, int flags,
 			const struct sockaddr *address, socklen_t addressLength);
 int     setsockopt(int socket, int level, int option, const void *value,
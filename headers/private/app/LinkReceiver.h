@@ -31,6 +31,7 @@ class LinkReceiver {
 
 		status_t GetNextMessage(int32& code, bigtime_t timeout = B_INFINITE_TIMEOUT);
 		bool HasMessages() const;
+		bool PeekBufferedMessage(int32& code) const;
 		bool NeedsReply() const;
 		int32 Code() const;
 
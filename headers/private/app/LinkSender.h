@@ -52,6 +52,7 @@ class LinkSender {
 
 		char	*fBuffer;
 		size_t	fBufferSize;
+		size_t	fBatchSize;			// flush automatically beyond this size
 
 		uint32	fCurrentEnd;		// current append position
 		uint32	fCurrentStart;		// start of current message
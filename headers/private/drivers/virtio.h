@@ -0,0 +1,106 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _VIRTIO_H
+#define _VIRTIO_H
+
+/*
+	virtio PCI transport library
+
+	Module to simplify writing drivers for virtio devices, as provided by
+	KVM/QEMU and other hypervisors. It implements the legacy (virtio 0.9.5)
+	PCI transport, the virtqueues, and feature negotiation; the drivers only
+	need to know about their device type's configuration space and request
+	format.
+*/
+
+
+#include <KernelExport.h>
+#include <PCI.h>
+
+
+#define VIRTIO_PCI_MODULE_NAME		"generic/virtio_pci/v1"
+
+#define VIRTIO_PCI_VENDOR_ID		0x1af4
+#define VIRTIO_PCI_DEVICE_ID_MIN	0x1000
+#define VIRTIO_PCI_DEVICE_ID_MAX	0x103f
+
+// device types, as found in the PCI subsystem id
+#define VIRTIO_DEVICE_TYPE_NET		1
+#define VIRTIO_DEVICE_TYPE_BLOCK	2
+
+// transport feature bits (the device specific ones are below 24)
+#define VIRTIO_FEATURE_NOTIFY_ON_EMPTY		(1UL << 24)
+#define VIRTIO_FEATURE_RING_INDIRECT_DESC	(1UL << 28)
+#define VIRTIO_FEATURE_RING_EVENT_IDX		(1UL << 29)
+
+// interrupt status bits
+#define VIRTIO_INTERRUPT_QUEUE		0x01
+#define VIRTIO_INTERRUPT_CONFIG		0x02
+
+
+typedef struct virtio_device virtio_device;
+typedef struct virtio_queue virtio_queue;
+
+
+typedef struct virtio_pci_module_info {
+	module_info info;
+
+	// Resets the device, and acknowledges it. The device is ready for
+	// feature negotiation afterwards.
+	status_t	(*init_device)(const pci_info* info, virtio_device** _device);
+	// Resets the device, and frees all of its queues.
+	void		(*uninit_device)(virtio_device* device);
+
+	// Negotiates the features the driver supports with the ones the device
+	// offers, and returns the features that will be used.
+	uint32		(*negotiate_features)(virtio_device* device, uint32 supported);
+	// Tells the device that the driver is ready; must be called after all
+	// queues have been set up.
+	void		(*set_driver_ok)(virtio_device* device);
+	void		(*set_failed)(virtio_device* device);
+
+	void		(*read_device_config)(virtio_device* device, uint8 offset,
+					void* buffer, size_t size);
+	void		(*write_device_config)(virtio_device* device, uint8 offset,
+					const void* buffer, size_t size);
+
+	// Reads and acknowledges the interrupt status, returns a combination of
+	// the VIRTIO_INTERRUPT_* flags. Can be called from interrupt context.
+	uint8		(*interrupt_status)(virtio_device* device);
+
+	// Sets up the queue with the given index, the device decides about its
+	// size. The queue must be used by a single thread at a time.
+	status_t	(*alloc_queue)(virtio_device* device, uint16 index,
+					virtio_queue** _queue);
+	uint16		(*queue_size)(virtio_queue* queue);
+	uint16		(*queue_free_count)(virtio_queue* queue);
+
+	// Adds a request consisting of readVectorCount buffers the device reads
+	// from, followed by writtenVectorCount buffers the device writes to. The
+	// cookie is returned by dequeue() once the device is done with it.
+	status_t	(*queue_request)(virtio_queue* queue,
+					const physical_entry* vector, size_t readVectorCount,
+					size_t writtenVectorCount, void* cookie);
+	// Notifies the device about new requests, unless it asked not to be.
+	void		(*kick_queue)(virtio_queue* queue);
+	// Returns the cookie of the next request the device has finished, and
+	// the number of bytes it wrote.
+	bool		(*dequeue)(virtio_queue* queue, void** _cookie,
+					uint32* _usedLength);
+
+	// Suppresses or enables interrupts for the queue. When enabling, returns
+	// true if requests have already been finished in the meantime, and the
+	// queue must be processed again to not miss them.
+	bool		(*set_queue_interrupt)(virtio_queue* queue, bool enabled);
+
+	// Lets requests of up to maxVectorCount buffers occupy a single ring
+	// descriptor. Requires VIRTIO_FEATURE_RING_INDIRECT_DESC to have been
+	// negotiated.
+	status_t	(*set_queue_indirect)(virtio_queue* queue,
+					uint16 maxVectorCount);
+} virtio_pci_module_info;
+
+
+#endif	/* _VIRTIO_H */
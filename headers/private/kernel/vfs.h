@@ -260,10 +260,14 @@ ssize_t		_user_recv(int socket, void *data, size_t length, int flags);
 ssize_t		_user_recvfrom(int socket, void *data, size_t length, int flags,
 				struct sockaddr *address, socklen_t *_addressLength);
 ssize_t		_user_recvmsg(int socket, struct msghdr *message, int flags);
+ssize_t		_user_recvmmsg(int socket, struct mmsghdr *messages, uint32 count,
+				int flags, bigtime_t timeout);
 ssize_t		_user_send(int socket, const void *data, size_t length, int flags);
 ssize_t		_user_sendto(int socket, const void *data, size_t length, int flags,
 				const struct sockaddr *address, socklen_t addressLength);
 ssize_t		_user_sendmsg(int socket, const struct msghdr *message, int flags);
+ssize_t		_user_sendmmsg(int socket, struct mmsghdr *messages, uint32 count,
+				int flags);
 status_t	_user_getsockopt(int socket, int level, int option, void *value,
 				socklen_t *_length);
 status_t	_user_setsockopt(int socket, int level, int option,
@@ -119,6 +119,8 @@ public:
 			net_buffer*			Dequeue(bool clone);
 			status_t			BlockingDequeue(bool peek, bigtime_t timeout,
 									net_buffer** _buffer);
+			status_t			DequeueMultiple(uint32 flags,
+									net_buffer** _buffers, uint32* _count);
 
 			void				Clear();
 
@@ -134,6 +136,8 @@ protected:
 private:
 			status_t			_Enqueue(net_buffer* buffer);
 			net_buffer*			_Dequeue(bool peek);
+			status_t			_BlockingDequeue(bool peek, bigtime_t timeout,
+									net_buffer** _buffer);
 			void				_Clear();
 
 			status_t			_Wait(bigtime_t timeout);
@@ -228,33 +232,37 @@ DECL_DATAGRAM_SOCKET(inline status_t)::BlockingDequeue(bool peek,
 	bigtime_t timeout, net_buffer** _buffer)
 {
 	AutoLocker _(fLock);
+	return _BlockingDequeue(peek, timeout, _buffer);
+}
 
-	bool waited = false;
-	while (fBuffers.IsEmpty()) {
-		status_t status = SocketStatus(peek);
-		if (status != B_OK) {
-			if (peek)
-				_NotifyOneReader(false);
-			return status;
-		}
 
-		status = _Wait(timeout);
-		if (status != B_OK)
-			return status;
+/*!	Waits for the first buffer like Dequeue() does, and then also removes
+	the buffers that are queued behind it, up to \a _count in total. The
+	lock is only acquired once for all of them.
+	When peeking, only a single buffer is returned.
+*/
+DECL_DATAGRAM_SOCKET(inline status_t)::DequeueMultiple(uint32 flags,
+	net_buffer** _buffers, uint32* _count)
+{
+	if (*_count == 0)
+		return B_OK;
 
-		waited = true;
-	}
+	bool peek = (flags & MSG_PEEK) != 0;
 
-	*_buffer = _Dequeue(peek);
-	if (peek && waited) {
-		// There is a new buffer in the list; but since we are only peeking,
-		// notify the next waiting reader.
-		_NotifyOneReader(false);
-	}
+	AutoLocker _(fLock);
 
-	if (*_buffer == NULL)
-		return B_NO_MEMORY;
+	status_t status = _BlockingDequeue(peek, _SocketTimeout(flags),
+		&_buffers[0]);
+	if (status != B_OK)
+		return status;
 
+	uint32 count = 1;
+	if (!peek) {
+		while (count < *_count && !fBuffers.IsEmpty())
+			_buffers[count++] = _Dequeue(false);
+	}
+
+	*_count = count;
 	return B_OK;
 }
 
@@ -332,6 +340,39 @@ DECL_DATAGRAM_SOCKET(inline net_buffer*)::_Dequeue(bool peek)
 }
 
 
+DECL_DATAGRAM_SOCKET(inline status_t)::_BlockingDequeue(bool peek,
+	bigtime_t timeout, net_buffer** _buffer)
+{
+	bool waited = false;
+	while (fBuffers.IsEmpty()) {
+		status_t status = SocketStatus(peek);
+		if (status != B_OK) {
+			if (peek)
+				_NotifyOneReader(false);
+			return status;
+		}
+
+		status = _Wait(timeout);
+		if (status != B_OK)
+			return status;
+
+		waited = true;
+	}
+
+	*_buffer = _Dequeue(peek);
+	if (peek && waited) {
+		// There is a new buffer in the list; but since we are only peeking,
+		// notify the next waiting reader.
+		_NotifyOneReader(false);
+	}
+
+	if (*_buffer == NULL)
+		return B_NO_MEMORY;
+
+	return B_OK;
+}
+
+
 DECL_DATAGRAM_SOCKET(inline void)::_Clear()
 {
 	BufferList::Iterator it = fBuffers.GetIterator();
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _PACKAGE__HPKG__PRIVATE__CHUNK_CACHE_H_
+#define _PACKAGE__HPKG__PRIVATE__CHUNK_CACHE_H_
+
+
+#include <SupportDefs.h>
+
+
+namespace BPackageKit {
+
+namespace BHPKG {
+
+namespace BPrivate {
+
+
+/*!	Interface for a cache of uncompressed data chunks, which can be shared by
+	the data readers of any number of package files.
+	A chunk is identified by the cache ID of the package file it belongs to
+	(chosen by the user of the cache), and the offset of its compressed data
+	in that file.
+*/
+class ChunkCache {
+public:
+	virtual						~ChunkCache() {}
+
+	virtual	bool				LookupChunk(uint64 cacheID, uint64 offset,
+									void* buffer, size_t size) = 0;
+									// copies the chunk to the buffer, if
+									// cached
+	virtual	void				AddChunk(uint64 cacheID, uint64 offset,
+									const void* buffer, size_t size) = 0;
+};
+
+
+}	// namespace BPrivate
+
+}	// namespace BHPKG
+
+}	// namespace BPackageKit
+
+
+#endif	// _PACKAGE__HPKG__PRIVATE__CHUNK_CACHE_H_
@@ -348,6 +348,8 @@ extern ssize_t		_kern_recvfrom(int socket, void *data, size_t length,
 						socklen_t *_addressLength);
 extern ssize_t		_kern_recvmsg(int socket, struct msghdr *message,
 						int flags);
+extern ssize_t		_kern_recvmmsg(int socket, struct mmsghdr *messages,
+						uint32 count, int flags, bigtime_t timeout);
 extern ssize_t		_kern_send(int socket, const void *data, size_t length,
 						int flags);
 extern ssize_t		_kern_sendto(int socket, const void *data, size_t length,
@@ -355,6 +357,8 @@ extern ssize_t		_kern_sendto(int socket, const void *data, size_t length,
 						socklen_t addressLength);
 extern ssize_t		_kern_sendmsg(int socket, const struct msghdr *message,
 						int flags);
+extern ssize_t		_kern_sendmmsg(int socket, struct mmsghdr *messages,
+						uint32 count, int flags);
 extern status_t		_kern_getsockopt(int socket, int level, int option,
 						void *value, socklen_t *_length);
 extern status_t		_kern_setsockopt(int socket, int level, int option,
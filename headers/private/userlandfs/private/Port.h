@@ -20,10 +20,12 @@ public:
 				port_id			owner_port;
 				port_id			client_port;
 				int32			size;
+				area_id			shared_buffer_area;
+				int32			shared_buffer_size;
 			};
 
 public:
-								Port(int32 size);
+								Port(int32 size, int32 sharedBufferSize = 0);
 								Port(const Info* info);
 								~Port();
 
@@ -40,6 +42,13 @@ public:
 			void				Unreserve(int32 endOffset);
 			int32				ReservedSize() const { return fReservedSize; }
 
+			void*				GetSharedBuffer() const
+									{ return fSharedBuffer; }
+			int32				GetSharedBufferSize() const
+									{ return fInfo.shared_buffer_size; }
+			int32				ReserveSharedBuffer(int32 size);
+			void				UnreserveSharedBuffer(int32 offset);
+
 			status_t			Send(const void* message, int32 size);
 			status_t			Receive(void** _message, size_t* _size,
 									bigtime_t timeout = -1);
@@ -51,13 +60,47 @@ private:
 			uint8*				fBuffer;
 			int32				fCapacity;
 			int32				fReservedSize;
+			uint8*				fSharedBuffer;
+			area_id				fSharedBufferArea;
+			int32				fSharedBufferReservedSize;
 			status_t			fInitStatus;
 			bool				fOwner;
 };
 
+// SharedBufferReservation
+class SharedBufferReservation {
+public:
+	inline SharedBufferReservation(Port* port, size_t size)
+		: fPort(port),
+		  fOffset(size <= 0x7fffffff ? port->ReserveSharedBuffer(size) : -1)
+	{
+	}
+
+	inline ~SharedBufferReservation()
+	{
+		fPort->UnreserveSharedBuffer(fOffset);
+	}
+
+	inline int32 Offset() const
+	{
+		return fOffset;
+	}
+
+	inline void* Buffer() const
+	{
+		return fOffset >= 0
+			? (uint8*)fPort->GetSharedBuffer() + fOffset : NULL;
+	}
+
+private:
+	Port*	fPort;
+	int32	fOffset;
+};
+
 }	// namespace UserlandFSUtil
 
 using UserlandFSUtil::PortInfo;
 using UserlandFSUtil::Port;
+using UserlandFSUtil::SharedBufferReservation;
 
 #endif	// USERLAND_FS_PORT_H
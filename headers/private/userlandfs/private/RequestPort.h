@@ -13,7 +13,8 @@ class RequestHandler;
 // RequestPort
 class RequestPort {
 public:
-								RequestPort(int32 size);
+								RequestPort(int32 size,
+									int32 sharedBufferSize = 0);
 								RequestPort(const Port::Info* info);
 								~RequestPort();
 
@@ -938,10 +938,12 @@ public:
 // ReadRequest
 class ReadRequest : public FileRequest {
 public:
-	ReadRequest() : FileRequest(READ_REQUEST) {}
+	ReadRequest() : FileRequest(READ_REQUEST), sharedBufferOffset(-1) {}
 
 	off_t		pos;
 	size_t		size;
+	int32		sharedBufferOffset;
+		// >= 0: read into the port's shared buffer at this offset
 };
 
 // ReadReply
@@ -957,11 +959,17 @@ public:
 // WriteRequest
 class WriteRequest : public FileRequest {
 public:
-	WriteRequest() : FileRequest(WRITE_REQUEST) {}
+	WriteRequest()
+		: FileRequest(WRITE_REQUEST), sharedBufferOffset(-1),
+		  sharedBufferSize(0) {}
 	status_t GetAddressInfos(AddressInfo* infos, int32* count);
 
 	Address		buffer;
 	off_t		pos;
+	int32		sharedBufferOffset;
+		// >= 0: the data are in the port's shared buffer at this offset,
+		// not in buffer
+	int32		sharedBufferSize;
 };
 
 // WriteReply
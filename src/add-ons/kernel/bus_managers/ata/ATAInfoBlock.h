@@ -134,7 +134,16 @@ typedef struct ata_device_infoblock {
 		word_75_bit_5_15_reserved				: 11
 	);
 
-	uint16	word_76_79_reserved[4];
+	LBITFIELD6(
+		word_76_bit_0_reserved					: 1,
+		sata_gen1_supported						: 1,
+		sata_gen2_supported						: 1,
+		word_76_bit_3_7_reserved				: 5,
+		ncq_supported							: 1,
+		word_76_bit_9_15_reserved				: 7
+	);
+
+	uint16	word_77_79_reserved[3];
 
 	LBITFIELD15(
 		word_80_bit_0_reserved					: 1,
@@ -29,6 +29,7 @@ AHCIController::AHCIController(device_node *node,
 	fPortCountAvail(0),
 	fPortImplementedMask(0),
 	fIRQ(0),
+	fSCSIBus(NULL),
 	fInstanceCheck(-1)
 {
 	memset(fPort, 0, sizeof(fPort));
@@ -29,6 +29,10 @@ public:
 
 			device_node *	DeviceNode() { return fNode; }
 
+			void			SetSCSIBus(scsi_bus bus) { fSCSIBus = bus; }
+			uint32			QueueSize() const
+								{ return fCommandSlotCount * fPortCountAvail; }
+
 private:
 			bool			IsDevicePresent(uint device);
 			status_t		ResetController();
@@ -54,6 +58,7 @@ private:
 	uint32					fPortImplementedMask;
 	uint8					fIRQ;
 	AHCIPort *				fPort[32];
+	scsi_bus				fSCSIBus;
 
 // --- Instance check workaround begin
 	port_id fInstanceCheck;
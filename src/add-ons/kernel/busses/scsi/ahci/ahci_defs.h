@@ -244,6 +244,11 @@ typedef struct {
 #define PRD_TABLE_ENTRY_COUNT 168
 #define PRD_MAX_DATA_LENGTH 0x400000 /* 4 MB */
 
+// every command slot has its own command table, directly followed by its
+// PRD table (the size keeps the required 128 byte alignment)
+#define COMMAND_TABLE_SIZE \
+	(sizeof(command_table) + sizeof(prd) * PRD_TABLE_ENTRY_COUNT)
+
 
 typedef struct {
 	uint16 vendor;
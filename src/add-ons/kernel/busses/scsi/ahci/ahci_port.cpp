@@ -14,6 +14,7 @@
 #include <KernelExport.h>
 
 #include <ATAInfoBlock.h>
+#include <util/AutoLock.h>
 
 #include "ahci_controller.h"
 #include "ahci_tracing.h"
@@ -34,16 +35,25 @@
 #define RWTRACE(a...)
 
 
+static const bigtime_t kCommandTimeout = 20000000;
+
+
 AHCIPort::AHCIPort(AHCIController *controller, int index)
 	:
 	fController(controller),
 	fIndex(index),
 	fRegs(&controller->fRegs->port[index]),
 	fArea(-1),
+	fSlotCount(controller->fCommandSlotCount),
+	fQueueDepth(1),
+	fSlotsUsed(0),
 	fCommandsActive(0),
-	fRequestSem(-1),
-	fResponseSem(-1),
+	fQueuedActive(0),
+	fPolledSlots(0),
+	fCompletedSlots(0),
+	fDPC(NULL),
 	fDevicePresent(false),
+	fUseNCQ(false),
 	fUse48BitCommands(false),
 	fSectorSize(0),
 	fSectorCount(0),
@@ -51,18 +61,22 @@ AHCIPort::AHCIPort(AHCIController *controller, int index)
 	fTestUnitReadyActive(false),
 	fResetPort(false),
 	fError(false),
+	fTimedOut(false),
+	fErrorTfd(0),
 	fTrim(false)
 {
 	B_INITIALIZE_SPINLOCK(&fSpinlock);
-	fRequestSem = create_sem(1, "ahci request");
-	fResponseSem = create_sem(0, "ahci response");
+	mutex_init(&fExecutionLock, "ahci port execution");
+	fIdleCondition.Init(this, "ahci port idle");
+	memset(fRequests, 0, sizeof(fRequests));
+	memset(fIssueTime, 0, sizeof(fIssueTime));
+	memset(&fTimer, 0, sizeof(fTimer));
 }
 
 
 AHCIPort::~AHCIPort()
 {
-	delete_sem(fRequestSem);
-	delete_sem(fResponseSem);
+	mutex_destroy(&fExecutionLock);
 }
 
 
@@ -72,8 +86,7 @@ AHCIPort::Init1()
 	TRACE("AHCIPort::Init1 port %d\n", fIndex);
 
 	size_t size = sizeof(command_list_entry) * COMMAND_LIST_ENTRY_COUNT
-		+ sizeof(fis) + sizeof(command_table)
-		+ sizeof(prd) * PRD_TABLE_ENTRY_COUNT;
+		+ sizeof(fis) + COMMAND_TABLE_SIZE * fSlotCount;
 
 	char *virtAddr;
 	phys_addr_t physAddr;
@@ -90,10 +103,9 @@ AHCIPort::Init1()
 	virtAddr += sizeof(command_list_entry) * COMMAND_LIST_ENTRY_COUNT;
 	fFIS = (fis *)virtAddr;
 	virtAddr += sizeof(fis);
-	fCommandTable = (command_table *)virtAddr;
-	virtAddr += sizeof(command_table);
-	fPRDTable = (prd *)virtAddr;
-	TRACE("PRD table is at %p\n", fPRDTable);
+	fCommandTables = (uint8 *)virtAddr;
+	TRACE("command tables for %d slots are at %p\n", fSlotCount,
+		fCommandTables);
 
 	fRegs->clb  = LO32(physAddr);
 	fRegs->clbu = HI32(physAddr);
@@ -101,9 +113,12 @@ AHCIPort::Init1()
 	fRegs->fb   = LO32(physAddr);
 	fRegs->fbu  = HI32(physAddr);
 	physAddr += sizeof(fis);
-	fCommandList[0].ctba  = LO32(physAddr);
-	fCommandList[0].ctbau = HI32(physAddr);
-	// prdt follows after command table
+	for (int i = 0; i < fSlotCount; i++) {
+		fCommandList[i].ctba  = LO32(physAddr);
+		fCommandList[i].ctbau = HI32(physAddr);
+		physAddr += COMMAND_TABLE_SIZE;
+	}
+	// every prdt follows after its command table
 
 	// disable transitions to partial or slumber state
 	fRegs->sctl |= 0x300;
@@ -138,6 +153,12 @@ AHCIPort::Init2()
 {
 	TRACE("AHCIPort::Init2 port %d\n", fIndex);
 
+	// completed requests are reported to the SCSI layer from its service
+	// thread, as that cannot be done from the interrupt handler
+	status_t status = gSCSI->alloc_dpc(&fDPC);
+	if (status < B_OK)
+		return status;
+
 	// start DMA engine
 	fRegs->cmd |= PORT_CMD_ST;
 
@@ -159,6 +180,9 @@ AHCIPort::Init2()
 
 	fDevicePresent = (fRegs->ssts & 0xf) == 0x3;
 
+	fTimer.user_data = this;
+	add_timer(&fTimer, &TimeoutHandler, 1000000, B_PERIODIC_TIMER);
+
 	return B_OK;
 }
 
@@ -168,6 +192,9 @@ AHCIPort::Uninit()
 {
 	TRACE("AHCIPort::Uninit port %d\n", fIndex);
 
+	if (fTimer.user_data != NULL)
+		cancel_timer(&fTimer);
+
 	// disable FIS receive
 	fRegs->cmd &= ~PORT_CMD_FER;
 
@@ -198,6 +225,9 @@ AHCIPort::Uninit()
 	fRegs->fbu  = 0;
 
 	delete_area(fArea);
+
+	if (fDPC != NULL)
+		gSCSI->free_dpc(fDPC);
 }
 
 
@@ -332,23 +362,37 @@ AHCIPort::Interrupt()
 	uint32 is = fRegs->is;
 	fRegs->is = is; // clear interrupts
 
-	if (is & PORT_INT_ERROR) {
+	if (is & PORT_INT_ERROR)
 		InterruptErrorHandler(is);
-		return;
-	}
 
+	acquire_spinlock(&fSpinlock);
+
+	// The registers must be read with the lock held, or a slot issued in
+	// the mean time would look finished already.
 	uint32 ci = fRegs->ci;
+	uint32 sact = fRegs->sact;
 
 	RWTRACE("[%lld] %ld AHCIPort::Interrupt port %d, fCommandsActive 0x%08lx, "
-		"is 0x%08lx, ci 0x%08lx\n", system_time(), find_thread(NULL),
-		fIndex, fCommandsActive, is, ci);
+		"is 0x%08lx, ci 0x%08lx, sact 0x%08lx\n", system_time(),
+		find_thread(NULL), fIndex, fCommandsActive, is, ci, sact);
+
+	// Everything that is neither issued nor active anymore is done; polled
+	// requests are collected by their issuer.
+	uint32 done = fCommandsActive & ~(ci | sact) & ~fPolledSlots;
+	fCommandsActive &= ~done;
+	fQueuedActive &= ~done;
+	fCompletedSlots |= done;
+
+	bool schedule = done != 0
+		|| (fError && (fCommandsActive & ~fPolledSlots) != 0);
+	bool notify = fCommandsActive == 0 || fError;
 
-	acquire_spinlock(&fSpinlock);
-	if ((fCommandsActive & 1) && !(ci & 1)) {
-		fCommandsActive &= ~1;
-		release_sem_etc(fResponseSem, 1, B_DO_NOT_RESCHEDULE);
-	}
 	release_spinlock(&fSpinlock);
+
+	if (notify)
+		fIdleCondition.NotifyAll();
+	if (schedule)
+		gSCSI->schedule_dpc(fController->fSCSIBus, fDPC, &CompletionDPC, this);
 }
 
 
@@ -376,6 +420,8 @@ AHCIPort::InterruptErrorHandler(uint32 is)
 		if (!fTestUnitReadyActive)
 			TRACE("Task File Error\n");
 
+		fErrorTfd = fRegs->tfd;
+
 		fResetPort = true;
 		fError = true;
 	}
@@ -418,14 +464,8 @@ AHCIPort::InterruptErrorHandler(uint32 is)
 		fResetPort = true;
 	}
 
-	if (fError) {
-		acquire_spinlock(&fSpinlock);
-		if ((fCommandsActive & 1)) {
-			fCommandsActive &= ~1;
-			release_sem_etc(fResponseSem, 1, B_DO_NOT_RESCHEDULE);
-		}
-		release_spinlock(&fSpinlock);
-	}
+	if (fError && (is & PORT_INT_TFE) == 0)
+		fErrorTfd = ATA_ERR;
 }
 
 
@@ -496,41 +536,292 @@ AHCIPort::FillPrdTable(volatile prd *prdTable, int *prdCount, int prdMax,
 }
 
 
+int
+AHCIPort::AllocateSlot()
+{
+	for (int i = 0; i < fSlotCount; i++) {
+		if ((fSlotsUsed & (1 << i)) == 0) {
+			fSlotsUsed |= 1 << i;
+			return i;
+		}
+	}
+	return -1;
+}
+
+
 void
-AHCIPort::StartTransfer()
+AHCIPort::FreeSlot(int slot)
 {
-	acquire_sem(fRequestSem);
+	cpu_status cpu = disable_interrupts();
+	acquire_spinlock(&fSpinlock);
+	fRequests[slot] = NULL;
+	fSlotsUsed &= ~(1 << slot);
+	release_spinlock(&fSpinlock);
+	restore_interrupts(cpu);
 }
 
 
 status_t
-AHCIPort::WaitForTransfer(int *tfd, bigtime_t timeout)
+AHCIPort::PrepareSlot(int slot, sata_request *request, bool isWrite)
 {
-	status_t result = acquire_sem_etc(fResponseSem, 1, B_RELATIVE_TIMEOUT,
-		timeout);
-	if (result < B_OK) {
-		cpu_status cpu = disable_interrupts();
-		acquire_spinlock(&fSpinlock);
-		fCommandsActive &= ~1;
-		release_spinlock(&fSpinlock);
-		restore_interrupts(cpu);
+	volatile command_list_entry *command = &fCommandList[slot];
+	volatile command_table *table = CommandTable(slot);
+	int prdEntrys;
+	status_t status = B_OK;
 
-		result = B_TIMED_OUT;
-	} else if (fError) {
-		*tfd = fRegs->tfd;
-		result = B_ERROR;
-		fError = false;
-	} else {
-		*tfd = fRegs->tfd;
+	if (request->ccb() && request->ccb()->data_length) {
+		status = FillPrdTable(PrdTable(slot), &prdEntrys,
+			PRD_TABLE_ENTRY_COUNT, request->ccb()->sg_list,
+			request->ccb()->sg_count, request->ccb()->data_length);
+	} else if (request->data() && request->size()) {
+		status = FillPrdTable(PrdTable(slot), &prdEntrys,
+			PRD_TABLE_ENTRY_COUNT, request->data(), request->size());
+	} else
+		prdEntrys = 0;
+
+	if (status != B_OK)
+		return status;
+
+	FLOW("slot %d, prdEntrys %d\n", slot, prdEntrys);
+
+	command->prdtl_flags_cfl = 0;
+	command->cfl = 5; // 20 bytes, length in DWORDS
+	memcpy((char *)table->cfis, request->fis(), 20);
+
+	if (request->is_queued()) {
+		// the tag is the command slot
+		table->cfis[12] = slot << 3;
+	}
+
+	if (request->is_atapi()) {
+		// ATAPI PACKET is a 12 or 16 byte SCSI command
+		memset((char *)table->acmd, 0, 32);
+		memcpy((char *)table->acmd, request->ccb()->cdb,
+			request->ccb()->cdb_length);
+		command->a = 1;
 	}
-	return result;
+
+	if (isWrite)
+		command->w = 1;
+	command->prdtl = prdEntrys;
+	command->prdbc = 0;
+
+	fRequests[slot] = request;
+	return B_OK;
 }
 
 
 void
-AHCIPort::FinishTransfer()
+AHCIPort::IssueSlot(int slot, bool isQueued)
+{
+	cpu_status cpu = disable_interrupts();
+	acquire_spinlock(&fSpinlock);
+
+	fIssueTime[slot] = system_time();
+	fCommandsActive |= 1 << slot;
+	if (isQueued) {
+		fQueuedActive |= 1 << slot;
+		fRegs->sact = 1 << slot;
+	}
+	fRegs->ci = 1 << slot;
+	FlushPostedWrites();
+
+	release_spinlock(&fSpinlock);
+	restore_interrupts(cpu);
+}
+
+
+/*static*/ void
+AHCIPort::CompletionDPC(void *cookie)
+{
+	((AHCIPort *)cookie)->FinishRequests();
+}
+
+
+/*static*/ int32
+AHCIPort::TimeoutHandler(timer *timer)
+{
+	AHCIPort *port = (AHCIPort *)timer->user_data;
+	bigtime_t now = system_time();
+
+	acquire_spinlock(&port->fSpinlock);
+
+	uint32 active = port->fCommandsActive & ~port->fPolledSlots;
+	bool timedOut = false;
+	for (int i = 0; i < port->fSlotCount; i++) {
+		if ((active & (1 << i)) != 0
+			&& now - port->fIssueTime[i] > kCommandTimeout)
+			timedOut = true;
+	}
+	if (timedOut)
+		port->fTimedOut = true;
+
+	release_spinlock(&port->fSpinlock);
+
+	if (timedOut) {
+		gSCSI->schedule_dpc(port->fController->fSCSIBus, port->fDPC,
+			&CompletionDPC, port);
+	}
+	return B_HANDLED_INTERRUPT;
+}
+
+
+/*!	Reports all requests the interrupt handler collected as done to the
+	SCSI layer, and starts the error recovery if needed.
+	Runs in the service thread of the SCSI bus.
+*/
+void
+AHCIPort::FinishRequests()
+{
+	MutexLocker locker(fExecutionLock);
+	FinishRequestsLocked();
+}
+
+
+void
+AHCIPort::FinishRequestsLocked()
+{
+	cpu_status cpu = disable_interrupts();
+	acquire_spinlock(&fSpinlock);
+
+	uint32 done = fCompletedSlots;
+	fCompletedSlots = 0;
+	bool recover = (fError || fTimedOut)
+		&& (fCommandsActive & ~fPolledSlots) != 0;
+
+	release_spinlock(&fSpinlock);
+	restore_interrupts(cpu);
+
+	for (int slot = 0; slot < fSlotCount; slot++) {
+		if ((done & (1 << slot)) == 0)
+			continue;
+
+		sata_request *request = fRequests[slot];
+		size_t bytesTransfered = fCommandList[slot].prdbc;
+		int tfd = request->is_queued() ? 0 : fRegs->tfd;
+			// a queued command can only fail through the error handler
+
+		FreeSlot(slot);
+		request->finish(tfd, bytesTransfered);
+	}
+
+	if (recover)
+		RecoverFromError();
+	else if (fResetPort && fCommandsActive == 0) {
+		fResetPort = false;
+		ResetPort();
+	}
+}
+
+
+/*!	Called with the execution lock held when a command failed or timed out.
+	The port is reset, which aborts all outstanding commands. With native
+	command queuing, the device's NCQ error log tells which command failed;
+	all others are resubmitted.
+*/
+void
+AHCIPort::RecoverFromError()
+{
+	cpu_status cpu = disable_interrupts();
+	acquire_spinlock(&fSpinlock);
+
+	uint32 outstanding = fCommandsActive & ~fPolledSlots;
+	uint32 queued = fQueuedActive & outstanding;
+	bool timedOut = fTimedOut;
+	int tfd = fErrorTfd;
+
+	fCommandsActive &= ~outstanding;
+	fQueuedActive &= ~outstanding;
+	fError = false;
+	fTimedOut = false;
+	fResetPort = false;
+
+	release_spinlock(&fSpinlock);
+	restore_interrupts(cpu);
+
+	TRACE("AHCIPort::RecoverFromError port %d, outstanding 0x%08lx, queued "
+		"0x%08lx, timeout %d\n", fIndex, outstanding, queued, timedOut);
+
+	// stopping the DMA engine clears CI and SActive
+	ResetPort(timedOut);
+
+	// release the slots first, reading the error log needs one of them
+	sata_request *requests[32];
+	for (int slot = 0; slot < fSlotCount; slot++) {
+		if ((outstanding & (1 << slot)) == 0)
+			continue;
+
+		requests[slot] = fRequests[slot];
+		FreeSlot(slot);
+	}
+
+	int failedSlot = -1;
+	if (!timedOut) {
+		if (queued != 0) {
+			if (ReadNCQErrorLog(&failedSlot, &tfd) != B_OK)
+				failedSlot = -1;
+		} else {
+			// there can only be a single non-queued command
+			for (int i = 0; i < fSlotCount; i++) {
+				if ((outstanding & (1 << i)) != 0)
+					failedSlot = i;
+			}
+		}
+	}
+
+	if ((tfd & (ATA_ERR | ATA_DF)) == 0)
+		tfd |= ATA_ERR;
+
+	for (int slot = 0; slot < fSlotCount; slot++) {
+		if ((outstanding & (1 << slot)) == 0)
+			continue;
+
+		sata_request *request = requests[slot];
+		if (slot == failedSlot)
+			request->finish(tfd, 0);
+		else if (timedOut || failedSlot < 0) {
+			// we don't know which one failed, let the upper layers retry
+			request->abort();
+		} else {
+			// the device dropped it along with the failed command
+			gSCSI->resubmit(request->ccb());
+			delete request;
+		}
+	}
+}
+
+
+/*!	Reads the NCQ command error log (log page 10h) that identifies the
+	queued command which failed; the device doesn't accept any other queued
+	commands until this has been done.
+*/
+status_t
+AHCIPort::ReadNCQErrorLog(int *failedSlot, int *tfd)
 {
-	release_sem(fRequestSem);
+	uint8 log[512];
+
+	sata_request request;
+	request.set_data(log, sizeof(log));
+	request.set_ata48_cmd(0x2f, 0x10, 1); // Read Log Ext
+	ExecutePolledRequestLocked(&request, false);
+	request.wait_for_completition();
+
+	if (request.completition_status() & ATA_ERR) {
+		TRACE("AHCIPort::ReadNCQErrorLog port %d: reading log failed\n",
+			fIndex);
+		return B_ERROR;
+	}
+
+	if ((log[0] & 0x80) != 0) {
+		// the error was caused by a non-queued command
+		return B_ERROR;
+	}
+
+	*failedSlot = log[0] & 0x1f;
+	*tfd = log[2] | (log[3] << 8);
+	TRACE("AHCIPort::ReadNCQErrorLog port %d: tag %d failed, status 0x%02x, "
+		"error 0x%02x\n", fIndex, *failedSlot, log[2], log[3]);
+	return B_OK;
 }
 
 
@@ -593,7 +884,7 @@ AHCIPort::ScsiInquiry(scsi_ccb *request)
 	scsiData.term_iop = false;
 	scsiData.additional_length = sizeof(scsiData) - 4;
 	scsiData.soft_reset = false;
-	scsiData.cmd_queue = false;
+	scsiData.cmd_queue = fUseNCQ;
 	scsiData.linked = false;
 	scsiData.sync = false;
 	scsiData.write_bus16 = true;
@@ -619,6 +910,14 @@ AHCIPort::ScsiInquiry(scsi_ccb *request)
 			"sectors48 %llu, size %llu\n",
 			lba, lba48, fUse48BitCommands, sectors, sectors48,
 			fSectorCount * fSectorSize);
+
+		// FPDMA commands always use 48 bit addressing
+		fUseNCQ = (fController->fRegs->cap & CAP_SNCQ) != 0
+			&& ataData.ncq_supported && fUse48BitCommands;
+		fQueueDepth = fUseNCQ
+			? min_c(ataData.max_queue_depth_minus_one + 1, fSlotCount) : 1;
+		TRACE("NCQ %s, queue depth %d\n", fUseNCQ ? "enabled" : "disabled",
+			fQueueDepth);
 	}
 
 #if 0
@@ -730,9 +1029,18 @@ AHCIPort::ScsiReadWrite(scsi_ccb *request, uint64 lba, size_t sectorCount,
 		TRACE("out of memory when allocating read/write request\n");
 		request->subsys_status = SCSI_REQ_ABORTED;
 		gSCSI->finished(request, 1);
+		return;
 	}
 
-	if (fUse48BitCommands) {
+	if (fUseNCQ) {
+		if (sectorCount > 65536) {
+			panic("ahci: ScsiReadWrite length too large, %lu sectors",
+				sectorCount);
+		}
+		if (lba > MAX_SECTOR_LBA_48)
+			panic("achi: ScsiReadWrite position too large for 48-bit LBA\n");
+		sreq->set_fpdma_cmd(isWrite ? 0x61 : 0x60, lba, sectorCount);
+	} else if (fUse48BitCommands) {
 		if (sectorCount > 65536) {
 			panic("ahci: ScsiReadWrite length too large, %lu sectors",
 				sectorCount);
@@ -754,97 +1062,206 @@ AHCIPort::ScsiReadWrite(scsi_ccb *request, uint64 lba, size_t sectorCount,
 }
 
 
+/*!	Waits until the port has no active commands anymore. The caller must
+	hold the execution lock, so that no new commands are issued. Since the
+	completion DPC cannot get that lock either, errors of the outstanding
+	commands are recovered from here.
+*/
+void
+AHCIPort::WaitForIdle()
+{
+	while (true) {
+		ConditionVariableEntry entry;
+
+		cpu_status cpu = disable_interrupts();
+		acquire_spinlock(&fSpinlock);
+
+		bool idle = fCommandsActive == 0;
+		bool recover = !idle && (fError || fTimedOut);
+		if (!idle && !recover)
+			fIdleCondition.Add(&entry);
+
+		release_spinlock(&fSpinlock);
+		restore_interrupts(cpu);
+
+		if (idle)
+			return;
+
+		if (recover)
+			RecoverFromError();
+		else {
+			// the timeout handler doesn't notify us
+			entry.Wait(B_RELATIVE_TIMEOUT, 100000);
+		}
+	}
+}
+
+
 void
 AHCIPort::ExecuteSataRequest(sata_request *request, bool isWrite)
 {
 	FLOW("ExecuteAtaRequest port %d\n", fIndex);
 
-	StartTransfer();
+	if (request->ccb() == NULL) {
+		ExecutePolledRequest(request, isWrite);
+		return;
+	}
 
-	int prdEntrys;
+	scsi_ccb *ccb = request->ccb();
+	bool isQueued = request->is_queued();
 
-	if (request->ccb() && request->ccb()->data_length) {
-		FillPrdTable(fPRDTable, &prdEntrys, PRD_TABLE_ENTRY_COUNT,
-			request->ccb()->sg_list, request->ccb()->sg_count,
-			request->ccb()->data_length);
-	} else if (request->data() && request->size()) {
-		FillPrdTable(fPRDTable, &prdEntrys, PRD_TABLE_ENTRY_COUNT,
-			request->data(), request->size());
-	} else
-		prdEntrys = 0;
+	// a polled request holds the lock until it is done
+	MutexLocker locker(fExecutionLock);
 
-	FLOW("prdEntrys %d\n", prdEntrys);
+	cpu_status cpu = disable_interrupts();
+	acquire_spinlock(&fSpinlock);
 
-	fCommandList->prdtl_flags_cfl = 0;
-	fCommandList->cfl = 5; // 20 bytes, length in DWORDS
-	memcpy((char *)fCommandTable->cfis, request->fis(), 20);
+	// Queued commands may run alongside each other, but never together with
+	// a non-queued one.
+	int slot = -1;
+	int slotsUsed = count_bits_set(fSlotsUsed);
+	bool queueFull = false;
+	if (isQueued) {
+		if (slotsUsed >= fQueueDepth)
+			queueFull = true;
+		else if ((fCommandsActive & ~fQueuedActive) == 0)
+			slot = AllocateSlot();
+	} else if (fCommandsActive == 0)
+		slot = AllocateSlot();
 
-	fTestUnitReadyActive = request->is_test_unit_ready();
-	if (request->is_atapi()) {
-		// ATAPI PACKET is a 12 or 16 byte SCSI command
-		memset((char *)fCommandTable->acmd, 0, 32);
-		memcpy((char *)fCommandTable->acmd, request->ccb()->cdb,
-			request->ccb()->cdb_length);
-		fCommandList->a = 1;
+	release_spinlock(&fSpinlock);
+	restore_interrupts(cpu);
+
+	if (queueFull) {
+		// lets the SCSI layer learn our queue depth, and requeue the request
+		delete request;
+		ccb->subsys_status = SCSI_REQ_CMP_ERR;
+		ccb->device_status = SCSI_STATUS_QUEUE_FULL;
+		gSCSI->finished(ccb, slotsUsed + 1);
+		return;
+	}
+	if (slot < 0) {
+		// retried as soon as one of the running requests is finished
+		delete request;
+		gSCSI->requeue(ccb, false);
+		return;
 	}
 
-	if (isWrite)
-		fCommandList->w = 1;
-	fCommandList->prdtl = prdEntrys;
-	fCommandList->prdbc = 0;
+	if (PrepareSlot(slot, request, isWrite) != B_OK) {
+		FreeSlot(slot);
+		request->abort();
+		return;
+	}
+
+	fTestUnitReadyActive = request->is_test_unit_ready();
 
-	if (wait_until_clear(&fRegs->tfd, ATA_BSY | ATA_DRQ, 1000000) < B_OK) {
+	if (!isQueued
+		&& wait_until_clear(&fRegs->tfd, ATA_BSY | ATA_DRQ, 1000000) < B_OK) {
 		TRACE("ExecuteAtaRequest port %d: device is busy\n", fIndex);
 		ResetPort();
-		FinishTransfer();
+		FreeSlot(slot);
+		request->abort();
+		return;
+	}
+
+	IssueSlot(slot, isQueued);
+}
+
+
+/*!	Executes a request without a SCSI ccb, and waits for its completion.
+	Those are only used while detecting the device, and during error
+	recovery. No other command may run alongside, so the port is drained
+	first, and the execution lock keeps new commands from being issued until
+	the polled one is done.
+*/
+void
+AHCIPort::ExecutePolledRequest(sata_request *request, bool isWrite)
+{
+	MutexLocker locker(fExecutionLock);
+	ExecutePolledRequestLocked(request, isWrite);
+}
+
+
+void
+AHCIPort::ExecutePolledRequestLocked(sata_request *request, bool isWrite)
+{
+	WaitForIdle();
+
+	int slot = -1;
+	for (int attempt = 0; attempt < 2 && slot < 0; attempt++) {
+		if (attempt > 0) {
+			// all slots belong to finished requests the DPC could not
+			// collect, as we hold the lock
+			FinishRequestsLocked();
+		}
+
+		cpu_status cpu = disable_interrupts();
+		acquire_spinlock(&fSpinlock);
+
+		slot = AllocateSlot();
+		if (slot >= 0)
+			fPolledSlots |= 1 << slot;
+
+		release_spinlock(&fSpinlock);
+		restore_interrupts(cpu);
+	}
+
+	if (slot < 0) {
 		request->abort();
 		return;
 	}
 
+	if (PrepareSlot(slot, request, isWrite) != B_OK
+		|| wait_until_clear(&fRegs->tfd, ATA_BSY | ATA_DRQ, 1000000) < B_OK) {
+		TRACE("ExecutePolledRequest port %d: device is busy\n", fIndex);
+		ResetPort();
+
+		cpu_status cpu = disable_interrupts();
+		acquire_spinlock(&fSpinlock);
+		fPolledSlots &= ~(1 << slot);
+		release_spinlock(&fSpinlock);
+		restore_interrupts(cpu);
+
+		FreeSlot(slot);
+		request->abort();
+		return;
+	}
+
+	IssueSlot(slot, false);
+
+	bigtime_t timeout = system_time() + kCommandTimeout;
+	while ((fRegs->ci & (1 << slot)) != 0 && !fError) {
+		if (system_time() > timeout)
+			break;
+		snooze(100);
+	}
+
 	cpu_status cpu = disable_interrupts();
 	acquire_spinlock(&fSpinlock);
-	fCommandsActive |= 1;
-	fRegs->ci = 1;
-	FlushPostedWrites();
-	release_spinlock(&fSpinlock);
-	restore_interrupts(cpu);
 
-	int tfd;
-	status_t status = WaitForTransfer(&tfd, 20000000);
+	bool timedOut = (fRegs->ci & (1 << slot)) != 0 && !fError;
+	bool failed = fError;
+	int tfd = failed ? fErrorTfd : fRegs->tfd;
+	fError = false;
+	fCommandsActive &= ~(1 << slot);
+	fPolledSlots &= ~(1 << slot);
 
-	FLOW("tfd %#x\n", tfd);
-	FLOW("prdbc %ld\n", fCommandList->prdbc);
-	FLOW("ci   0x%08lx\n", fRegs->ci);
-	FLOW("is   0x%08lx\n", fRegs->is);
-	FLOW("serr 0x%08lx\n", fRegs->serr);
-
-/*
-	TRACE("ci   0x%08lx\n", fRegs->ci);
-	TRACE("ie   0x%08lx\n", fRegs->ie);
-	TRACE("is   0x%08lx\n", fRegs->is);
-	TRACE("cmd  0x%08lx\n", fRegs->cmd);
-	TRACE("ssts 0x%08lx\n", fRegs->ssts);
-	TRACE("sctl 0x%08lx\n", fRegs->sctl);
-	TRACE("serr 0x%08lx\n", fRegs->serr);
-	TRACE("sact 0x%08lx\n", fRegs->sact);
-	TRACE("tfd  0x%08lx\n", fRegs->tfd);
-*/
+	release_spinlock(&fSpinlock);
+	restore_interrupts(cpu);
 
-	if (fResetPort || status == B_TIMED_OUT) {
+	if (failed || timedOut || fResetPort) {
 		fResetPort = false;
 		ResetPort();
 	}
 
-	size_t bytesTransfered = fCommandList->prdbc;
-
-	FinishTransfer();
+	size_t bytesTransfered = fCommandList[slot].prdbc;
+	FreeSlot(slot);
 
-	if (status == B_TIMED_OUT) {
-		TRACE("ExecuteAtaRequest port %d: device timeout\n", fIndex);
+	if (timedOut) {
+		TRACE("ExecutePolledRequest port %d: device timeout\n", fIndex);
 		request->abort();
-	} else {
+	} else
 		request->finish(tfd, bytesTransfered);
-	}
 }
 
 
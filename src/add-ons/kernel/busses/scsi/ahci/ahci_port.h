@@ -5,6 +5,9 @@
 #ifndef _AHCI_PORT_H
 #define _AHCI_PORT_H
 
+#include <condition_variable.h>
+#include <lock.h>
+
 #include "ahci_defs.h"
 
 class AHCIController;
@@ -37,6 +40,10 @@ private:
 	void		ScsiSynchronizeCache(scsi_ccb *request);
 
 	void		ExecuteSataRequest(sata_request *request, bool isWrite = false);
+	void		ExecutePolledRequest(sata_request *request, bool isWrite);
+	void		ExecutePolledRequestLocked(sata_request *request,
+					bool isWrite);
+	void		WaitForIdle();
 
 	void		ResetDevice();
 	status_t	ResetPort(bool forceDeviceReset = false);
@@ -44,9 +51,20 @@ private:
 	void		FlushPostedWrites();
 	void		DumpD2HFis();
 
-	void		StartTransfer();
-	status_t	WaitForTransfer(int *tfd, bigtime_t timeout);
-	void		FinishTransfer();
+	int			AllocateSlot();
+	void		FreeSlot(int slot);
+	status_t	PrepareSlot(int slot, sata_request *request, bool isWrite);
+	void		IssueSlot(int slot, bool isQueued);
+
+	static void	CompletionDPC(void *cookie);
+	static int32 TimeoutHandler(timer *timer);
+	void		FinishRequests();
+	void		FinishRequestsLocked();
+	void		RecoverFromError();
+	status_t	ReadNCQErrorLog(int *failedSlot, int *tfd);
+
+	volatile command_table *CommandTable(int slot);
+	volatile prd *	PrdTable(int slot);
 
 
 //	uint8 *		SetCommandFis(volatile command_list_entry *cmd, volatile fis *fis, const void *data, size_t dataSize);
@@ -59,10 +77,21 @@ private:
 	volatile ahci_port *	fRegs;
 	area_id					fArea;
 	spinlock						fSpinlock;
+	mutex							fExecutionLock;
+	ConditionVariable				fIdleCondition;
+	int								fSlotCount;
+	int								fQueueDepth;
+	uint32							fSlotsUsed;
 	volatile uint32					fCommandsActive;
-	sem_id							fRequestSem;
-	sem_id							fResponseSem;
+	uint32							fQueuedActive;
+	uint32							fPolledSlots;
+	uint32							fCompletedSlots;
+	sata_request *					fRequests[COMMAND_LIST_ENTRY_COUNT];
+	bigtime_t						fIssueTime[COMMAND_LIST_ENTRY_COUNT];
+	scsi_dpc_cookie					fDPC;
+	timer							fTimer;
 	bool							fDevicePresent;
+	bool							fUseNCQ;
 	bool							fUse48BitCommands;
 	uint32							fSectorSize;
 	uint64							fSectorCount;
@@ -70,14 +99,32 @@ private:
 	bool							fTestUnitReadyActive;
 	bool							fResetPort;
 	bool							fError;
+	bool							fTimedOut;
+	int								fErrorTfd;
 	bool							fTrim;
 
 	volatile fis *					fFIS;
 	volatile command_list_entry *	fCommandList;
-	volatile command_table *		fCommandTable;
-	volatile prd *					fPRDTable;
+	volatile uint8 *				fCommandTables;
+		// one command table, followed by its PRD table, per slot
 };
 
+inline volatile command_table *
+AHCIPort::CommandTable(int slot)
+{
+	return (volatile command_table *)(fCommandTables
+		+ slot * COMMAND_TABLE_SIZE);
+}
+
+
+inline volatile prd *
+AHCIPort::PrdTable(int slot)
+{
+	return (volatile prd *)(fCommandTables + slot * COMMAND_TABLE_SIZE
+		+ sizeof(command_table));
+}
+
+
 inline void
 AHCIPort::FlushPostedWrites()
 {
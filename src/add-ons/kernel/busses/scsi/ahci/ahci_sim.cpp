@@ -20,6 +20,7 @@
 static void
 ahci_set_scsi_bus(scsi_sim_cookie cookie, scsi_bus bus)
 {
+	static_cast<AHCIController *>(cookie)->SetSCSIBus(bus);
 }
 
 
@@ -68,11 +69,11 @@ ahci_path_inquiry(scsi_sim_cookie cookie, scsi_path_inquiry *info)
 	memset(info, 0, sizeof(*info));
 	info->version_num = 1;
 	// supports tagged requests and soft reset
-	info->hba_inquiry = 0; // SCSI_PI_TAG_ABLE | SCSI_PI_SOFT_RST;
+	info->hba_inquiry = SCSI_PI_TAG_ABLE; // | SCSI_PI_SOFT_RST;
 	// controller is 32, devices are 0 to 31
 	info->initiator_id = 32;
 	// adapter command queue size
-	info->hba_queue_size = 1;
+	info->hba_queue_size = static_cast<AHCIController *>(cookie)->QueueSize();
 
 	return SCSI_REQ_CMP;
 }
@@ -14,6 +14,7 @@ sata_request::sata_request()
 	:
 	fCcb(NULL),
 	fIsATAPI(false),
+	fIsQueued(false),
 	fCompletionSem(create_sem(0, "sata completion")),
 	fCompletionStatus(0),
 	fData(NULL),
@@ -26,6 +27,7 @@ sata_request::sata_request(scsi_ccb *ccb)
 	:
 	fCcb(ccb),
 	fIsATAPI(false),
+	fIsQueued(false),
 	fCompletionSem(-1),
 	fCompletionStatus(0),
 	fData(NULL),
@@ -88,6 +90,20 @@ sata_request::set_ata48_cmd(uint8 command, uint64 lba, uint16 sectorCount)
 }
 
 
+/*!	Native command queuing (READ/WRITE FPDMA QUEUED): the sector count moves
+	to the features register, and the tag is filled in by the port once a
+	command slot has been assigned.
+*/
+void
+sata_request::set_fpdma_cmd(uint8 command, uint64 lba, uint16 sectorCount)
+{
+	set_ata48_cmd(command, lba, 0);
+	fIsQueued = true;
+	fFis[3] = sectorCount & 0xff;
+	fFis[11] = (sectorCount >> 8) & 0xff;
+}
+
+
 void
 sata_request::set_atapi_cmd(size_t transferLength)
 {
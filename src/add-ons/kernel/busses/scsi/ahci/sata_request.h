@@ -20,9 +20,11 @@ public:
 	void			set_ata_cmd(uint8 command);
 	void			set_ata28_cmd(uint8 command, uint32 lba, uint8 sectorCount);
 	void			set_ata48_cmd(uint8 command, uint64 lba, uint16 sectorCount);
+	void			set_fpdma_cmd(uint8 command, uint64 lba, uint16 sectorCount);
 
 	void			set_atapi_cmd(size_t transferLength);
 	bool 			is_atapi();
+	bool			is_queued();
 	bool			is_test_unit_ready();
 
 	scsi_ccb *		ccb();
@@ -39,6 +41,7 @@ private:
 	scsi_ccb *		fCcb;
 	uint8			fFis[20];
 	bool			fIsATAPI;
+	bool			fIsQueued;
 	sem_id			fCompletionSem;
 	int				fCompletionStatus;
 	void *			fData;
@@ -67,6 +70,13 @@ sata_request::is_atapi()
 }
 
 
+inline bool
+sata_request::is_queued()
+{
+	return fIsQueued;
+}
+
+
 inline bool
 sata_request::is_test_unit_ready()
 {
@@ -0,0 +1,774 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+/*!	Driver for virtio block devices, the paravirtualized disks of KVM/QEMU
+	and other hypervisors.
+
+	The requests the I/O scheduler hands out are put into the device's
+	request queue as they come, and completed from the interrupt handler;
+	the device works on all of them concurrently. With indirect descriptors,
+	every request only occupies a single slot of the queue, and with event
+	indices, the device is only notified and only interrupts when the other
+	side isn't busy working on the queue anyway.
+*/
+
+
+#include "virtio_block.h"
+
+#include <new>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <util/AutoLock.h>
+
+#include "dma_resources.h"
+#include "IORequest.h"
+#include "IOSchedulerSimple.h"
+
+
+//#define TRACE_VIRTIO_BLOCK
+#ifdef TRACE_VIRTIO_BLOCK
+#	define TRACE(x...) dprintf("virtio_block: " x)
+#else
+#	define TRACE(x...) ;
+#endif
+#define ERROR(x...) dprintf("virtio_block: " x)
+
+
+#define VIRTIO_BLOCK_ID_GENERATOR	"virtio_block/id"
+#define VIRTIO_BLOCK_PRETTY_NAME	"Virtio Block Device"
+
+static const uint32 kMaxSegmentCount = 32;
+static const uint32 kMaxRequestCount = 64;
+static const uint32 kBounceBufferCount = 8;
+
+
+static device_manager_info* sDeviceManager;
+static virtio_pci_module_info* sVirtio;
+
+
+static bool
+is_virtio_block(const pci_info& info)
+{
+	return info.vendor_id == VIRTIO_PCI_VENDOR_ID
+		&& info.device_id >= VIRTIO_PCI_DEVICE_ID_MIN
+		&& info.device_id <= VIRTIO_PCI_DEVICE_ID_MAX
+		&& info.u.h0.subsystem_id == VIRTIO_DEVICE_TYPE_BLOCK;
+}
+
+
+static status_t
+status_to_error(uint8 status)
+{
+	switch (status) {
+		case VIRTIO_BLOCK_S_OK:
+			return B_OK;
+		case VIRTIO_BLOCK_S_UNSUPP:
+			return B_NOT_SUPPORTED;
+		default:
+			return B_IO_ERROR;
+	}
+}
+
+
+//	#pragma mark - requests
+
+
+static virtio_block_request*
+get_request(virtio_block_driver_info* info)
+{
+	acquire_sem(info->request_sem);
+
+	InterruptsSpinLocker locker(info->lock);
+
+	virtio_block_request* request = info->free_requests;
+	info->free_requests = request->next;
+	return request;
+}
+
+
+/*!	Must be called with the lock held. */
+static void
+put_request(virtio_block_driver_info* info, virtio_block_request* request)
+{
+	request->operation = NULL;
+	request->next = info->free_requests;
+	info->free_requests = request;
+
+	release_sem_etc(info->request_sem, 1, B_DO_NOT_RESCHEDULE);
+}
+
+
+/*!	Puts the request into the queue, and notifies the device if needed.
+	The data vectors are placed between the request header and its status.
+*/
+static status_t
+submit_request(virtio_block_driver_info* info, virtio_block_request* request,
+	const generic_io_vec* vecs, uint32 vecCount, bool isWrite)
+{
+	physical_entry vector[kMaxSegmentCount + 2];
+	if (vecCount > info->max_segment_count)
+		return B_BAD_VALUE;
+
+	vector[0].address = request->physical_address;
+	vector[0].size = sizeof(virtio_block_request_header);
+	for (uint32 i = 0; i < vecCount; i++) {
+		vector[i + 1].address = vecs[i].base;
+		vector[i + 1].size = vecs[i].length;
+	}
+	vector[vecCount + 1].address = request->physical_address
+		+ offsetof(virtio_block_request, status);
+	vector[vecCount + 1].size = 1;
+
+	size_t readCount = isWrite ? vecCount + 1 : 1;
+
+	InterruptsSpinLocker locker(info->lock);
+
+	status_t status = sVirtio->queue_request(info->queue, vector, readCount,
+		vecCount + 2 - readCount, request);
+	if (status == B_OK)
+		sVirtio->kick_queue(info->queue);
+
+	return status;
+}
+
+
+static status_t
+do_io(void* cookie, IOOperation* operation)
+{
+	virtio_block_driver_info* info = (virtio_block_driver_info*)cookie;
+
+	// There are as many requests as the DMA resource has buffers, so this
+	// won't have to wait for long, if at all
+	virtio_block_request* request = get_request(info);
+
+	request->header.type = operation->IsWrite()
+		? VIRTIO_BLOCK_T_OUT : VIRTIO_BLOCK_T_IN;
+	request->header.reserved = 0;
+	request->header.sector = operation->Offset() / VIRTIO_BLOCK_SECTOR_SIZE;
+	request->status = VIRTIO_BLOCK_S_IOERR;
+	request->operation = operation;
+
+	status_t status = submit_request(info, request, operation->Vecs(),
+		operation->VecCount(), operation->IsWrite());
+	if (status != B_OK) {
+		ERROR("queuing request failed: %s\n", strerror(status));
+
+		InterruptsSpinLocker locker(info->lock);
+		put_request(info, request);
+		locker.Unlock();
+
+		info->io_scheduler->OperationCompleted(operation, status, 0);
+	}
+
+	return status;
+}
+
+
+static status_t
+flush_cache(virtio_block_driver_info* info)
+{
+	if ((info->features & VIRTIO_BLOCK_F_FLUSH) == 0)
+		return B_OK;
+
+	MutexLocker _(info->flush_lock);
+
+	virtio_block_request* request = get_request(info);
+	request->header.type = VIRTIO_BLOCK_T_FLUSH;
+	request->header.reserved = 0;
+	request->header.sector = 0;
+	request->status = VIRTIO_BLOCK_S_IOERR;
+	request->operation = NULL;
+
+	status_t status = submit_request(info, request, NULL, 0, false);
+	if (status == B_OK) {
+		acquire_sem(info->flush_sem);
+		status = status_to_error(request->status);
+	}
+
+	InterruptsSpinLocker locker(info->lock);
+	put_request(info, request);
+
+	return status;
+}
+
+
+static int32
+virtio_block_interrupt(void* data)
+{
+	virtio_block_driver_info* info = (virtio_block_driver_info*)data;
+
+	uint8 interruptStatus = sVirtio->interrupt_status(info->virtio);
+	if (interruptStatus == 0)
+		return B_UNHANDLED_INTERRUPT;
+	if ((interruptStatus & VIRTIO_INTERRUPT_QUEUE) == 0)
+		return B_HANDLED_INTERRUPT;
+
+	acquire_spinlock(&info->lock);
+
+	do {
+		virtio_block_request* request;
+		while (sVirtio->dequeue(info->queue, (void**)&request, NULL)) {
+			IOOperation* operation = request->operation;
+			if (operation == NULL) {
+				// the flush request is returned by its issuer
+				release_sem_etc(info->flush_sem, 1, B_DO_NOT_RESCHEDULE);
+				continue;
+			}
+
+			status_t status = status_to_error(request->status);
+			put_request(info, request);
+
+			info->io_scheduler->OperationCompleted(operation, status,
+				status == B_OK ? operation->Length() : 0);
+		}
+
+		// Re-enabling the interrupt also tells the device up to which request
+		// we have already seen; anything it finished since then is handled
+		// here without waiting for another interrupt
+	} while (sVirtio->set_queue_interrupt(info->queue, true));
+
+	release_spinlock(&info->lock);
+
+	return B_INVOKE_SCHEDULER;
+}
+
+
+//	#pragma mark - setup
+
+
+static status_t
+init_queue(virtio_block_driver_info* info)
+{
+	status_t status = sVirtio->alloc_queue(info->virtio, 0, &info->queue);
+	if (status != B_OK)
+		return status;
+
+	uint32 queueSize = sVirtio->queue_size(info->queue);
+
+	uint32 segmentCount = kMaxSegmentCount;
+	if ((info->features & VIRTIO_BLOCK_F_SEG_MAX) != 0) {
+		uint32 segmentMax;
+		sVirtio->read_device_config(info->virtio, VIRTIO_BLOCK_CONFIG_SEG_MAX,
+			&segmentMax, sizeof(segmentMax));
+		if (segmentMax > 0)
+			segmentCount = min_c(segmentCount, segmentMax);
+	}
+
+	if ((info->features & VIRTIO_FEATURE_RING_INDIRECT_DESC) != 0
+		&& sVirtio->set_queue_indirect(info->queue, segmentCount + 2)
+			!= B_OK) {
+		info->features &= ~VIRTIO_FEATURE_RING_INDIRECT_DESC;
+	}
+
+	if ((info->features & VIRTIO_FEATURE_RING_INDIRECT_DESC) != 0) {
+		// every request only needs a single descriptor in the ring; one
+		// request is kept for cache flushes
+		info->request_count = min_c(queueSize - 1, kMaxRequestCount);
+	} else {
+		// leave room for at least two requests, including a flush
+		segmentCount = min_c(segmentCount, queueSize / 2 - 2);
+		info->request_count = min_c(queueSize / (segmentCount + 2) - 1,
+			kMaxRequestCount);
+	}
+
+	info->max_segment_count = segmentCount;
+
+	TRACE("queue size %" B_PRIu32 ", %" B_PRIu32 " requests with %" B_PRIu32
+		" segments, indirect %d, event index %d\n", queueSize,
+		info->request_count, segmentCount,
+		(info->features & VIRTIO_FEATURE_RING_INDIRECT_DESC) != 0,
+		(info->features & VIRTIO_FEATURE_RING_EVENT_IDX) != 0);
+	return B_OK;
+}
+
+
+static status_t
+init_requests(virtio_block_driver_info* info)
+{
+	uint32 count = info->request_count + 1;
+	size_t areaSize = (count * sizeof(virtio_block_request) + B_PAGE_SIZE - 1)
+		& ~(size_t)(B_PAGE_SIZE - 1);
+
+	info->requests_area = create_area("virtio block requests",
+		(void**)&info->requests, B_ANY_KERNEL_ADDRESS, areaSize, B_CONTIGUOUS,
+		B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA);
+	if (info->requests_area < 0)
+		return info->requests_area;
+
+	physical_entry entry;
+	get_memory_map(info->requests, areaSize, &entry, 1);
+
+	info->free_requests = NULL;
+	for (uint32 i = 0; i < count; i++) {
+		virtio_block_request* request = &info->requests[i];
+		request->physical_address = entry.address
+			+ i * sizeof(virtio_block_request);
+		request->operation = NULL;
+		request->next = info->free_requests;
+		info->free_requests = request;
+	}
+
+	info->request_sem = create_sem(count, "virtio block requests");
+	if (info->request_sem < 0)
+		return info->request_sem;
+
+	info->flush_sem = create_sem(0, "virtio block flush");
+	if (info->flush_sem < 0)
+		return info->flush_sem;
+
+	return B_OK;
+}
+
+
+static status_t
+init_io_scheduler(virtio_block_driver_info* info)
+{
+	dma_restrictions restrictions;
+	memset(&restrictions, 0, sizeof(restrictions));
+	restrictions.max_segment_count = info->max_segment_count;
+
+	if ((info->features & VIRTIO_BLOCK_F_SIZE_MAX) != 0) {
+		uint32 sizeMax;
+		sVirtio->read_device_config(info->virtio, VIRTIO_BLOCK_CONFIG_SIZE_MAX,
+			&sizeMax, sizeof(sizeMax));
+		if (sizeMax >= info->block_size)
+			restrictions.max_segment_size = sizeMax;
+	}
+
+	info->dma_resource = new(std::nothrow) DMAResource;
+	if (info->dma_resource == NULL)
+		return B_NO_MEMORY;
+
+	status_t status = info->dma_resource->Init(restrictions, info->block_size,
+		info->request_count, kBounceBufferCount);
+	if (status != B_OK)
+		return status;
+
+	info->io_scheduler = new(std::nothrow) IOSchedulerSimple(
+		info->dma_resource);
+	if (info->io_scheduler == NULL)
+		return B_NO_MEMORY;
+
+	status = info->io_scheduler->Init("virtio block");
+	if (status != B_OK)
+		return status;
+
+	info->io_scheduler->SetCallback(do_io, info);
+	return B_OK;
+}
+
+
+static void
+free_driver_info(virtio_block_driver_info* info)
+{
+	if (info->virtio != NULL) {
+		// resets the device and frees the queue
+		sVirtio->uninit_device(info->virtio);
+	}
+
+	delete info->io_scheduler;
+	delete info->dma_resource;
+
+	if (info->flush_sem >= 0)
+		delete_sem(info->flush_sem);
+	if (info->request_sem >= 0)
+		delete_sem(info->request_sem);
+	if (info->requests_area >= 0)
+		delete_area(info->requests_area);
+
+	mutex_destroy(&info->flush_lock);
+	free(info);
+}
+
+
+//	#pragma mark - device module API
+
+
+static status_t
+virtio_block_init_device(void* _info, void** _cookie)
+{
+	*_cookie = _info;
+	return B_OK;
+}
+
+
+static void
+virtio_block_uninit_device(void* _cookie)
+{
+}
+
+
+static status_t
+virtio_block_open(void* _info, const char* path, int openMode, void** _cookie)
+{
+	virtio_block_driver_info* info = (virtio_block_driver_info*)_info;
+
+	if (info->read_only && (openMode & O_RWMASK) != O_RDONLY)
+		return B_READ_ONLY_DEVICE;
+
+	virtio_block_handle* handle
+		= (virtio_block_handle*)malloc(sizeof(virtio_block_handle));
+	if (handle == NULL)
+		return B_NO_MEMORY;
+
+	handle->info = info;
+
+	*_cookie = handle;
+	return B_OK;
+}
+
+
+static status_t
+virtio_block_close(void* cookie)
+{
+	return B_OK;
+}
+
+
+static status_t
+virtio_block_free(void* cookie)
+{
+	free(cookie);
+	return B_OK;
+}
+
+
+static status_t
+virtio_block_read(void* cookie, off_t pos, void* buffer, size_t* _length)
+{
+	virtio_block_handle* handle = (virtio_block_handle*)cookie;
+	size_t length = *_length;
+
+	IORequest request;
+	status_t status = request.Init(pos, (addr_t)buffer, length, false, 0);
+	if (status != B_OK)
+		return status;
+
+	status = handle->info->io_scheduler->ScheduleRequest(&request);
+	if (status != B_OK)
+		return status;
+
+	status = request.Wait(0, 0);
+	if (status == B_OK)
+		*_length = length;
+	else
+		dprintf("virtio_block_read(): request.Wait() returned: %s\n",
+			strerror(status));
+
+	return status;
+}
+
+
+static status_t
+virtio_block_write(void* cookie, off_t pos, const void* buffer,
+	size_t* _length)
+{
+	virtio_block_handle* handle = (virtio_block_handle*)cookie;
+	size_t length = *_length;
+
+	IORequest request;
+	status_t status = request.Init(pos, (addr_t)buffer, length, true, 0);
+	if (status != B_OK)
+		return status;
+
+	status = handle->info->io_scheduler->ScheduleRequest(&request);
+	if (status != B_OK)
+		return status;
+
+	status = request.Wait(0, 0);
+	if (status == B_OK)
+		*_length = length;
+	else
+		dprintf("virtio_block_write(): request.Wait() returned: %s\n",
+			strerror(status));
+
+	return status;
+}
+
+
+static status_t
+virtio_block_io(void* cookie, io_request* request)
+{
+	virtio_block_handle* handle = (virtio_block_handle*)cookie;
+
+	return handle->info->io_scheduler->ScheduleRequest(request);
+}
+
+
+static status_t
+virtio_block_ioctl(void* cookie, uint32 op, void* buffer, size_t length)
+{
+	virtio_block_handle* handle = (virtio_block_handle*)cookie;
+	virtio_block_driver_info* info = handle->info;
+
+	TRACE("ioctl(op = %" B_PRIu32 ")\n", op);
+
+	switch (op) {
+		case B_GET_DEVICE_SIZE:
+		{
+			size_t size = info->capacity * info->block_size;
+			return user_memcpy(buffer, &size, sizeof(size_t));
+		}
+
+		case B_GET_GEOMETRY:
+		{
+			if (buffer == NULL)
+				return B_BAD_VALUE;
+
+			device_geometry geometry;
+			geometry.bytes_per_sector = info->block_size;
+			if (info->capacity > UINT_MAX) {
+				geometry.sectors_per_track = 256;
+				geometry.cylinder_count = info->capacity / (256 * 32);
+				geometry.head_count = 32;
+			} else {
+				geometry.sectors_per_track = 1;
+				geometry.cylinder_count = info->capacity;
+				geometry.head_count = 1;
+			}
+			geometry.device_type = B_DISK;
+			geometry.removable = false;
+			geometry.read_only = info->read_only;
+			geometry.write_once = false;
+
+			return user_memcpy(buffer, &geometry, sizeof(device_geometry));
+		}
+
+		case B_GET_ICON_NAME:
+			return user_strlcpy((char*)buffer, "devices/drive-harddisk",
+				B_FILE_NAME_LENGTH);
+
+		case B_FLUSH_DRIVE_CACHE:
+			return flush_cache(info);
+	}
+
+	return B_DEV_INVALID_IOCTL;
+}
+
+
+//	#pragma mark - driver module API
+
+
+static float
+virtio_block_supports_device(device_node* parent)
+{
+	const char* bus;
+	uint16 vendorID;
+	uint16 deviceID;
+
+	if (sDeviceManager->get_attr_string(parent, B_DEVICE_BUS, &bus, false)
+			!= B_OK
+		|| strcmp(bus, "pci") != 0)
+		return 0.0f;
+
+	if (sDeviceManager->get_attr_uint16(parent, B_DEVICE_VENDOR_ID, &vendorID,
+			false) != B_OK
+		|| sDeviceManager->get_attr_uint16(parent, B_DEVICE_ID, &deviceID,
+			false) != B_OK
+		|| vendorID != VIRTIO_PCI_VENDOR_ID)
+		return 0.0f;
+
+	// the device type is only found in the subsystem ID
+	pci_device_module_info* pci;
+	pci_device* device;
+	pci_info info;
+	sDeviceManager->get_driver(parent, (driver_module_info**)&pci,
+		(void**)&device);
+	pci->get_pci_info(device, &info);
+
+	if (!is_virtio_block(info))
+		return 0.0f;
+
+	TRACE("virtio block device found at %02x:%02x.%x\n", info.bus,
+		info.device, info.function);
+	return 1.0f;
+}
+
+
+static status_t
+virtio_block_register_device(device_node* parent)
+{
+	device_attr attrs[] = {
+		{ B_DEVICE_PRETTY_NAME, B_STRING_TYPE,
+			{ string: VIRTIO_BLOCK_PRETTY_NAME }},
+		{ NULL }
+	};
+
+	return sDeviceManager->register_node(parent,
+		VIRTIO_BLOCK_DRIVER_MODULE_NAME, attrs, NULL, NULL);
+}
+
+
+static status_t
+virtio_block_init_driver(device_node* node, void** _cookie)
+{
+	TRACE("virtio_block_init_driver()\n");
+
+	virtio_block_driver_info* info
+		= (virtio_block_driver_info*)malloc(sizeof(virtio_block_driver_info));
+	if (info == NULL)
+		return B_NO_MEMORY;
+
+	memset(info, 0, sizeof(*info));
+	info->node = node;
+	info->id = -1;
+	info->requests_area = -1;
+	info->request_sem = -1;
+	info->flush_sem = -1;
+	B_INITIALIZE_SPINLOCK(&info->lock);
+	mutex_init(&info->flush_lock, "virtio block flush");
+
+	device_node* parent = sDeviceManager->get_parent_node(node);
+	sDeviceManager->get_driver(parent, (driver_module_info**)&info->pci,
+		(void**)&info->pci_cookie);
+	sDeviceManager->put_node(parent);
+
+	info->pci->get_pci_info(info->pci_cookie, &info->pci_data);
+
+	status_t status = sVirtio->init_device(&info->pci_data, &info->virtio);
+	if (status != B_OK) {
+		info->virtio = NULL;
+		free_driver_info(info);
+		return status;
+	}
+
+	info->features = sVirtio->negotiate_features(info->virtio,
+		VIRTIO_BLOCK_F_SIZE_MAX | VIRTIO_BLOCK_F_SEG_MAX | VIRTIO_BLOCK_F_RO
+			| VIRTIO_BLOCK_F_BLK_SIZE | VIRTIO_BLOCK_F_FLUSH
+			| VIRTIO_FEATURE_RING_INDIRECT_DESC
+			| VIRTIO_FEATURE_RING_EVENT_IDX);
+
+	uint64 sectors;
+	sVirtio->read_device_config(info->virtio, VIRTIO_BLOCK_CONFIG_CAPACITY,
+		&sectors, sizeof(sectors));
+
+	info->block_size = VIRTIO_BLOCK_SECTOR_SIZE;
+	if ((info->features & VIRTIO_BLOCK_F_BLK_SIZE) != 0) {
+		uint32 blockSize;
+		sVirtio->read_device_config(info->virtio, VIRTIO_BLOCK_CONFIG_BLK_SIZE,
+			&blockSize, sizeof(blockSize));
+		if (blockSize >= VIRTIO_BLOCK_SECTOR_SIZE
+			&& (blockSize & (blockSize - 1)) == 0)
+			info->block_size = blockSize;
+	}
+
+	info->capacity = sectors * VIRTIO_BLOCK_SECTOR_SIZE / info->block_size;
+	info->read_only = (info->features & VIRTIO_BLOCK_F_RO) != 0;
+
+	status = init_queue(info);
+	if (status == B_OK)
+		status = init_requests(info);
+	if (status == B_OK)
+		status = init_io_scheduler(info);
+	if (status == B_OK) {
+		status = install_io_interrupt_handler(
+			info->pci_data.u.h0.interrupt_line, &virtio_block_interrupt, info,
+			0);
+	}
+	if (status != B_OK) {
+		ERROR("initializing device failed: %s\n", strerror(status));
+		sVirtio->set_failed(info->virtio);
+		free_driver_info(info);
+		return status;
+	}
+
+	sVirtio->set_driver_ok(info->virtio);
+
+	TRACE("capacity %" B_PRIu64 " blocks of %" B_PRIu32 " bytes%s\n",
+		info->capacity, info->block_size,
+		info->read_only ? ", read-only" : "");
+
+	*_cookie = info;
+	return B_OK;
+}
+
+
+static void
+virtio_block_uninit_driver(void* _cookie)
+{
+	virtio_block_driver_info* info = (virtio_block_driver_info*)_cookie;
+
+	remove_io_interrupt_handler(info->pci_data.u.h0.interrupt_line,
+		&virtio_block_interrupt, info);
+
+	if (info->id >= 0)
+		sDeviceManager->free_id(VIRTIO_BLOCK_ID_GENERATOR, info->id);
+
+	free_driver_info(info);
+}
+
+
+static status_t
+virtio_block_register_child_devices(void* _cookie)
+{
+	virtio_block_driver_info* info = (virtio_block_driver_info*)_cookie;
+
+	info->id = sDeviceManager->create_id(VIRTIO_BLOCK_ID_GENERATOR);
+	if (info->id < 0)
+		return info->id;
+
+	char name[64];
+	snprintf(name, sizeof(name), "disk/virtual/virtio_block/%" B_PRId32 "/raw",
+		info->id);
+
+	return sDeviceManager->publish_device(info->node, name,
+		VIRTIO_BLOCK_DEVICE_MODULE_NAME);
+}
+
+
+module_dependency module_dependencies[] = {
+	{B_DEVICE_MANAGER_MODULE_NAME, (module_info**)&sDeviceManager},
+	{VIRTIO_PCI_MODULE_NAME, (module_info**)&sVirtio},
+	{}
+};
+
+struct device_module_info sVirtioBlockDevice = {
+	{
+		VIRTIO_BLOCK_DEVICE_MODULE_NAME,
+		0,
+		NULL
+	},
+
+	virtio_block_init_device,
+	virtio_block_uninit_device,
+	NULL,	// remove
+
+	virtio_block_open,
+	virtio_block_close,
+	virtio_block_free,
+	virtio_block_read,
+	virtio_block_write,
+	virtio_block_io,
+	virtio_block_ioctl,
+
+	NULL,	// select
+	NULL,	// deselect
+};
+
+struct driver_module_info sVirtioBlockDriver = {
+	{
+		VIRTIO_BLOCK_DRIVER_MODULE_NAME,
+		0,
+		NULL
+	},
+
+	virtio_block_supports_device,
+	virtio_block_register_device,
+	virtio_block_init_driver,
+	virtio_block_uninit_driver,
+	virtio_block_register_child_devices,
+	NULL,	// rescan
+	NULL,	// removed
+};
+
+module_info* modules[] = {
+	(module_info*)&sVirtioBlockDriver,
+	(module_info*)&sVirtioBlockDevice,
+	NULL
+};
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef _VIRTIO_BLOCK_H
+#define _VIRTIO_BLOCK_H
+
+
+#include <device_manager.h>
+#include <bus/PCI.h>
+#include <lock.h>
+#include <virtio.h>
+
+
+struct DMAResource;
+struct IOOperation;
+struct IOScheduler;
+
+
+#define VIRTIO_BLOCK_DRIVER_MODULE_NAME \
+	"drivers/disk/virtual/virtio_block/driver_v1"
+#define VIRTIO_BLOCK_DEVICE_MODULE_NAME \
+	"drivers/disk/virtual/virtio_block/device_v1"
+
+
+// feature bits
+#define VIRTIO_BLOCK_F_SIZE_MAX		(1UL << 1)
+#define VIRTIO_BLOCK_F_SEG_MAX		(1UL << 2)
+#define VIRTIO_BLOCK_F_RO			(1UL << 5)
+#define VIRTIO_BLOCK_F_BLK_SIZE		(1UL << 6)
+#define VIRTIO_BLOCK_F_FLUSH		(1UL << 9)
+
+// device configuration space
+#define VIRTIO_BLOCK_CONFIG_CAPACITY	0	// 64 bit, in 512 byte sectors
+#define VIRTIO_BLOCK_CONFIG_SIZE_MAX	8	// 32 bit
+#define VIRTIO_BLOCK_CONFIG_SEG_MAX		12	// 32 bit
+#define VIRTIO_BLOCK_CONFIG_BLK_SIZE	20	// 32 bit
+
+// request types
+#define VIRTIO_BLOCK_T_IN			0
+#define VIRTIO_BLOCK_T_OUT			1
+#define VIRTIO_BLOCK_T_FLUSH		4
+
+// request status
+#define VIRTIO_BLOCK_S_OK			0
+#define VIRTIO_BLOCK_S_IOERR		1
+#define VIRTIO_BLOCK_S_UNSUPP		2
+
+// request offsets are always given in these units
+#define VIRTIO_BLOCK_SECTOR_SIZE	512
+
+
+struct virtio_block_request_header {
+	uint32	type;
+	uint32	reserved;
+	uint64	sector;
+} _PACKED;
+
+// A request in flight; its header and status are read and written by the
+// device, and therefore live in physically contiguous memory.
+struct virtio_block_request {
+	virtio_block_request_header	header;
+	uint8						status;
+
+	phys_addr_t					physical_address;
+	IOOperation*				operation;
+	virtio_block_request*		next;
+};
+
+struct virtio_block_driver_info {
+	device_node*			node;
+	int32					id;
+	pci_device_module_info*	pci;
+	pci_device*				pci_cookie;
+	pci_info				pci_data;
+
+	virtio_device*			virtio;
+	virtio_queue*			queue;
+	uint32					features;
+	spinlock				lock;
+
+	IOScheduler*			io_scheduler;
+	DMAResource*			dma_resource;
+
+	uint64					capacity;
+	uint32					block_size;
+	uint32					max_segment_count;
+	bool					read_only;
+
+	area_id					requests_area;
+	virtio_block_request*	requests;
+	virtio_block_request*	free_requests;
+	uint32					request_count;
+	sem_id					request_sem;
+
+	mutex					flush_lock;
+	sem_id					flush_sem;
+};
+
+struct virtio_block_handle {
+	virtio_block_driver_info*	info;
+};
+
+#endif	/* _VIRTIO_BLOCK_H */
@@ -0,0 +1,749 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "Device.h"
+
+#include <fcntl.h>
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+#include <net/if_media.h>
+
+#include <smp.h>
+#include <util/AutoLock.h>
+
+#include "virtio_net.h"
+
+
+//#define TRACE_VIRTIO_NET
+#ifdef TRACE_VIRTIO_NET
+#	define TRACE(x...) dprintf(DRIVER_NAME ": " x)
+#else
+#	define TRACE(x...) ;
+#endif
+#define ERROR(x...) dprintf(DRIVER_NAME ": " x)
+
+
+static const uint32 kSupportedFeatures = VIRTIO_NET_F_CSUM
+	| VIRTIO_NET_F_GUEST_CSUM | VIRTIO_NET_F_MAC | VIRTIO_NET_F_MRG_RXBUF
+	| VIRTIO_NET_F_STATUS | VIRTIO_NET_F_CTRL_VQ | VIRTIO_NET_F_CTRL_RX
+	| VIRTIO_NET_F_MQ;
+
+static const size_t kMaxFrameSize = 1514;
+static const size_t kBufferSize = 2048;
+	// every rx/tx buffer can hold a full frame and its header
+static const size_t kHeaderSpace = 16;
+	// offset of the frame data when the header uses its own descriptor
+static const uint16 kMaxBufferCount = 256;
+
+
+/*!	Completes a checksum the device left to us (VIRTIO_NET_HDR_F_NEEDS_CSUM):
+	the stack has no way to accept partially checksummed frames, so this has
+	to be done before the frame is passed on.
+*/
+static void
+complete_checksum(uint8* frame, size_t length, uint16 start, uint16 offset)
+{
+	if ((size_t)start + offset + 2 > length)
+		return;
+
+	uint32 sum = 0;
+	const uint8* data = frame + start;
+	size_t bytes = length - start;
+	for (; bytes > 1; data += 2, bytes -= 2)
+		sum += ((uint32)data[0] << 8) | data[1];
+	if (bytes > 0)
+		sum += (uint32)data[0] << 8;
+
+	while ((sum >> 16) != 0)
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	uint16 checksum = ~sum;
+	frame[start + offset] = checksum >> 8;
+	frame[start + offset + 1] = checksum & 0xff;
+}
+
+
+//	#pragma mark -
+
+
+VirtioNetDevice::VirtioNetDevice(const pci_info& info)
+	:
+	fPCIInfo(info),
+	fDevice(NULL),
+	fFeatures(0),
+	fLinkUp(true),
+	fLinkStateChangeSem(-1),
+	fBlockFlag(0),
+	fHeaderSize(VIRTIO_NET_HEADER_SIZE),
+	fMaxPairCount(1),
+	fPairCount(0),
+	fRxSem(-1),
+	fNextRxQueue(0),
+	fControlQueue(NULL),
+	fControlArea(-1),
+	fControlBuffer(NULL),
+	fControlPhysical(0)
+{
+	memset(&fMACAddress, 0, sizeof(fMACAddress));
+	memset(fRxQueues, 0, sizeof(fRxQueues));
+	memset(fTxQueues, 0, sizeof(fTxQueues));
+
+	mutex_init(&fRxLock, "virtio net rx");
+	mutex_init(&fControlLock, "virtio net control");
+}
+
+
+VirtioNetDevice::~VirtioNetDevice()
+{
+	_StopDevice();
+
+	mutex_destroy(&fRxLock);
+	mutex_destroy(&fControlLock);
+}
+
+
+/*!	Probes the device, and reads its MAC address; the device is only
+	actually started once it is opened.
+*/
+status_t
+VirtioNetDevice::InitCheck()
+{
+	virtio_device* device;
+	status_t status = gVirtio->init_device(&fPCIInfo, &device);
+	if (status != B_OK)
+		return status;
+
+	uint32 features = gVirtio->negotiate_features(device, VIRTIO_NET_F_MAC);
+	if ((features & VIRTIO_NET_F_MAC) == 0) {
+		ERROR("device does not provide a MAC address\n");
+		gVirtio->uninit_device(device);
+		return B_NOT_SUPPORTED;
+	}
+
+	gVirtio->read_device_config(device, VIRTIO_NET_CONFIG_MAC, &fMACAddress,
+		sizeof(fMACAddress));
+	gVirtio->uninit_device(device);
+
+	TRACE("MAC address %02x:%02x:%02x:%02x:%02x:%02x\n",
+		fMACAddress.ebyte[0], fMACAddress.ebyte[1], fMACAddress.ebyte[2],
+		fMACAddress.ebyte[3], fMACAddress.ebyte[4], fMACAddress.ebyte[5]);
+	return B_OK;
+}
+
+
+status_t
+VirtioNetDevice::Open(uint32 flags)
+{
+	if (fDevice != NULL)
+		return B_BUSY;
+
+	fBlockFlag = (flags & O_NONBLOCK) != 0 ? B_TIMEOUT : 0;
+
+	status_t status = _StartDevice();
+	if (status != B_OK)
+		_StopDevice();
+
+	return status;
+}
+
+
+status_t
+VirtioNetDevice::Close()
+{
+	// wakes up blocked readers and writers
+	delete_sem(fRxSem);
+	fRxSem = -1;
+
+	for (uint16 i = 0; i < fPairCount; i++) {
+		delete_sem(fTxQueues[i].sem);
+		fTxQueues[i].sem = -1;
+	}
+
+	return B_OK;
+}
+
+
+status_t
+VirtioNetDevice::Free()
+{
+	_StopDevice();
+	return B_OK;
+}
+
+
+status_t
+VirtioNetDevice::Read(uint8* buffer, size_t* _numBytes)
+{
+	MutexLocker locker(fRxLock);
+
+	while (true) {
+		if (fDevice == NULL || fRxSem < 0)
+			return B_FILE_ERROR;
+
+		// drain the queues round robin, so that no queue can starve others
+		for (uint16 i = 0; i < fPairCount; i++) {
+			RxQueue& rx = fRxQueues[fNextRxQueue];
+			fNextRxQueue = (fNextRxQueue + 1) % fPairCount;
+
+			if (_ReceiveFrame(rx, buffer, _numBytes))
+				return B_OK;
+		}
+
+		// Nothing left; re-enable interrupts, but check again for frames
+		// that came in before the device could notice
+		bool pending = false;
+		for (uint16 i = 0; i < fPairCount; i++)
+			pending |= gVirtio->set_queue_interrupt(fRxQueues[i].queue, true);
+		if (pending)
+			continue;
+
+		status_t status = acquire_sem_etc(fRxSem, 1,
+			B_CAN_INTERRUPT | fBlockFlag, 0);
+		if (status != B_OK) {
+			*_numBytes = 0;
+			return status;
+		}
+
+		// the frames are picked up from here on, until we run dry again
+		for (uint16 i = 0; i < fPairCount; i++)
+			gVirtio->set_queue_interrupt(fRxQueues[i].queue, false);
+	}
+}
+
+
+status_t
+VirtioNetDevice::Write(const uint8* buffer, size_t* _numBytes)
+{
+	size_t length = *_numBytes;
+	if (length > kMaxFrameSize)
+		return B_BAD_VALUE;
+	if (fDevice == NULL)
+		return B_FILE_ERROR;
+
+	if (!fLinkUp) {
+		// pretend success, like other drivers, as DHCP would choke otherwise
+		return B_OK;
+	}
+
+	// spread the senders over the queues by their CPU
+	TxQueue& tx = fTxQueues[smp_get_current_cpu() % fPairCount];
+	MutexLocker locker(tx.lock);
+
+	_ReclaimTxBuffers(tx);
+
+	while (tx.free_count == 0) {
+		atomic_set(&tx.waiting, 1);
+		if (gVirtio->set_queue_interrupt(tx.queue, true)) {
+			atomic_set(&tx.waiting, 0);
+		} else {
+			locker.Unlock();
+			status_t status = acquire_sem_etc(tx.sem, 1,
+				B_CAN_INTERRUPT | fBlockFlag, 0);
+			locker.Lock();
+
+			atomic_set(&tx.waiting, 0);
+			if (status != B_OK) {
+				*_numBytes = 0;
+				return status;
+			}
+		}
+
+		gVirtio->set_queue_interrupt(tx.queue, false);
+		_ReclaimTxBuffers(tx);
+	}
+
+	uint16 slot = tx.free_slots[--tx.free_count];
+	uint8* data = tx.buffers + slot * kBufferSize;
+	phys_addr_t physical = tx.physical + slot * kBufferSize;
+
+	// no offloading: the stack always computes the checksums itself
+	memset(data, 0, fHeaderSize);
+	memcpy(data + kHeaderSpace, buffer, length);
+
+	physical_entry vector[2];
+	vector[0].address = physical;
+	vector[0].size = fHeaderSize;
+	vector[1].address = physical + kHeaderSpace;
+	vector[1].size = length;
+
+	status_t status = gVirtio->queue_request(tx.queue, vector, 2, 0,
+		(void*)(addr_t)slot);
+	if (status != B_OK) {
+		tx.free_slots[tx.free_count++] = slot;
+		return status;
+	}
+
+	gVirtio->kick_queue(tx.queue);
+	return B_OK;
+}
+
+
+status_t
+VirtioNetDevice::Control(uint32 op, void* buffer, size_t length)
+{
+	switch (op) {
+		case ETHER_INIT:
+			return B_OK;
+
+		case ETHER_GETADDR:
+			memcpy(buffer, &fMACAddress, sizeof(fMACAddress));
+			return B_OK;
+
+		case ETHER_GETFRAMESIZE:
+			*(uint32*)buffer = kMaxFrameSize;
+			return B_OK;
+
+		case ETHER_NONBLOCK:
+			fBlockFlag = *(int32*)buffer != 0 ? B_TIMEOUT : 0;
+			return B_OK;
+
+		case ETHER_SETPROMISC:
+		{
+			if ((fFeatures & VIRTIO_NET_F_CTRL_RX) == 0) {
+				// the device is always in promiscuous mode then
+				return B_OK;
+			}
+
+			uint8 enable = *(int32*)buffer != 0;
+			return _SendControl(VIRTIO_NET_CTRL_RX,
+				VIRTIO_NET_CTRL_RX_PROMISC, &enable, sizeof(enable));
+		}
+
+		case ETHER_ADDMULTI:
+		case ETHER_REMMULTI:
+			// we do not filter multicast frames, the stack does
+			return B_OK;
+
+		case ETHER_SET_LINK_STATE_SEM:
+			fLinkStateChangeSem = *(sem_id*)buffer;
+			return B_OK;
+
+		case ETHER_GET_LINK_STATE:
+		{
+			ether_link_state_t state;
+			state.media = IFM_ETHER | IFM_FULL_DUPLEX
+				| (fLinkUp ? IFM_ACTIVE : 0);
+			state.quality = 1000;
+			state.speed = 10000000000ULL;
+				// there is no real speed, but it's fast
+			return user_memcpy(buffer, &state, sizeof(ether_link_state_t));
+		}
+	}
+
+	return B_DEV_INVALID_IOCTL;
+}
+
+
+//	#pragma mark - private
+
+
+/*static*/ int32
+VirtioNetDevice::_InterruptHandler(void* data)
+{
+	VirtioNetDevice* device = (VirtioNetDevice*)data;
+
+	uint8 status = gVirtio->interrupt_status(device->fDevice);
+	if (status == 0)
+		return B_UNHANDLED_INTERRUPT;
+
+	if ((status & VIRTIO_INTERRUPT_CONFIG) != 0)
+		device->_UpdateLinkState();
+
+	if ((status & VIRTIO_INTERRUPT_QUEUE) != 0) {
+		// we cannot tell which queue caused it; both sides check again
+		release_sem_etc(device->fRxSem, 1, B_DO_NOT_RESCHEDULE);
+
+		for (uint16 i = 0; i < device->fPairCount; i++) {
+			TxQueue& tx = device->fTxQueues[i];
+			if (atomic_get(&tx.waiting) != 0)
+				release_sem_etc(tx.sem, 1, B_DO_NOT_RESCHEDULE);
+		}
+	}
+
+	return B_INVOKE_SCHEDULER;
+}
+
+
+status_t
+VirtioNetDevice::_StartDevice()
+{
+	status_t status = gVirtio->init_device(&fPCIInfo, &fDevice);
+	if (status != B_OK) {
+		fDevice = NULL;
+		return status;
+	}
+
+	fFeatures = gVirtio->negotiate_features(fDevice, kSupportedFeatures);
+	if ((fFeatures & VIRTIO_NET_F_CTRL_VQ) == 0)
+		fFeatures &= ~(VIRTIO_NET_F_CTRL_RX | VIRTIO_NET_F_MQ);
+
+	fHeaderSize = (fFeatures & VIRTIO_NET_F_MRG_RXBUF) != 0
+		? VIRTIO_NET_MERGEABLE_HEADER_SIZE : VIRTIO_NET_HEADER_SIZE;
+
+	fMaxPairCount = 1;
+	if ((fFeatures & VIRTIO_NET_F_MQ) != 0) {
+		gVirtio->read_device_config(fDevice, VIRTIO_NET_CONFIG_MAX_PAIRS,
+			&fMaxPairCount, sizeof(fMaxPairCount));
+		if (fMaxPairCount == 0)
+			fMaxPairCount = 1;
+	}
+
+	// one queue pair per CPU is all we can make use of
+	uint16 pairCount = min_c(fMaxPairCount, smp_get_num_cpus());
+	pairCount = min_c(pairCount, MAX_QUEUE_PAIRS);
+
+	fRxSem = create_sem(0, "virtio net rx");
+	if (fRxSem < 0)
+		return fRxSem;
+
+	for (uint16 i = 0; i < pairCount; i++) {
+		// the queues are interleaved: rx0, tx0, rx1, tx1, ...
+		status = _InitRxQueue(fRxQueues[i], i * 2);
+		if (status == B_OK) {
+			fPairCount = i + 1;
+			status = _InitTxQueue(fTxQueues[i], i * 2 + 1);
+		}
+		if (status != B_OK) {
+			ERROR("could not set up queue pair %u: %s\n", i, strerror(status));
+			return status;
+		}
+	}
+
+	if ((fFeatures & VIRTIO_NET_F_CTRL_VQ) != 0) {
+		// the control queue follows the maximum number of pairs
+		uint16 index = (fFeatures & VIRTIO_NET_F_MQ) != 0
+			? fMaxPairCount * 2 : 2;
+		status = gVirtio->alloc_queue(fDevice, index, &fControlQueue);
+		if (status == B_OK) {
+			fControlArea = create_area("virtio net control",
+				(void**)&fControlBuffer, B_ANY_KERNEL_ADDRESS, B_PAGE_SIZE,
+				B_CONTIGUOUS, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA);
+			if (fControlArea < 0)
+				status = fControlArea;
+		}
+		if (status != B_OK)
+			return status;
+
+		physical_entry entry;
+		get_memory_map(fControlBuffer, B_PAGE_SIZE, &entry, 1);
+		fControlPhysical = entry.address;
+	}
+
+	status = install_io_interrupt_handler(fPCIInfo.u.h0.interrupt_line,
+		&_InterruptHandler, this, 0);
+	if (status != B_OK)
+		return status;
+
+	gVirtio->set_driver_ok(fDevice);
+
+	for (uint16 i = 0; i < fPairCount; i++)
+		gVirtio->kick_queue(fRxQueues[i].queue);
+
+	if (fPairCount > 1) {
+		uint16 pairs = fPairCount;
+		status = _SendControl(VIRTIO_NET_CTRL_MQ,
+			VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET, &pairs, sizeof(pairs));
+		if (status != B_OK) {
+			ERROR("could not enable %u queue pairs: %s\n", pairs,
+				strerror(status));
+			// the device continues to use the first pair only
+			fPairCount = 1;
+		}
+	}
+
+	_UpdateLinkState();
+
+	TRACE("started with %u queue pairs, features %#" B_PRIx32 "\n",
+		fPairCount, fFeatures);
+	return B_OK;
+}
+
+
+void
+VirtioNetDevice::_StopDevice()
+{
+	if (fDevice == NULL)
+		return;
+
+	remove_io_interrupt_handler(fPCIInfo.u.h0.interrupt_line,
+		&_InterruptHandler, this);
+
+	// resetting the device releases all of its queues
+	gVirtio->uninit_device(fDevice);
+	fDevice = NULL;
+	fControlQueue = NULL;
+
+	delete_sem(fRxSem);
+	fRxSem = -1;
+
+	for (uint16 i = 0; i < MAX_QUEUE_PAIRS; i++) {
+		RxQueue& rx = fRxQueues[i];
+		if (rx.area > 0)
+			delete_area(rx.area);
+
+		TxQueue& tx = fTxQueues[i];
+		if (tx.area > 0) {
+			delete_area(tx.area);
+			delete_sem(tx.sem);
+			mutex_destroy(&tx.lock);
+		}
+		free(tx.free_slots);
+	}
+	memset(fRxQueues, 0, sizeof(fRxQueues));
+	memset(fTxQueues, 0, sizeof(fTxQueues));
+	fPairCount = 0;
+	fNextRxQueue = 0;
+
+	if (fControlArea >= 0)
+		delete_area(fControlArea);
+	fControlArea = -1;
+	fControlBuffer = NULL;
+}
+
+
+status_t
+VirtioNetDevice::_AllocBuffers(const char* name, uint16 count, area_id& _area,
+	uint8*& _buffers, phys_addr_t& _physical)
+{
+	size_t size = (count * kBufferSize + B_PAGE_SIZE - 1)
+		& ~(size_t)(B_PAGE_SIZE - 1);
+	_area = create_area(name, (void**)&_buffers, B_ANY_KERNEL_ADDRESS, size,
+		B_CONTIGUOUS, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA);
+	if (_area < 0)
+		return _area;
+
+	physical_entry entry;
+	get_memory_map(_buffers, B_PAGE_SIZE, &entry, 1);
+	_physical = entry.address;
+	return B_OK;
+}
+
+
+status_t
+VirtioNetDevice::_InitRxQueue(RxQueue& rx, uint16 index)
+{
+	status_t status = gVirtio->alloc_queue(fDevice, index, &rx.queue);
+	if (status != B_OK)
+		return status;
+
+	// Mergeable buffers carry the header inline, and need a single
+	// descriptor; otherwise the header gets a descriptor of its own.
+	uint16 count = gVirtio->queue_size(rx.queue);
+	if ((fFeatures & VIRTIO_NET_F_MRG_RXBUF) == 0)
+		count /= 2;
+	rx.count = min_c(count, kMaxBufferCount);
+
+	status = _AllocBuffers("virtio net rx", rx.count, rx.area, rx.buffers,
+		rx.physical);
+	if (status != B_OK)
+		return status;
+
+	// only checked once the reader runs dry
+	gVirtio->set_queue_interrupt(rx.queue, false);
+
+	for (uint16 slot = 0; slot < rx.count; slot++)
+		_QueueRxBuffer(rx, slot);
+
+	return B_OK;
+}
+
+
+status_t
+VirtioNetDevice::_InitTxQueue(TxQueue& tx, uint16 index)
+{
+	status_t status = gVirtio->alloc_queue(fDevice, index, &tx.queue);
+	if (status != B_OK)
+		return status;
+
+	// every frame needs a descriptor for the header, and one for the data
+	tx.count = min_c(gVirtio->queue_size(tx.queue) / 2, kMaxBufferCount);
+	tx.free_slots = (uint16*)malloc(tx.count * sizeof(uint16));
+	if (tx.free_slots == NULL)
+		return B_NO_MEMORY;
+
+	tx.sem = create_sem(0, "virtio net tx");
+	if (tx.sem < 0)
+		return tx.sem;
+
+	status = _AllocBuffers("virtio net tx", tx.count, tx.area, tx.buffers,
+		tx.physical);
+	if (status != B_OK) {
+		delete_sem(tx.sem);
+		return status;
+	}
+
+	mutex_init(&tx.lock, "virtio net tx");
+
+	for (uint16 slot = 0; slot < tx.count; slot++)
+		tx.free_slots[slot] = slot;
+	tx.free_count = tx.count;
+	tx.waiting = 0;
+
+	// completed transmits are only collected when we need the buffers
+	gVirtio->set_queue_interrupt(tx.queue, false);
+	return B_OK;
+}
+
+
+void
+VirtioNetDevice::_QueueRxBuffer(RxQueue& rx, uint16 slot)
+{
+	phys_addr_t physical = rx.physical + slot * kBufferSize;
+	physical_entry vector[2];
+
+	if ((fFeatures & VIRTIO_NET_F_MRG_RXBUF) != 0) {
+		vector[0].address = physical;
+		vector[0].size = kBufferSize;
+		gVirtio->queue_request(rx.queue, vector, 0, 1, (void*)(addr_t)slot);
+	} else {
+		vector[0].address = physical;
+		vector[0].size = fHeaderSize;
+		vector[1].address = physical + kHeaderSpace;
+		vector[1].size = kBufferSize - kHeaderSpace;
+		gVirtio->queue_request(rx.queue, vector, 0, 2, (void*)(addr_t)slot);
+	}
+}
+
+
+/*!	Copies the next frame of the given queue into \a buffer, and gives its
+	buffers back to the device. With mergeable rx buffers a frame may span
+	several buffers, as indicated in the header of the first one.
+*/
+bool
+VirtioNetDevice::_ReceiveFrame(RxQueue& rx, uint8* buffer, size_t* _numBytes)
+{
+	void* cookie;
+	uint32 usedLength;
+	if (!gVirtio->dequeue(rx.queue, &cookie, &usedLength))
+		return false;
+
+	uint16 slot = (addr_t)cookie;
+	uint8* data = rx.buffers + slot * kBufferSize;
+	virtio_net_header header;
+	memcpy(&header, data, fHeaderSize);
+
+	uint16 bufferCount = 1;
+	size_t dataOffset = kHeaderSpace;
+	if ((fFeatures & VIRTIO_NET_F_MRG_RXBUF) != 0) {
+		bufferCount = max_c(header.buffer_count, 1);
+		dataOffset = fHeaderSize;
+	}
+
+	size_t length = usedLength > fHeaderSize ? usedLength - fHeaderSize : 0;
+	size_t copied = min_c(length, *_numBytes);
+	memcpy(buffer, data + dataOffset, copied);
+	_QueueRxBuffer(rx, slot);
+
+	for (uint16 i = 1; i < bufferCount; i++) {
+		if (!gVirtio->dequeue(rx.queue, &cookie, &usedLength)) {
+			// the device has to provide all buffers at once
+			ERROR("frame is missing %u buffers\n", bufferCount - i);
+			break;
+		}
+
+		slot = (addr_t)cookie;
+		size_t toCopy = min_c(usedLength, *_numBytes - copied);
+		memcpy(buffer + copied, rx.buffers + slot * kBufferSize, toCopy);
+		copied += toCopy;
+		length += usedLength;
+		_QueueRxBuffer(rx, slot);
+	}
+
+	gVirtio->kick_queue(rx.queue);
+
+	if ((header.flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) != 0 && copied == length) {
+		complete_checksum(buffer, length, header.checksum_start,
+			header.checksum_offset);
+	}
+
+	*_numBytes = copied;
+	return true;
+}
+
+
+void
+VirtioNetDevice::_ReclaimTxBuffers(TxQueue& tx)
+{
+	void* cookie;
+	while (gVirtio->dequeue(tx.queue, &cookie, NULL))
+		tx.free_slots[tx.free_count++] = (addr_t)cookie;
+}
+
+
+/*!	Sends a command over the control queue, and waits for the device to
+	acknowledge it. The device handles those synchronously, so we just poll.
+*/
+status_t
+VirtioNetDevice::_SendControl(uint8 commandClass, uint8 command,
+	const void* data, size_t length)
+{
+	if (fControlQueue == NULL)
+		return B_NOT_SUPPORTED;
+	if (length > B_PAGE_SIZE / 2)
+		return B_BAD_VALUE;
+
+	MutexLocker locker(fControlLock);
+
+	virtio_net_control_header* header
+		= (virtio_net_control_header*)fControlBuffer;
+	header->command_class = commandClass;
+	header->command = command;
+
+	const size_t kDataOffset = 16;
+	const size_t kAckOffset = B_PAGE_SIZE - 16;
+	memcpy(fControlBuffer + kDataOffset, data, length);
+	fControlBuffer[kAckOffset] = VIRTIO_NET_ERR;
+
+	physical_entry vector[3];
+	vector[0].address = fControlPhysical;
+	vector[0].size = sizeof(virtio_net_control_header);
+	vector[1].address = fControlPhysical + kDataOffset;
+	vector[1].size = length;
+	vector[2].address = fControlPhysical + kAckOffset;
+	vector[2].size = 1;
+
+	status_t status = gVirtio->queue_request(fControlQueue, vector, 2, 1,
+		NULL);
+	if (status != B_OK)
+		return status;
+
+	gVirtio->kick_queue(fControlQueue);
+
+	void* cookie;
+	bigtime_t timeout = system_time() + 1000000;
+	while (!gVirtio->dequeue(fControlQueue, &cookie, NULL)) {
+		if (system_time() > timeout) {
+			// the request stays queued, we can't take back the buffer
+			ERROR("control command %u/%u timed out\n", commandClass, command);
+			return B_TIMED_OUT;
+		}
+		snooze(100);
+	}
+
+	return fControlBuffer[kAckOffset] == VIRTIO_NET_OK ? B_OK : B_ERROR;
+}
+
+
+void
+VirtioNetDevice::_UpdateLinkState()
+{
+	if ((fFeatures & VIRTIO_NET_F_STATUS) == 0)
+		return;
+
+	uint16 status;
+	gVirtio->read_device_config(fDevice, VIRTIO_NET_CONFIG_STATUS, &status,
+		sizeof(status));
+
+	bool linkUp = (status & VIRTIO_NET_S_LINK_UP) != 0;
+	if (linkUp == fLinkUp)
+		return;
+
+	fLinkUp = linkUp;
+	if (fLinkStateChangeSem >= 0)
+		release_sem_etc(fLinkStateChangeSem, 1, B_DO_NOT_RESCHEDULE);
+}
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef VIRTIO_NET_DEVICE_H
+#define VIRTIO_NET_DEVICE_H
+
+
+#include <ether_driver.h>
+#include <lock.h>
+
+#include "Driver.h"
+
+
+#define MAX_QUEUE_PAIRS		8
+
+
+class VirtioNetDevice {
+public:
+								VirtioNetDevice(const pci_info& info);
+								~VirtioNetDevice();
+
+			status_t			InitCheck();
+
+			status_t			Open(uint32 flags);
+			status_t			Close();
+			status_t			Free();
+
+			status_t			Read(uint8* buffer, size_t* _numBytes);
+			status_t			Write(const uint8* buffer, size_t* _numBytes);
+			status_t			Control(uint32 op, void* buffer, size_t length);
+
+private:
+			struct RxQueue {
+				virtio_queue*	queue;
+				area_id			area;
+				uint8*			buffers;
+				phys_addr_t		physical;
+				uint16			count;
+			};
+
+			struct TxQueue {
+				virtio_queue*	queue;
+				mutex			lock;
+				area_id			area;
+				uint8*			buffers;
+				phys_addr_t		physical;
+				uint16			count;
+				uint16*			free_slots;
+				uint16			free_count;
+				sem_id			sem;
+				int32			waiting;
+			};
+
+	static	int32				_InterruptHandler(void* data);
+
+			status_t			_StartDevice();
+			void				_StopDevice();
+			status_t			_AllocBuffers(const char* name, uint16 count,
+									area_id& _area, uint8*& _buffers,
+									phys_addr_t& _physical);
+			status_t			_InitRxQueue(RxQueue& rx, uint16 index);
+			status_t			_InitTxQueue(TxQueue& tx, uint16 index);
+
+			void				_QueueRxBuffer(RxQueue& rx, uint16 slot);
+			bool				_ReceiveFrame(RxQueue& rx, uint8* buffer,
+									size_t* _numBytes);
+			void				_ReclaimTxBuffers(TxQueue& tx);
+
+			status_t			_SendControl(uint8 commandClass,
+									uint8 command, const void* data,
+									size_t length);
+			void				_UpdateLinkState();
+
+private:
+			pci_info			fPCIInfo;
+			virtio_device*		fDevice;
+			uint32				fFeatures;
+			ether_address_t		fMACAddress;
+			bool				fLinkUp;
+			sem_id				fLinkStateChangeSem;
+			uint32				fBlockFlag;
+			size_t				fHeaderSize;
+
+			uint16				fMaxPairCount;
+			uint16				fPairCount;
+			RxQueue				fRxQueues[MAX_QUEUE_PAIRS];
+			TxQueue				fTxQueues[MAX_QUEUE_PAIRS];
+			mutex				fRxLock;
+			sem_id				fRxSem;
+			uint16				fNextRxQueue;
+
+			virtio_queue*		fControlQueue;
+			mutex				fControlLock;
+			area_id				fControlArea;
+			uint8*				fControlBuffer;
+			phys_addr_t			fControlPhysical;
+};
+
+
+#endif	// VIRTIO_NET_DEVICE_H
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "Driver.h"
+
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Device.h"
+
+
+int32 api_version = B_CUR_DRIVER_API_VERSION;
+
+virtio_pci_module_info* gVirtio;
+
+static pci_module_info* sPCI;
+static VirtioNetDevice* sDevices[MAX_DEVICES];
+static char* sDeviceNames[MAX_DEVICES + 1];
+
+
+static bool
+is_virtio_net(const pci_info& info)
+{
+	return info.vendor_id == VIRTIO_PCI_VENDOR_ID
+		&& info.device_id >= VIRTIO_PCI_DEVICE_ID_MIN
+		&& info.device_id <= VIRTIO_PCI_DEVICE_ID_MAX
+		&& info.u.h0.subsystem_id == VIRTIO_DEVICE_TYPE_NET;
+}
+
+
+//	#pragma mark - device hooks
+
+
+static status_t
+virtio_net_open(const char* name, uint32 flags, void** _cookie)
+{
+	for (int32 i = 0; sDeviceNames[i] != NULL; i++) {
+		if (strcmp(sDeviceNames[i], name) == 0) {
+			status_t status = sDevices[i]->Open(flags);
+			if (status == B_OK)
+				*_cookie = sDevices[i];
+			return status;
+		}
+	}
+
+	return B_ENTRY_NOT_FOUND;
+}
+
+
+static status_t
+virtio_net_close(void* cookie)
+{
+	return ((VirtioNetDevice*)cookie)->Close();
+}
+
+
+static status_t
+virtio_net_free(void* cookie)
+{
+	return ((VirtioNetDevice*)cookie)->Free();
+}
+
+
+static status_t
+virtio_net_control(void* cookie, uint32 op, void* buffer, size_t length)
+{
+	return ((VirtioNetDevice*)cookie)->Control(op, buffer, length);
+}
+
+
+static status_t
+virtio_net_read(void* cookie, off_t position, void* buffer, size_t* _length)
+{
+	return ((VirtioNetDevice*)cookie)->Read((uint8*)buffer, _length);
+}
+
+
+static status_t
+virtio_net_write(void* cookie, off_t position, const void* buffer,
+	size_t* _length)
+{
+	return ((VirtioNetDevice*)cookie)->Write((const uint8*)buffer, _length);
+}
+
+
+//	#pragma mark - driver API
+
+
+status_t
+init_hardware()
+{
+	if (get_module(B_PCI_MODULE_NAME, (module_info**)&sPCI) != B_OK)
+		return ENOSYS;
+
+	status_t status = ENODEV;
+	pci_info info;
+	for (int32 i = 0; sPCI->get_nth_pci_info(i, &info) == B_OK; i++) {
+		if (is_virtio_net(info)) {
+			status = B_OK;
+			break;
+		}
+	}
+
+	put_module(B_PCI_MODULE_NAME);
+	return status;
+}
+
+
+status_t
+init_driver()
+{
+	status_t status = get_module(B_PCI_MODULE_NAME, (module_info**)&sPCI);
+	if (status != B_OK)
+		return status;
+
+	status = get_module(VIRTIO_PCI_MODULE_NAME, (module_info**)&gVirtio);
+	if (status != B_OK) {
+		put_module(B_PCI_MODULE_NAME);
+		return status;
+	}
+
+	int32 count = 0;
+	pci_info info;
+	for (int32 i = 0; count < MAX_DEVICES
+			&& sPCI->get_nth_pci_info(i, &info) == B_OK; i++) {
+		if (!is_virtio_net(info))
+			continue;
+
+		VirtioNetDevice* device = new(std::nothrow) VirtioNetDevice(info);
+		if (device == NULL)
+			break;
+
+		if (device->InitCheck() != B_OK) {
+			delete device;
+			continue;
+		}
+
+		char name[64];
+		snprintf(name, sizeof(name), "net/" DRIVER_NAME "/%" B_PRId32, count);
+		sDeviceNames[count] = strdup(name);
+		if (sDeviceNames[count] == NULL) {
+			delete device;
+			break;
+		}
+
+		sDevices[count++] = device;
+	}
+
+	sDeviceNames[count] = NULL;
+
+	if (count == 0) {
+		put_module(VIRTIO_PCI_MODULE_NAME);
+		put_module(B_PCI_MODULE_NAME);
+		return ENODEV;
+	}
+
+	return B_OK;
+}
+
+
+void
+uninit_driver()
+{
+	for (int32 i = 0; sDeviceNames[i] != NULL; i++) {
+		delete sDevices[i];
+		free(sDeviceNames[i]);
+		sDevices[i] = NULL;
+		sDeviceNames[i] = NULL;
+	}
+
+	put_module(VIRTIO_PCI_MODULE_NAME);
+	put_module(B_PCI_MODULE_NAME);
+}
+
+
+const char**
+publish_devices()
+{
+	return (const char**)sDeviceNames;
+}
+
+
+device_hooks*
+find_device(const char* name)
+{
+	static device_hooks sDeviceHooks = {
+		virtio_net_open,
+		virtio_net_close,
+		virtio_net_free,
+		virtio_net_control,
+		virtio_net_read,
+		virtio_net_write,
+		NULL,	// select
+		NULL	// deselect
+	};
+
+	return &sDeviceHooks;
+}
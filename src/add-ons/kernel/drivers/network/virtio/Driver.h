@@ -0,0 +1,33 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef VIRTIO_NET_DRIVER_H
+#define VIRTIO_NET_DRIVER_H
+
+
+#include <Drivers.h>
+#include <PCI.h>
+
+#include <virtio.h>
+
+
+#define DRIVER_NAME		"virtio"
+#define MAX_DEVICES		8
+
+
+extern virtio_pci_module_info* gVirtio;
+
+
+extern "C" {
+
+status_t		init_hardware();
+status_t		init_driver();
+void			uninit_driver();
+const char**	publish_devices();
+device_hooks*	find_device(const char* name);
+
+}
+
+
+#endif	// VIRTIO_NET_DRIVER_H
@@ -0,0 +1,67 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef VIRTIO_NET_H
+#define VIRTIO_NET_H
+
+
+#include <SupportDefs.h>
+
+
+// feature bits
+#define VIRTIO_NET_F_CSUM			(1UL << 0)
+#define VIRTIO_NET_F_GUEST_CSUM		(1UL << 1)
+#define VIRTIO_NET_F_MAC			(1UL << 5)
+#define VIRTIO_NET_F_MRG_RXBUF		(1UL << 15)
+#define VIRTIO_NET_F_STATUS			(1UL << 16)
+#define VIRTIO_NET_F_CTRL_VQ		(1UL << 17)
+#define VIRTIO_NET_F_CTRL_RX		(1UL << 18)
+#define VIRTIO_NET_F_MQ				(1UL << 22)
+
+// configuration space
+#define VIRTIO_NET_CONFIG_MAC		0	// uint8[6]
+#define VIRTIO_NET_CONFIG_STATUS	6	// uint16
+#define VIRTIO_NET_CONFIG_MAX_PAIRS	8	// uint16
+
+#define VIRTIO_NET_S_LINK_UP		0x01
+
+// header flags
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM	0x01
+#define VIRTIO_NET_HDR_F_DATA_VALID	0x02
+
+#define VIRTIO_NET_HDR_GSO_NONE		0
+
+
+struct virtio_net_header {
+	uint8	flags;
+	uint8	gso_type;
+	uint16	header_length;
+	uint16	gso_size;
+	uint16	checksum_start;
+	uint16	checksum_offset;
+	uint16	buffer_count;
+		// only present with VIRTIO_NET_F_MRG_RXBUF
+} _PACKED;
+
+#define VIRTIO_NET_HEADER_SIZE			10
+#define VIRTIO_NET_MERGEABLE_HEADER_SIZE	12
+
+
+// control queue
+struct virtio_net_control_header {
+	uint8	command_class;
+	uint8	command;
+} _PACKED;
+
+#define VIRTIO_NET_CTRL_RX			0
+#define VIRTIO_NET_CTRL_RX_PROMISC	0
+
+#define VIRTIO_NET_CTRL_MQ			4
+#define VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET	0
+
+#define VIRTIO_NET_OK				0
+#define VIRTIO_NET_ERR				1
+
+
+#endif	// VIRTIO_NET_H
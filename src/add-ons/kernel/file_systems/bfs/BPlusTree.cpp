@@ -1085,6 +1085,31 @@ BPlusTree::_SeekDown(Stack<node_and_key>& stack, const uint8* key,
 }
 
 
+/*!	Returns the length of the shortest prefix of \a nextKey that still sorts
+	after (or equal to) \a key, or 0 if there is no such prefix that is
+	shorter than \a key.
+	Since an index node only has to tell its children apart, such a prefix
+	can replace \a key there, and leaves room for more keys in the node.
+	Only string keys can be shortened that way.
+*/
+uint16
+BPlusTree::_SeparatorLength(const uint8* key, uint16 keyLength,
+	const uint8* nextKey, uint16 nextKeyLength)
+{
+	if (fHeader.DataType() != BPLUSTREE_STRING_TYPE)
+		return 0;
+
+	for (uint16 length = 1; length < keyLength && length < nextKeyLength;
+			length++) {
+		if (_CompareKeys(nextKey, length, key, keyLength) >= 0
+			&& _CompareKeys(nextKey, length, nextKey, nextKeyLength) < 0)
+			return length;
+	}
+
+	return 0;
+}
+
+
 /*!	This will find a free duplicate fragment in the given bplustree_node.
 	The CachedNode will be set to the writable fragment on success.
 */
@@ -1591,9 +1616,22 @@ BPlusTree::_SplitNode(bplustree_node* node, off_t nodeOffset,
 	// is either the dropped key or the last of the other node.
 	// If it's the dropped key, "newKey" was already set earlier.
 
-	if (newKey == NULL)
+	if (newKey == NULL) {
 		newKey = other->KeyAt(other->NumKeys() - 1, &newLength);
 
+		if (node->IsLeaf() && node->NumKeys() > 0) {
+			// the parent only needs a key that separates both leaves
+			uint16 nextLength;
+			uint8* nextKey = node->KeyAt(0, &nextLength);
+			uint16 length = _SeparatorLength(newKey, newLength, nextKey,
+				nextLength);
+			if (length > 0) {
+				newKey = nextKey;
+				newLength = length;
+			}
+		}
+	}
+
 	memcpy(key, newKey, newLength);
 	*_keyLength = newLength;
 	*_value = otherOffset;
@@ -2481,6 +2519,429 @@ BPlusTree::_ValidateChild(TreeCheck& check, CachedNode& cached, uint32 level,
 }
 
 
+//	#pragma mark - TreeBuilder
+
+
+TreeBuilder::TreeBuilder(BPlusTree* tree)
+	:
+	fTree(tree),
+	fLevelCount(0),
+	fWrittenNodes(0),
+	fKeyLength(0),
+	fHasKey(false),
+	fValueCount(0),
+	fDuplicateLink(BPLUSTREE_NULL),
+	fDuplicateOffset(BPLUSTREE_NULL),
+	fLastDuplicateOffset(BPLUSTREE_NULL),
+	fFragmentOffset(BPLUSTREE_NULL),
+	fFragmentIndex(0)
+{
+	fStatus = _StartTransaction();
+	if (fStatus != B_OK)
+		return;
+
+	// We start with the (empty) root node as the first leaf
+	CachedNode cached(fTree);
+	const bplustree_node* root = cached.SetTo(fTree->fHeader.RootNode());
+	if (root == NULL) {
+		fStatus = B_IO_ERROR;
+		return;
+	}
+	if (!root->IsLeaf() || root->NumKeys() != 0) {
+		fStatus = B_BAD_VALUE;
+		return;
+	}
+
+	Level& leaf = fLevels[0];
+	leaf.node = (bplustree_node*)malloc(fTree->fNodeSize);
+	if (leaf.node == NULL) {
+		fStatus = B_NO_MEMORY;
+		return;
+	}
+
+	memset(leaf.node, 0, fTree->fNodeSize);
+	leaf.node->Initialize();
+	leaf.offset = fTree->fHeader.RootNode();
+	fLevelCount = 1;
+}
+
+
+TreeBuilder::~TreeBuilder()
+{
+	for (uint32 i = 0; i < fLevelCount; i++)
+		free(fLevels[i].node);
+}
+
+
+/*!	Adds the \a key/\a value pair to the tree. The keys must be passed in
+	ascending order; duplicate keys must be ordered by their value.
+*/
+status_t
+TreeBuilder::Add(const uint8* key, uint16 keyLength, off_t value)
+{
+	if (fStatus != B_OK)
+		return fStatus;
+
+	if (keyLength < BPLUSTREE_MIN_KEY_LENGTH
+		|| keyLength > BPLUSTREE_MAX_KEY_LENGTH)
+		RETURN_ERROR(B_BAD_VALUE);
+
+	if (fHasKey) {
+		int32 compare = fTree->_CompareKeys(key, keyLength, fKey, fKeyLength);
+		if (compare < 0)
+			RETURN_ERROR(B_BAD_VALUE);
+
+		if (compare == 0) {
+			if (!fTree->fAllowDuplicates)
+				return B_NAME_IN_USE;
+
+			if (fValueCount == NUM_DUPLICATE_VALUES) {
+				fStatus = _WriteDuplicateNode(false);
+				if (fStatus != B_OK)
+					return fStatus;
+			}
+
+			fValues[fValueCount++] = value;
+			return B_OK;
+		}
+
+		fStatus = _FlushKey();
+		if (fStatus != B_OK)
+			return fStatus;
+	}
+
+	memcpy(fKey, key, keyLength);
+	fKeyLength = keyLength;
+	fValues[0] = value;
+	fValueCount = 1;
+	fHasKey = true;
+
+	return B_OK;
+}
+
+
+/*!	Writes back the nodes that are still being filled, and lets the tree's
+	header point to the new root node.
+*/
+status_t
+TreeBuilder::Finish()
+{
+	if (fStatus != B_OK)
+		return fStatus;
+
+	if (fHasKey) {
+		fStatus = _FlushKey();
+		if (fStatus != B_OK)
+			return fStatus;
+	}
+
+	// The last node of each level is the overflow link of its parent
+	for (uint32 level = 0; level < fLevelCount; level++) {
+		if (level + 1 < fLevelCount) {
+			fLevels[level + 1].node->overflow_link
+				= HOST_ENDIAN_TO_BFS_INT64(fLevels[level].offset);
+		}
+
+		fStatus = _WriteNode(fLevels[level]);
+		if (fStatus != B_OK)
+			return fStatus;
+	}
+
+	CachedNode cached(fTree);
+	bplustree_header* header = cached.SetToWritableHeader(fTransaction);
+	if (header == NULL)
+		return fStatus = B_IO_ERROR;
+
+	header->root_node_pointer = HOST_ENDIAN_TO_BFS_INT64(
+		fLevels[fLevelCount - 1].offset);
+	header->max_number_of_levels = HOST_ENDIAN_TO_BFS_INT32(fLevelCount);
+	cached.Unset();
+
+	status_t status = fTransaction.Done();
+
+	// the builder cannot be used anymore
+	fStatus = B_NO_INIT;
+	return status;
+}
+
+
+status_t
+TreeBuilder::_StartTransaction()
+{
+	Inode* stream = fTree->fStream;
+
+	status_t status = fTransaction.Start(stream->GetVolume(),
+		stream->BlockNumber());
+	if (status != B_OK)
+		return status;
+
+	stream->WriteLockInTransaction(fTransaction);
+	return B_OK;
+}
+
+
+/*!	Like MakeEmpty(), we don't need to write the tree in a single
+	transaction, we just make sure it doesn't get too large.
+*/
+status_t
+TreeBuilder::_NodeWritten()
+{
+	if (++fWrittenNodes % kNodesPerTransaction != 0)
+		return B_OK;
+
+	status_t status = fTransaction.Done();
+	if (status != B_OK)
+		return status;
+
+	return _StartTransaction();
+}
+
+
+status_t
+TreeBuilder::_AllocateNode(off_t* _offset)
+{
+	CachedNode cached(fTree);
+	bplustree_node* node;
+	return cached.Allocate(fTransaction, &node, _offset);
+}
+
+
+status_t
+TreeBuilder::_WriteNode(const Level& level)
+{
+	CachedNode cached(fTree);
+	bplustree_node* node = cached.SetToWritable(fTransaction, level.offset,
+		false);
+	if (node == NULL)
+		return B_IO_ERROR;
+
+	memcpy(node, level.node, fTree->fNodeSize);
+	cached.Unset();
+
+	return _NodeWritten();
+}
+
+
+/*!	Makes sure the node currently being filled on the given \a level has
+	enough space left for \a key; if it hasn't, the node is written back,
+	and a new one is started.
+*/
+status_t
+TreeBuilder::_MakeRoom(uint32 level, const uint8* key, uint16 keyLength)
+{
+	bplustree_node* node = fLevels[level].node;
+
+	if (int32(key_align(sizeof(bplustree_node) + node->AllKeyLength()
+			+ keyLength) + (node->NumKeys() + 1) * (sizeof(uint16)
+			+ sizeof(off_t))) < fTree->fNodeSize)
+		return B_OK;
+
+	return _SealNode(level, key, keyLength);
+}
+
+
+/*!	Writes back the node currently being filled on the given \a level, and
+	adds its largest key to the parent level. \a nextKey is the first key
+	of the next node.
+*/
+status_t
+TreeBuilder::_SealNode(uint32 level, const uint8* nextKey,
+	uint16 nextKeyLength)
+{
+	Level& current = fLevels[level];
+	bplustree_node* node = current.node;
+	int32 lastIndex = node->NumKeys() - 1;
+
+	uint8 separator[BPLUSTREE_MAX_KEY_LENGTH];
+	uint16 separatorLength;
+	uint8* lastKey = node->KeyAt(lastIndex, &separatorLength);
+	memcpy(separator, lastKey, separatorLength);
+
+	if (level == 0) {
+		uint16 length = fTree->_SeparatorLength(lastKey, separatorLength,
+			nextKey, nextKeyLength);
+		if (length > 0) {
+			memcpy(separator, nextKey, length);
+			separatorLength = length;
+		}
+	} else {
+		// The last child becomes the overflow link, and its key is moved
+		// up to the parent
+		node->overflow_link = node->Values()[lastIndex];
+		fTree->_RemoveKey(node, lastIndex);
+	}
+
+	off_t nextOffset;
+	status_t status = _AllocateNode(&nextOffset);
+	if (status != B_OK)
+		return status;
+
+	node->right_link = HOST_ENDIAN_TO_BFS_INT64(nextOffset);
+
+	status = _WriteNode(current);
+	if (status != B_OK)
+		return status;
+
+	off_t offset = current.offset;
+
+	node->Initialize();
+	node->left_link = HOST_ENDIAN_TO_BFS_INT64(offset);
+	current.offset = nextOffset;
+
+	if (level == 0) {
+		// duplicate fragments are only shared between keys of the same leaf
+		fFragmentOffset = BPLUSTREE_NULL;
+	}
+
+	return _AddKey(level + 1, separator, separatorLength, offset);
+}
+
+
+status_t
+TreeBuilder::_AddKey(uint32 level, const uint8* key, uint16 keyLength,
+	off_t value)
+{
+	if (level == fLevelCount) {
+		// we need another level
+		if (level == kMaxLevels)
+			RETURN_ERROR(B_BAD_DATA);
+
+		Level& parent = fLevels[level];
+		parent.node = (bplustree_node*)malloc(fTree->fNodeSize);
+		if (parent.node == NULL)
+			return B_NO_MEMORY;
+
+		memset(parent.node, 0, fTree->fNodeSize);
+		parent.node->Initialize();
+		fLevelCount++;
+
+		status_t status = _AllocateNode(&parent.offset);
+		if (status != B_OK)
+			return status;
+	}
+
+	status_t status = _MakeRoom(level, key, keyLength);
+	if (status != B_OK)
+		return status;
+
+	bplustree_node* node = fLevels[level].node;
+	fTree->_InsertKey(node, node->NumKeys(), (uint8*)key, keyLength, value);
+	return B_OK;
+}
+
+
+/*!	Adds the pending key with all of its values to the current leaf. */
+status_t
+TreeBuilder::_FlushKey()
+{
+	// Make sure the key goes into the leaf that owns its duplicate fragment
+	status_t status = _MakeRoom(0, fKey, fKeyLength);
+	if (status != B_OK)
+		return status;
+
+	off_t value = fValues[0];
+
+	if (fDuplicateLink != BPLUSTREE_NULL
+		|| fValueCount > NUM_FRAGMENT_VALUES) {
+		status = _WriteDuplicateNode(true);
+		value = fDuplicateLink;
+	} else if (fValueCount > 1)
+		status = _WriteFragment(value);
+
+	if (status != B_OK)
+		return status;
+
+	fDuplicateLink = BPLUSTREE_NULL;
+	fValueCount = 0;
+	fHasKey = false;
+
+	return _AddKey(0, fKey, fKeyLength, value);
+}
+
+
+status_t
+TreeBuilder::_WriteFragment(off_t& _link)
+{
+	CachedNode cached(fTree);
+	bplustree_node* fragment;
+
+	if (fFragmentOffset == BPLUSTREE_NULL
+		|| fFragmentIndex >= bplustree_node::MaxFragments(fTree->fNodeSize)) {
+		status_t status = cached.Allocate(fTransaction, &fragment,
+			&fFragmentOffset);
+		if (status != B_OK)
+			return status;
+
+		memset(fragment, 0, fTree->fNodeSize);
+		fFragmentIndex = 0;
+	} else {
+		fragment = cached.SetToWritable(fTransaction, fFragmentOffset, false);
+		if (fragment == NULL)
+			return B_IO_ERROR;
+	}
+
+	duplicate_array* array = fragment->FragmentAt(fFragmentIndex);
+	array->count = HOST_ENDIAN_TO_BFS_INT64(fValueCount);
+	for (int32 i = 0; i < fValueCount; i++)
+		array->SetValueAt(i, fValues[i]);
+
+	_link = bplustree_node::MakeLink(BPLUSTREE_DUPLICATE_FRAGMENT,
+		fFragmentOffset, fFragmentIndex++);
+
+	cached.Unset();
+	return _NodeWritten();
+}
+
+
+/*!	Writes the pending values into a duplicate node. Unless this is the
+	\a last node for the current key, the next duplicate node is already
+	allocated, so that the nodes can be linked together.
+*/
+status_t
+TreeBuilder::_WriteDuplicateNode(bool last)
+{
+	off_t offset = fDuplicateOffset;
+	if (offset == BPLUSTREE_NULL) {
+		status_t status = _AllocateNode(&offset);
+		if (status != B_OK)
+			return status;
+	}
+
+	off_t nextOffset = BPLUSTREE_NULL;
+	if (!last) {
+		status_t status = _AllocateNode(&nextOffset);
+		if (status != B_OK)
+			return status;
+	}
+
+	CachedNode cached(fTree);
+	bplustree_node* node = cached.SetToWritable(fTransaction, offset, false);
+	if (node == NULL)
+		return B_IO_ERROR;
+
+	node->left_link = HOST_ENDIAN_TO_BFS_INT64(fLastDuplicateOffset);
+	node->right_link = HOST_ENDIAN_TO_BFS_INT64(nextOffset);
+
+	duplicate_array* array = node->DuplicateArray();
+	array->count = HOST_ENDIAN_TO_BFS_INT64(fValueCount);
+	for (int32 i = 0; i < fValueCount; i++)
+		array->SetValueAt(i, fValues[i]);
+
+	cached.Unset();
+
+	if (fDuplicateLink == BPLUSTREE_NULL) {
+		fDuplicateLink = bplustree_node::MakeLink(BPLUSTREE_DUPLICATE_NODE,
+			offset);
+	}
+
+	fLastDuplicateOffset = last ? BPLUSTREE_NULL : offset;
+	fDuplicateOffset = nextOffset;
+	fValueCount = 0;
+
+	return _NodeWritten();
+}
+
+
 //	#pragma mark -
 
 
@@ -135,6 +135,7 @@ enum bplustree_traversing {
 template<class T> class Stack;
 class BPlusTree;
 class TreeIterator;
+class TreeBuilder;
 class CachedNode;
 class Inode;
 struct TreeCheck;
@@ -252,6 +253,11 @@ public:
 			status_t			Find(const uint8* key, uint16 keyLength,
 									off_t* value);
 
+			int32				CompareKeys(const void* key1, int keyLength1,
+									const void* key2, int keyLength2)
+									{ return _CompareKeys(key1, keyLength1,
+										key2, keyLength2); }
+
 	static	int32				TypeCodeToKeyType(type_code code);
 	static	int32				ModeToKeyType(mode_t mode);
 
@@ -271,6 +277,9 @@ private:
 									uint16* index = NULL, off_t* next = NULL);
 			status_t			_SeekDown(Stack<node_and_key>& stack,
 									const uint8* key, uint16 keyLength);
+			uint16				_SeparatorLength(const uint8* key,
+									uint16 keyLength, const uint8* nextKey,
+									uint16 nextKeyLength);
 
 			status_t			_FindFreeDuplicateFragment(
 									Transaction& transaction,
@@ -313,6 +322,7 @@ private:
 
 private:
 			friend class TreeIterator;
+			friend class TreeBuilder;
 			friend class CachedNode;
 			friend class TreeCheck;
 
@@ -381,6 +391,68 @@ private:
 };
 
 
+/*!	Builds a B+tree bottom-up from keys that are passed in ascending order,
+	which is a lot faster than inserting them one by one, and produces
+	completely filled nodes. The tree must be empty, and must not be used
+	otherwise until Finish() has been called.
+*/
+class TreeBuilder {
+public:
+								TreeBuilder(BPlusTree* tree);
+								~TreeBuilder();
+
+			status_t			InitCheck() const { return fStatus; }
+
+			status_t			Add(const uint8* key, uint16 keyLength,
+									off_t value);
+			status_t			Finish();
+
+private:
+	static	const uint32		kMaxLevels = 16;
+	static	const uint32		kNodesPerTransaction = 1024;
+
+			struct Level {
+				bplustree_node*	node;
+				off_t			offset;
+			};
+
+			status_t			_StartTransaction();
+			status_t			_NodeWritten();
+			status_t			_AllocateNode(off_t* _offset);
+			status_t			_WriteNode(const Level& level);
+			status_t			_MakeRoom(uint32 level, const uint8* key,
+									uint16 keyLength);
+			status_t			_SealNode(uint32 level, const uint8* nextKey,
+									uint16 nextKeyLength);
+			status_t			_AddKey(uint32 level, const uint8* key,
+									uint16 keyLength, off_t value);
+			status_t			_FlushKey();
+			status_t			_WriteFragment(off_t& _link);
+			status_t			_WriteDuplicateNode(bool last);
+
+private:
+			BPlusTree*			fTree;
+			Transaction			fTransaction;
+			Level				fLevels[kMaxLevels];
+			uint32				fLevelCount;
+			uint32				fWrittenNodes;
+
+			uint8				fKey[BPLUSTREE_MAX_KEY_LENGTH];
+			uint16				fKeyLength;
+			bool				fHasKey;
+			off_t				fValues[NUM_DUPLICATE_VALUES];
+			int32				fValueCount;
+
+			off_t				fDuplicateLink;
+			off_t				fDuplicateOffset;
+			off_t				fLastDuplicateOffset;
+			off_t				fFragmentOffset;
+			uint32				fFragmentIndex;
+
+			status_t			fStatus;
+};
+
+
 //	#pragma mark - BPlusTree's inline functions
 //	(most of them may not be needed)
 
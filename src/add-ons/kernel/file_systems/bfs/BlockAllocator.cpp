@@ -9,6 +9,8 @@
 
 #include "BlockAllocator.h"
 
+#include <algorithm>
+
 #include "bfs_control.h"
 #include "BPlusTree.h"
 #include "Debug.h"
@@ -169,16 +171,123 @@ private:
 #endif
 
 
+struct index_entry {
+	off_t				value;
+	uint16				length;
+	uint8				key[0];
+};
+
+
+struct index_entry_less {
+	index_entry_less(BPlusTree* tree)
+		:
+		fTree(tree)
+	{
+	}
+
+	bool operator()(const index_entry* a, const index_entry* b) const
+	{
+		int32 compare = fTree->CompareKeys(a->key, a->length, b->key,
+			b->length);
+		if (compare != 0)
+			return compare < 0;
+
+		return a->value < b->value;
+	}
+
+private:
+	BPlusTree*			fTree;
+};
+
+
+// The kernel heap the entries of a single index may use while it is rebuilt
+static const size_t kMaxIndexEntryMemory = 4 * 1024 * 1024;
+
+
+/*!	An index that is rebuilt during the second pass of the file system check.
+	Its entries are collected in memory, so that the index can be bulk loaded
+	in sorted order at the end. If they would use more than
+	kMaxIndexEntryMemory, or there is not enough memory for them, they are
+	inserted directly instead.
+*/
 struct check_index {
 	check_index()
 		:
-		inode(NULL)
+		inode(NULL),
+		entries(NULL),
+		entry_count(0),
+		entry_capacity(0),
+		entry_memory(0),
+		insert_directly(false)
 	{
 	}
 
+	~check_index()
+	{
+		FreeEntries();
+	}
+
+	status_t AddEntry(const uint8* key, uint16 keyLength, off_t value)
+	{
+		if (keyLength < BPLUSTREE_MIN_KEY_LENGTH
+			|| keyLength > BPLUSTREE_MAX_KEY_LENGTH)
+			return B_BAD_VALUE;
+
+		size_t entrySize = sizeof(index_entry) + keyLength;
+		if (entry_memory + entrySize > kMaxIndexEntryMemory)
+			return B_NO_MEMORY;
+
+		if (entry_count == entry_capacity) {
+			int32 capacity = entry_capacity > 0 ? entry_capacity * 2 : 1024;
+			if (entry_memory + entrySize
+					+ (capacity - entry_capacity) * sizeof(index_entry*)
+					> kMaxIndexEntryMemory)
+				return B_NO_MEMORY;
+
+			index_entry** newEntries = (index_entry**)realloc(entries,
+				capacity * sizeof(index_entry*));
+			if (newEntries == NULL)
+				return B_NO_MEMORY;
+
+			entry_memory += (capacity - entry_capacity) * sizeof(index_entry*);
+			entries = newEntries;
+			entry_capacity = capacity;
+		}
+
+		index_entry* entry = (index_entry*)malloc(entrySize);
+		if (entry == NULL)
+			return B_NO_MEMORY;
+
+		entry_memory += entrySize;
+
+		entry->value = value;
+		entry->length = keyLength;
+		memcpy(entry->key, key, keyLength);
+
+		entries[entry_count++] = entry;
+		return B_OK;
+	}
+
+	void FreeEntries()
+	{
+		for (int32 i = 0; i < entry_count; i++)
+			free(entries[i]);
+
+		free(entries);
+		entries = NULL;
+		entry_count = 0;
+		entry_capacity = 0;
+		entry_memory = 0;
+	}
+
 	char				name[B_FILE_NAME_LENGTH];
 	block_run			run;
 	Inode*				inode;
+	index_entry**		entries;
+	int32				entry_count;
+	int32				entry_capacity;
+	size_t				entry_memory;
+	bool				insert_directly;
 };
 
 
@@ -1300,6 +1409,7 @@ BlockAllocator::StopChecking(check_control* control)
 			break;
 
 		case BFS_CHECK_PASS_INDEX:
+			_WriteBackIndices();
 			_FreeIndices();
 			break;
 	}
@@ -2068,6 +2178,7 @@ BlockAllocator::_FreeIndices()
 			put_vnode(fVolume->FSVolume(),
 				fVolume->ToVnode(index->inode->BlockRun()));
 		}
+		delete index;
 	}
 	fCheckCookie->indices.MakeEmpty();
 }
@@ -2083,39 +2194,62 @@ BlockAllocator::_AddInodeToIndex(Inode* inode)
 		if (index->inode == NULL)
 			continue;
 
-		index->inode->WriteLockInTransaction(transaction);
-
-		BPlusTree* tree = index->inode->Tree();
-		if (tree == NULL)
-			return B_ERROR;
-
-		status_t status = B_OK;
+		uint8 key[BPLUSTREE_MAX_KEY_LENGTH];
+		uint16 keyLength;
 
 		if (!strcmp(index->name, "name")) {
-			if (inode->InNameIndex()) {
-				char name[B_FILE_NAME_LENGTH];
-				if (inode->GetName(name, B_FILE_NAME_LENGTH) != B_OK)
-					return B_ERROR;
+			if (!inode->InNameIndex())
+				continue;
 
-				status = tree->Insert(transaction, name, inode->ID());
-			}
+			if (inode->GetName((char*)key, sizeof(key)) != B_OK)
+				return B_ERROR;
+
+			keyLength = strlen((char*)key);
 		} else if (!strcmp(index->name, "last_modified")) {
-			if (inode->InLastModifiedIndex()) {
-				status = tree->Insert(transaction, inode->OldLastModified(),
-					inode->ID());
-			}
+			if (!inode->InLastModifiedIndex())
+				continue;
+
+			int64 lastModified = inode->OldLastModified();
+			memcpy(key, &lastModified, sizeof(int64));
+			keyLength = sizeof(int64);
 		} else if (!strcmp(index->name, "size")) {
-			if (inode->InSizeIndex())
-				status = tree->Insert(transaction, inode->Size(), inode->ID());
+			if (!inode->InSizeIndex())
+				continue;
+
+			int64 size = inode->Size();
+			memcpy(key, &size, sizeof(int64));
+			keyLength = sizeof(int64);
 		} else {
-			uint8 key[BPLUSTREE_MAX_KEY_LENGTH];
-			size_t keyLength = BPLUSTREE_MAX_KEY_LENGTH;
+			size_t length = BPLUSTREE_MAX_KEY_LENGTH;
 			if (inode->ReadAttribute(index->name, B_ANY_TYPE, 0, key,
-					&keyLength) == B_OK) {
-				status = tree->Insert(transaction, key, keyLength, inode->ID());
+					&length) != B_OK)
+				continue;
+
+			keyLength = length;
+		}
+
+		status_t status = B_OK;
+
+		if (!index->insert_directly) {
+			status = index->AddEntry(key, keyLength, inode->ID());
+			if (status == B_NO_MEMORY) {
+				// Too many entries to collect, insert them one by one
+				status = _InsertIndexEntries(transaction, index);
+				if (status != B_OK)
+					return status;
 			}
 		}
 
+		if (index->insert_directly) {
+			index->inode->WriteLockInTransaction(transaction);
+
+			BPlusTree* tree = index->inode->Tree();
+			if (tree == NULL)
+				return B_ERROR;
+
+			status = tree->Insert(transaction, key, keyLength, inode->ID());
+		}
+
 		if (status != B_OK)
 			return status;
 	}
@@ -2124,6 +2258,76 @@ BlockAllocator::_AddInodeToIndex(Inode* inode)
 }
 
 
+/*!	Inserts all entries collected so far into the \a index, in sorted order
+	so that the tree is walked sequentially, and lets all further entries
+	be inserted directly.
+*/
+status_t
+BlockAllocator::_InsertIndexEntries(Transaction& transaction,
+	check_index* index)
+{
+	index->inode->WriteLockInTransaction(transaction);
+
+	BPlusTree* tree = index->inode->Tree();
+	if (tree == NULL)
+		return B_ERROR;
+
+	std::sort(index->entries, index->entries + index->entry_count,
+		index_entry_less(tree));
+
+	for (int32 i = 0; i < index->entry_count; i++) {
+		index_entry* entry = index->entries[i];
+		status_t status = tree->Insert(transaction, entry->key, entry->length,
+			entry->value);
+		if (status != B_OK)
+			return status;
+	}
+
+	index->FreeEntries();
+	index->insert_directly = true;
+	return B_OK;
+}
+
+
+/*!	Bulk loads the indices from the entries collected during the index pass,
+	which is much faster than inserting them one by one, and results in
+	fewer, but completely filled nodes.
+*/
+void
+BlockAllocator::_WriteBackIndices()
+{
+	for (int32 i = 0; i < fCheckCookie->indices.CountItems(); i++) {
+		check_index* index = fCheckCookie->indices.Array()[i];
+		if (index->inode == NULL || index->insert_directly)
+			continue;
+
+		BPlusTree* tree = index->inode->Tree();
+		if (tree == NULL)
+			continue;
+
+		std::sort(index->entries, index->entries + index->entry_count,
+			index_entry_less(tree));
+
+		TreeBuilder builder(tree);
+		status_t status = builder.InitCheck();
+
+		for (int32 j = 0; status == B_OK && j < index->entry_count; j++) {
+			index_entry* entry = index->entries[j];
+			status = builder.Add(entry->key, entry->length, entry->value);
+		}
+		if (status == B_OK)
+			status = builder.Finish();
+
+		if (status != B_OK) {
+			FATAL(("check: Could not rebuild index \"%s\": %s\n", index->name,
+				strerror(status)));
+		}
+
+		index->FreeEntries();
+	}
+}
+
+
 //	#pragma mark - debugger commands
 
 
@@ -18,6 +18,7 @@ struct disk_super_block;
 struct block_run;
 struct check_control;
 struct check_cookie;
+struct check_index;
 
 
 //#define DEBUG_ALLOCATION_GROUPS
@@ -80,6 +81,9 @@ private:
 			status_t		_PrepareIndices();
 			void			_FreeIndices();
 			status_t		_AddInodeToIndex(Inode* inode);
+			status_t		_InsertIndexEntries(Transaction& transaction,
+								check_index* index);
+			void			_WriteBackIndices();
 			status_t		_WriteBackCheckBitmap();
 
 	static	status_t		_Initialize(BlockAllocator* self);
@@ -2343,8 +2343,20 @@ Inode::Free(Transaction& transaction)
 status_t
 Inode::Sync()
 {
-	if (FileCache())
-		return file_cache_sync(FileCache());
+	if (FileCache()) {
+		status_t status = file_cache_sync(FileCache());
+		if (status != B_OK)
+			return status;
+
+		// the data is on disk now, make sure the inode is as well
+		return fVolume->GetJournal(0)->FlushLog();
+	}
+
+	// The blocks of unwritten transactions can't be written back before
+	// they are in the log
+	status_t status = fVolume->GetJournal(0)->FlushLog();
+	if (status != B_OK)
+		return status;
 
 	// We may also want to flush the attribute's data stream to
 	// disk here... (do we?)
@@ -2355,7 +2367,6 @@ Inode::Sync()
 	InodeReadLocker locker(this);
 
 	data_stream* data = &Node().data;
-	status_t status = B_OK;
 
 	// flush direct range
 
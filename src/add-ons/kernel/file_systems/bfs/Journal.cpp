@@ -13,6 +13,11 @@
 #include "Inode.h"
 
 
+// Transactions are batched together, and written to the log as a single
+// entry; this limits how long a finished transaction may stay unwritten.
+static const bigtime_t kMaxUnwrittenTime = 1000000LL;
+
+
 struct run_array {
 	int32		count;
 	int32		max_runs;
@@ -404,6 +409,7 @@ Journal::Journal(Volume* volume)
 	fMaxTransactionSize(fLogSize / 2 - 5),
 	fUsed(0),
 	fUnwrittenTransactions(0),
+	fUnwrittenSince(0),
 	fHasSubtransaction(false),
 	fSeparateSubTransactions(false)
 {
@@ -750,6 +756,7 @@ Journal::_WriteTransactionToLog()
 			fTransactionID = cache_detach_sub_transaction(fVolume->BlockCache(),
 				fTransactionID, NULL, NULL);
 			fUnwrittenTransactions = 1;
+			fUnwrittenSince = system_time();
 		} else {
 			cache_end_transaction(fVolume->BlockCache(), fTransactionID, NULL,
 				NULL);
@@ -881,6 +888,7 @@ Journal::_WriteTransactionToLog()
 		fTransactionID = cache_detach_sub_transaction(fVolume->BlockCache(),
 			fTransactionID, _TransactionWritten, logEntry);
 		fUnwrittenTransactions = 1;
+		fUnwrittenSince = system_time();
 
 		if (status == B_OK && _TransactionSize() > fLogSize) {
 			// If the transaction is too large after writing, there is no way to
@@ -932,6 +940,20 @@ Journal::_FlushLog(bool canWait, bool flushBlocks)
 }
 
 
+/*!	Writes all transactions that have been finished so far to the log, but
+	leaves writing back their blocks to the cache. Afterwards, the changes
+	they made will survive a crash.
+	Since transactions are only finished under the journal lock, concurrent
+	callers are served by a single log write: whoever gets the lock after it
+	finds nothing left to write.
+*/
+status_t
+Journal::FlushLog()
+{
+	return _FlushLog(true, false);
+}
+
+
 /*!	Flushes the current log entry to disk, and also writes back all dirty
 	blocks for this volume (completing all open transactions).
 */
@@ -1056,16 +1078,22 @@ Journal::_TransactionDone(bool success)
 		return B_OK;
 	}
 
-	// Up to a maximum size, we will just batch several
-	// transactions together to improve speed
+	// Up to a maximum size, we will just batch several transactions
+	// together to improve speed. Unless someone explicitly asks for it, the
+	// log is written when the transaction becomes idle, or when the oldest
+	// transaction in the batch has waited long enough.
 	uint32 size = _TransactionSize();
-	if (size < fMaxTransactionSize) {
+	bigtime_t now = system_time();
+	if (size < fMaxTransactionSize
+		&& (fUnwrittenTransactions == 0
+			|| now - fUnwrittenSince < kMaxUnwrittenTime)) {
 		// Flush the log from time to time, so that we have enough space
 		// for this transaction
 		if (size > FreeLogBlocks())
 			cache_sync_transaction(fVolume->BlockCache(), fTransactionID);
 
-		fUnwrittenTransactions++;
+		if (fUnwrittenTransactions++ == 0)
+			fUnwrittenSince = now;
 		return B_OK;
 	}
 
@@ -1090,6 +1118,7 @@ Journal::Dump()
 	kprintf("  max transaction size: %lu\n", fMaxTransactionSize);
 	kprintf("  used:                 %lu\n", fUsed);
 	kprintf("  unwritten:            %ld\n", fUnwrittenTransactions);
+	kprintf("  unwritten since:      %lld\n", fUnwrittenSince);
 	kprintf("  timestamp:            %lld\n", fTimestamp);
 	kprintf("  transaction ID:       %ld\n", fTransactionID);
 	kprintf("  has subtransaction:   %d\n", fHasSubtransaction);
@@ -35,6 +35,7 @@ public:
 			size_t			CurrentTransactionSize() const;
 			bool			CurrentTransactionTooLarge() const;
 
+			status_t		FlushLog();
 			status_t		FlushLogAndBlocks();
 			Volume*			GetVolume() const { return fVolume; }
 			int32			TransactionID() const { return fTransactionID; }
@@ -68,6 +69,7 @@ private:
 			uint32			fMaxTransactionSize;
 			uint32			fUsed;
 			int32			fUnwrittenTransactions;
+			bigtime_t		fUnwrittenSince;
 			mutex			fEntriesLock;
 			LogEntryList	fEntries;
 			bigtime_t		fTimestamp;
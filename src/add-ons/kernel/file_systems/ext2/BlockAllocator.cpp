@@ -52,6 +52,8 @@ public:
 			fsblock_t	LargestStart() const;
 			uint32		LargestLength() const;
 
+			uint32		FreeRangeLength(fsblock_t start, uint32 maximum);
+
 			// TransactionListener implementation
 			void		TransactionDone(bool success);
 			void		RemovedFromTransaction();
@@ -385,6 +387,33 @@ AllocationBlockGroup::LargestLength() const
 }
 
 
+/*!	Returns how many blocks starting at \a start are free, up to \a maximum.
+	This allows an allocation to continue exactly where the previous one of
+	the same file ended.
+*/
+uint32
+AllocationBlockGroup::FreeRangeLength(fsblock_t _start, uint32 maximum)
+{
+	if (IsFull() || _start < fStart || _start >= fStart + fNumBits)
+		return 0;
+	if ((fGroupDescriptor->Flags() & EXT2_BLOCK_GROUP_BLOCK_UNINIT) != 0)
+		return 0;
+
+	uint32 start = _start - fStart;
+	if (start >= fLargestStart && start < fLargestStart + fLargestLength)
+		return min_c(fLargestStart + fLargestLength - start, maximum);
+
+	BitmapBlock block(fVolume, fNumBits);
+	if (!block.SetTo(fBitmapBlock))
+		return 0;
+
+	uint32 end = start;
+	block.FindNextMarked(end);
+
+	return min_c(end - start, maximum);
+}
+
+
 void
 AllocationBlockGroup::_AddFreeRange(uint32 start, uint32 length)
 {
@@ -601,6 +630,23 @@ BlockAllocator::AllocateBlocks(Transaction& transaction, uint32 minimum,
 		"max: %lu, block group: %lu, start: %llu, num groups: %lu\n",
 		transaction.ID(), minimum, maximum, blockGroup, start, fNumGroups);
 
+	if (blockGroup < fNumGroups && start != 0) {
+		// Try to continue at the goal block first, so that the file stays
+		// contiguous
+		uint32 goalLength = fGroups[blockGroup].FreeRangeLength(start,
+			maximum);
+		if (goalLength > 0 && goalLength >= minimum) {
+			TRACE("BlockAllocator::AllocateBlocks(): Allocating at goal "
+				"%llu-%llu\n", start, start + goalLength);
+			status_t status = fGroups[blockGroup].Allocate(transaction, start,
+				goalLength);
+			if (status == B_OK) {
+				length = goalLength;
+				return B_OK;
+			}
+		}
+	}
+
 	fsblock_t bestStart = 0;
 	uint32 bestLength = 0;
 	uint32 bestGroup = 0;
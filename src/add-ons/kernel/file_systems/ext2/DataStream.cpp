@@ -186,6 +186,15 @@ DataStream::Enlarge(Transaction& transaction, off_t& numBlocks)
 	fWaiting = _BlocksNeeded(numBlocks);
 	numBlocks = fWaiting;
 
+	if (fNumBlocks > 0) {
+		// continue right after the last block, if possible
+		fsblock_t lastBlock;
+		if (FindBlock((fNumBlocks - 1) << fVolume->BlockShift(), lastBlock)
+				== B_OK && lastBlock != 0) {
+			fAllocatedPos = lastBlock + 1;
+		}
+	}
+
 	status_t status;
 
 	if (fNumBlocks <= kMaxDirect) {
@@ -368,6 +377,16 @@ DataStream::_BlocksNeeded(off_t numBlocks)
 }
 
 
+/*!	Sets the block near which the data of an empty stream should be
+	allocated.
+*/
+void
+DataStream::SetAllocationGoal(fsblock_t goal)
+{
+	fAllocatedPos = goal;
+}
+
+
 status_t
 DataStream::_GetBlock(Transaction& transaction, uint32& blockNum)
 {
@@ -144,6 +144,23 @@ ExtentStream::Enlarge(Transaction& transaction, off_t& numBlocks)
 	numBlocks = targetBlocks - fNumBlocks;
 	uint32 allocated = 0;
 
+	if (fStream->extent_header.NumEntries() > 0) {
+		// continue right after the last extent, if possible
+		ext2_extent_stream *stream = fStream;
+		CachedBlock cached(fVolume);
+		while (stream->extent_header.Depth() != 0) {
+			stream = (ext2_extent_stream *)cached.SetTo(stream->extent_index[
+				stream->extent_header.NumEntries() - 1].PhysicalBlock());
+			if (stream == NULL)
+				return B_IO_ERROR;
+		}
+		if (stream->extent_header.NumEntries() > 0) {
+			ext2_extent_entry &last = stream->extent_entries[
+				stream->extent_header.NumEntries() - 1];
+			fAllocatedPos = last.PhysicalBlock() + last.Length();
+		}
+	}
+
 	while (fNumBlocks < targetBlocks) {
 		// allocate new blocks
 		uint32 blockGroup = (fAllocatedPos - fFirstBlock)
@@ -454,6 +471,17 @@ ExtentStream::Shrink(Transaction& transaction, off_t& numBlocks)
 }
 
 
+/*!	Sets the block near which the data of an empty stream should be
+	allocated. Once the stream has blocks, Enlarge() continues after its
+	last extent instead.
+*/
+void
+ExtentStream::SetAllocationGoal(fsblock_t goal)
+{
+	fAllocatedPos = goal;
+}
+
+
 void
 ExtentStream::Init()
 {
@@ -27,6 +27,7 @@ public:
 						uint32 *_count = NULL);
 	status_t		Enlarge(Transaction& transaction, off_t& numBlocks);
 	status_t		Shrink(Transaction& transaction, off_t& numBlocks);
+	void			SetAllocationGoal(fsblock_t goal);
 	void			Init();
 	
 	bool			Check();
@@ -824,13 +824,20 @@ Inode::_EnlargeDataStream(Transaction& transaction, off_t size)
 		return B_OK;
 	}
 
+	// New files start in the block group of their inode
+	fsblock_t goal = fVolume->FirstDataBlock()
+		+ (fsblock_t)((ID() - 1) / fVolume->InodesPerGroup())
+			* fVolume->BlocksPerGroup();
+
 	off_t end = size == 0 ? 0 : (size - 1) / fVolume->BlockSize() + 1;
 	if (Flags() & EXT2_INODE_EXTENTS) {
 		ExtentStream stream(fVolume, &fNode.extent_stream, Size());
+		stream.SetAllocationGoal(goal);
 		stream.Enlarge(transaction, end);
 		ASSERT(stream.Check());
 	} else {
 		DataStream stream(fVolume, &fNode.stream, oldSize);
+		stream.SetAllocationGoal(goal);
 		stream.Enlarge(transaction, end);
 	}
 	TRACE("Inode::_EnlargeDataStream(): Setting size to %lld\n", size);
@@ -0,0 +1,270 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "ChunkCacheKernel.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+
+#include <util/AutoLock.h>
+
+#ifdef _KERNEL_MODE
+#	include <low_resource_manager.h>
+#endif
+
+#include "DebugSupport.h"
+
+
+static const size_t kInitialChunkTableSize = 256;
+
+
+struct ChunkCacheKernel::ChunkKey {
+	uint64	cacheID;
+	uint64	offset;
+
+	ChunkKey(uint64 cacheID, uint64 offset)
+		:
+		cacheID(cacheID),
+		offset(offset)
+	{
+	}
+};
+
+
+struct ChunkCacheKernel::Chunk : DoublyLinkedListLinkImpl<Chunk> {
+	Chunk*	hashNext;
+	uint64	cacheID;
+	uint64	offset;
+	size_t	size;
+
+	uint8* Data()
+	{
+		return (uint8*)(this + 1);
+	}
+
+	size_t MemorySize() const
+	{
+		return sizeof(Chunk) + size;
+	}
+};
+
+
+struct ChunkCacheKernel::ChunkHashDefinition {
+	typedef ChunkKey	KeyType;
+	typedef	Chunk		ValueType;
+
+	size_t HashKey(const ChunkKey& key) const
+	{
+		return (size_t)(key.cacheID * 31 + (key.offset >> 10)
+			+ (key.offset >> 42));
+	}
+
+	size_t Hash(const Chunk* value) const
+	{
+		return HashKey(ChunkKey(value->cacheID, value->offset));
+	}
+
+	bool Compare(const ChunkKey& key, const Chunk* value) const
+	{
+		return value->cacheID == key.cacheID && value->offset == key.offset;
+	}
+
+	Chunk*& GetLink(Chunk* value) const
+	{
+		return value->hashNext;
+	}
+};
+
+
+ChunkCacheKernel::ChunkCacheKernel(size_t maxSize)
+	:
+	fChunks(NULL),
+	fSize(0),
+	fMaxSize(maxSize)
+{
+	mutex_init(&fLock, "packagefs chunk cache");
+}
+
+
+ChunkCacheKernel::~ChunkCacheKernel()
+{
+#ifdef _KERNEL_MODE
+	if (fChunks != NULL)
+		unregister_low_resource_handler(&_LowResourceHandler, this);
+#endif
+
+	if (fChunks != NULL) {
+		_EvictChunks(0);
+		delete fChunks;
+	}
+
+	mutex_destroy(&fLock);
+}
+
+
+status_t
+ChunkCacheKernel::Init()
+{
+	fChunks = new(std::nothrow) ChunkTable;
+	if (fChunks == NULL)
+		RETURN_ERROR(B_NO_MEMORY);
+
+	status_t error = fChunks->Init(kInitialChunkTableSize);
+	if (error != B_OK) {
+		delete fChunks;
+		fChunks = NULL;
+		RETURN_ERROR(error);
+	}
+
+#ifdef _KERNEL_MODE
+	register_low_resource_handler(&_LowResourceHandler, this,
+		B_KERNEL_RESOURCE_PAGES | B_KERNEL_RESOURCE_MEMORY, 0);
+#endif
+
+	return B_OK;
+}
+
+
+bool
+ChunkCacheKernel::LookupChunk(uint64 cacheID, uint64 offset, void* buffer,
+	size_t size)
+{
+	MutexLocker locker(fLock);
+
+	Chunk* chunk = fChunks->Lookup(ChunkKey(cacheID, offset));
+	if (chunk == NULL || chunk->size != size)
+		return false;
+
+	// mark the chunk most recently used
+	fUnusedChunks.Remove(chunk);
+	fUnusedChunks.Add(chunk);
+
+	memcpy(buffer, chunk->Data(), size);
+	return true;
+}
+
+
+void
+ChunkCacheKernel::AddChunk(uint64 cacheID, uint64 offset, const void* buffer,
+	size_t size)
+{
+	if (sizeof(Chunk) + size > fMaxSize)
+		return;
+
+#ifdef _KERNEL_MODE
+	// don't make things worse when memory is already tight
+	if (low_resource_state(B_KERNEL_RESOURCE_PAGES | B_KERNEL_RESOURCE_MEMORY)
+			!= B_NO_LOW_RESOURCE) {
+		return;
+	}
+#endif
+
+	Chunk* chunk = (Chunk*)malloc(sizeof(Chunk) + size);
+	if (chunk == NULL)
+		return;
+
+	new(chunk) Chunk;
+	chunk->cacheID = cacheID;
+	chunk->offset = offset;
+	chunk->size = size;
+	memcpy(chunk->Data(), buffer, size);
+
+	MutexLocker locker(fLock);
+
+	// someone else might have been faster
+	if (fChunks->Lookup(ChunkKey(cacheID, offset)) != NULL) {
+		locker.Unlock();
+		free(chunk);
+		return;
+	}
+
+	_EvictChunks(fMaxSize - chunk->MemorySize());
+
+	if (fChunks->Insert(chunk) != B_OK) {
+		locker.Unlock();
+		free(chunk);
+		return;
+	}
+
+	fUnusedChunks.Add(chunk);
+	fSize += chunk->MemorySize();
+}
+
+
+/*!	Removes all chunks of the given cache ID, i.e. of a package that is
+	going away.
+*/
+void
+ChunkCacheKernel::RemoveChunks(uint64 cacheID)
+{
+	MutexLocker locker(fLock);
+
+	ChunkList::Iterator it = fUnusedChunks.GetIterator();
+	while (Chunk* chunk = it.Next()) {
+		if (chunk->cacheID == cacheID)
+			_RemoveChunk(chunk);
+	}
+}
+
+
+/*!	Removes the chunk from the cache and frees it. The iterator of the chunk
+	list remains valid.
+	The cache must be locked.
+*/
+void
+ChunkCacheKernel::_RemoveChunk(Chunk* chunk)
+{
+	fChunks->RemoveUnchecked(chunk);
+	fUnusedChunks.Remove(chunk);
+	fSize -= chunk->MemorySize();
+	free(chunk);
+}
+
+
+/*!	Removes the least recently used chunks, until the cache doesn't use more
+	than \a maxSize bytes anymore.
+	The cache must be locked.
+*/
+void
+ChunkCacheKernel::_EvictChunks(size_t maxSize)
+{
+	while (fSize > maxSize) {
+		Chunk* chunk = fUnusedChunks.Head();
+		if (chunk == NULL)
+			break;
+
+		_RemoveChunk(chunk);
+	}
+}
+
+
+#ifdef _KERNEL_MODE
+
+
+/*static*/ void
+ChunkCacheKernel::_LowResourceHandler(void* data, uint32 resources,
+	int32 level)
+{
+	ChunkCacheKernel* cache = (ChunkCacheKernel*)data;
+
+	MutexLocker locker(cache->fLock);
+
+	switch (level) {
+		case B_NO_LOW_RESOURCE:
+			break;
+		case B_LOW_RESOURCE_NOTE:
+			cache->_EvictChunks(cache->fSize / 2);
+			break;
+		default:
+			cache->_EvictChunks(0);
+			break;
+	}
+}
+
+
+#endif	// _KERNEL_MODE
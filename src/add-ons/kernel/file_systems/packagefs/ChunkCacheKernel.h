@@ -0,0 +1,63 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef CHUNK_CACHE_KERNEL_H
+#define CHUNK_CACHE_KERNEL_H
+
+
+#include <lock.h>
+#include <util/DoublyLinkedList.h>
+#include <util/OpenHashTable.h>
+
+#include <package/hpkg/ChunkCache.h>
+
+
+using BPackageKit::BHPKG::BPrivate::ChunkCache;
+
+
+/*!	A size bounded LRU cache of uncompressed chunks, shared by all package
+	files. Chunks are released when memory gets low.
+*/
+class ChunkCacheKernel : public ChunkCache {
+public:
+								ChunkCacheKernel(size_t maxSize);
+	virtual						~ChunkCacheKernel();
+
+			status_t			Init();
+
+	virtual	bool				LookupChunk(uint64 cacheID, uint64 offset,
+									void* buffer, size_t size);
+	virtual	void				AddChunk(uint64 cacheID, uint64 offset,
+									const void* buffer, size_t size);
+
+			void				RemoveChunks(uint64 cacheID);
+
+private:
+			struct Chunk;
+			struct ChunkKey;
+			struct ChunkHashDefinition;
+
+			typedef BOpenHashTable<ChunkHashDefinition> ChunkTable;
+			typedef DoublyLinkedList<Chunk> ChunkList;
+
+private:
+			void				_RemoveChunk(Chunk* chunk);
+			void				_EvictChunks(size_t maxSize);
+
+#ifdef _KERNEL_MODE
+	static	void				_LowResourceHandler(void* data,
+									uint32 resources, int32 level);
+#endif
+
+private:
+			mutex				fLock;
+			ChunkTable*			fChunks;
+			ChunkList			fUnusedChunks;
+									// least recently used first
+			size_t				fSize;
+			size_t				fMaxSize;
+};
+
+
+#endif	// CHUNK_CACHE_KERNEL_H
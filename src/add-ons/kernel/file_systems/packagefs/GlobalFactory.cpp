@@ -12,6 +12,7 @@
 
 
 static const uint32 kMaxCachedBuffers = 32;
+static const size_t kMaxChunkCacheSize = 16 * 1024 * 1024;
 
 /*static*/ GlobalFactory* GlobalFactory::sDefaultInstance = NULL;
 
@@ -19,6 +20,8 @@ static const uint32 kMaxCachedBuffers = 32;
 GlobalFactory::GlobalFactory()
 	:
 	fBufferCache(B_HPKG_DEFAULT_DATA_CHUNK_SIZE_ZLIB, kMaxCachedBuffers),
+	fChunkCache(kMaxChunkCacheSize),
+	fNextChunkCacheID(1),
 	fPackageDataReaderFactory(&fBufferCache)
 {
 }
@@ -65,12 +68,34 @@ GlobalFactory::Default()
 }
 
 
+/*!	Creates a reader for the given package data. Uncompressed chunks are
+	cached under \a chunkCacheID, which must be unique for the package file
+	the data belongs to, or 0, if the chunks shall not be cached.
+*/
 status_t
 GlobalFactory::CreatePackageDataReader(BDataReader* dataReader,
-	const BPackageData& data, BPackageDataReader*& _reader)
+	const BPackageData& data, uint64 chunkCacheID,
+	BPackageDataReader*& _reader)
 {
 	return fPackageDataReaderFactory.CreatePackageDataReader(dataReader, data,
-		_reader);
+		chunkCacheID != 0 ? &fChunkCache : NULL, chunkCacheID, _reader);
+}
+
+
+/*!	Returns a new ID for the chunk cache. IDs are never reused, so that no
+	stale chunks of a removed package can be found for another one.
+*/
+uint64
+GlobalFactory::NextChunkCacheID()
+{
+	return atomic_add64(&fNextChunkCacheID, 1);
+}
+
+
+void
+GlobalFactory::RemoveCachedChunks(uint64 chunkCacheID)
+{
+	fChunkCache.RemoveChunks(chunkCacheID);
 }
 
 
@@ -81,5 +106,9 @@ GlobalFactory::_Init()
 	if (error != B_OK)
 		return error;
 
+	error = fChunkCache.Init();
+	if (error != B_OK)
+		return error;
+
 	return B_OK;
 }
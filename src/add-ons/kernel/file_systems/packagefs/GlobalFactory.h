@@ -10,6 +10,7 @@
 #include <package/hpkg/PackageDataReader.h>
 
 #include "BlockBufferCacheKernel.h"
+#include "ChunkCacheKernel.h"
 
 
 using BPackageKit::BHPKG::BDataReader;
@@ -31,8 +32,12 @@ public:
 
 			status_t			CreatePackageDataReader(BDataReader* dataReader,
 									const BPackageData& data,
+									uint64 chunkCacheID,
 									BPackageDataReader*& _reader);
 
+			uint64				NextChunkCacheID();
+			void				RemoveCachedChunks(uint64 chunkCacheID);
+
 private:
 			status_t			_Init();
 
@@ -40,6 +45,8 @@ private:
 	static	GlobalFactory*		sDefaultInstance;
 
 			BlockBufferCacheKernel fBufferCache;
+			ChunkCacheKernel	fChunkCache;
+			vint64				fNextChunkCacheID;
 			BPackageDataReaderFactory fPackageDataReaderFactory;
 };
 
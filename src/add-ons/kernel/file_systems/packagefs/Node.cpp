@@ -11,6 +11,7 @@
 
 #include "DebugSupport.h"
 #include "EmptyAttributeDirectoryCookie.h"
+#include "StringPool.h"
 
 
 Node::Node(ino_t id)
@@ -28,6 +29,8 @@ Node::~Node()
 {
 	if ((fFlags & NODE_FLAG_OWNS_NAME) != 0)
 		free(fName);
+	else if ((fFlags & NODE_FLAG_POOLED_NAME) != 0)
+		StringPool::Put(fName);
 
 	rw_lock_destroy(&fLock);
 }
@@ -43,10 +46,10 @@ Node::Init(Directory* parent, const char* name, uint32 flags)
 		|| (flags & NODE_FLAG_KEEP_NAME) != 0) {
 		fName = const_cast<char*>(name);
 	} else {
-		fName = strdup(name);
+		fName = const_cast<char*>(StringPool::Get(name));
 		if (fName == NULL)
 			RETURN_ERROR(B_NO_MEMORY);
-		fFlags |= NODE_FLAG_OWNS_NAME;
+		fFlags |= NODE_FLAG_POOLED_NAME;
 	}
 
 	return B_OK;
@@ -35,6 +35,8 @@ enum {
 	NODE_FLAG_OWNS_NAME		= NODE_FLAG_KEEP_NAME,
 	NODE_FLAG_KNOWN_TO_VFS	= 0x04,
 		// internal flag
+	NODE_FLAG_POOLED_NAME	= 0x08
+		// internal flag: the name has been obtained from the StringPool
 };
 
 
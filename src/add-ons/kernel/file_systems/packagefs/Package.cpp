@@ -15,7 +15,11 @@
 #include <util/AutoLock.h>
 
 #include "DebugSupport.h"
+#include "GlobalFactory.h"
+#include "PackageDirectory.h"
 #include "PackageDomain.h"
+#include "PackageFile.h"
+#include "PackageSymlink.h"
 #include "Version.h"
 
 
@@ -26,6 +30,46 @@ const char* const kArchitectureNames[B_PACKAGE_ARCHITECTURE_ENUM_COUNT] = {
 };
 
 
+static inline size_t
+string_memory(const char* string)
+{
+	return string != NULL ? strlen(string) + 1 : 0;
+}
+
+
+static void
+add_node_memory_usage(const PackageNode* node, PackageMemoryUsage& usage)
+{
+	usage.nodeCount++;
+
+	if (S_ISDIR(node->Mode())) {
+		usage.objectMemory += sizeof(PackageDirectory);
+
+		const PackageDirectory* directory
+			= static_cast<const PackageDirectory*>(node);
+		for (PackageNode* child = directory->FirstChild(); child != NULL;
+				child = directory->NextChild(child)) {
+			add_node_memory_usage(child, usage);
+		}
+	} else if (S_ISLNK(node->Mode())) {
+		usage.objectMemory += sizeof(PackageSymlink);
+		usage.sharedStringMemory += string_memory(
+			static_cast<const PackageSymlink*>(node)->SymlinkPath());
+	} else
+		usage.objectMemory += sizeof(PackageFile);
+
+	usage.sharedStringMemory += string_memory(node->Name());
+
+	for (PackageNodeAttributeList::ConstIterator it
+				= node->Attributes().GetIterator();
+			PackageNodeAttribute* attribute = it.Next();) {
+		usage.attributeCount++;
+		usage.objectMemory += sizeof(PackageNodeAttribute);
+		usage.sharedStringMemory += string_memory(attribute->Name());
+	}
+}
+
+
 Package::Package(PackageDomain* domain, dev_t deviceID, ino_t nodeID)
 	:
 	fDomain(domain),
@@ -38,7 +82,8 @@ Package::Package(PackageDomain* domain, dev_t deviceID, ino_t nodeID)
 	fFD(-1),
 	fOpenCount(0),
 	fNodeID(nodeID),
-	fDeviceID(deviceID)
+	fDeviceID(deviceID),
+	fChunkCacheID(GlobalFactory::Default()->NextChunkCacheID())
 {
 	mutex_init(&fLock, "packagefs package");
 }
@@ -60,6 +105,8 @@ Package::~Package()
 	free(fInstallPath);
 	delete fVersion;
 
+	GlobalFactory::Default()->RemoveCachedChunks(fChunkCacheID);
+
 	mutex_destroy(&fLock);
 }
 
@@ -197,3 +244,36 @@ Package::Close()
 		fFD = -1;
 	}
 }
+
+
+/*!	Computes the memory used by the package and its nodes. Doesn't lock
+	anything, so that it can be used from the kernel debugger; outside of it
+	the volume must be locked.
+*/
+void
+Package::GetMemoryUsage(PackageMemoryUsage& _usage) const
+{
+	memset(&_usage, 0, sizeof(_usage));
+
+	_usage.objectMemory = sizeof(Package) + string_memory(fFileName)
+		+ string_memory(fName) + string_memory(fInstallPath);
+	if (fVersion != NULL)
+		_usage.objectMemory += sizeof(::Version);
+
+	for (PackageNodeList::Iterator it = fNodes.GetIterator();
+			PackageNode* node = it.Next();) {
+		add_node_memory_usage(node, _usage);
+	}
+
+	for (ResolvableList::ConstIterator it = fResolvables.GetIterator();
+			Resolvable* resolvable = it.Next();) {
+		_usage.objectMemory += sizeof(Resolvable)
+			+ string_memory(resolvable->Name());
+	}
+
+	for (DependencyList::ConstIterator it = fDependencies.GetIterator();
+			Dependency* dependency = it.Next();) {
+		_usage.objectMemory += sizeof(Dependency)
+			+ string_memory(dependency->Name());
+	}
+}
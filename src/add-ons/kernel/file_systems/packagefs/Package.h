@@ -29,6 +29,17 @@ class PackageLinkDirectory;
 class Version;
 
 
+struct PackageMemoryUsage {
+	size_t	nodeCount;
+	size_t	attributeCount;
+	size_t	objectMemory;
+		// the package's own objects and strings
+	size_t	sharedStringMemory;
+		// the pooled strings referenced, which may be shared with other
+		// packages
+};
+
+
 class Package : public BReferenceable,
 	public DoublyLinkedListLinkImpl<Package> {
 public:
@@ -75,6 +86,12 @@ public:
 			int					Open();
 			void				Close();
 
+			uint64				ChunkCacheID() const
+									{ return fChunkCacheID; }
+
+			void				GetMemoryUsage(
+									PackageMemoryUsage& _usage) const;
+
 			const PackageNodeList& Nodes() const	{ return fNodes; }
 			const ResolvableList& Resolvables() const
 									{ return fResolvables; }
@@ -95,6 +112,7 @@ private:
 			Package*			fFileNameHashTableNext;
 			ino_t				fNodeID;
 			dev_t				fDeviceID;
+			uint64				fChunkCacheID;
 			PackageNodeList		fNodes;
 			ResolvableList		fResolvables;
 			DependencyList		fDependencies;
@@ -64,12 +64,14 @@ struct PackageFile::DataAccessor {
 		mutex_destroy(&fLock);
 	}
 
-	status_t Init(dev_t deviceID, ino_t nodeID, int fd)
+	status_t Init(dev_t deviceID, ino_t nodeID, int fd, uint64 chunkCacheID)
 	{
 		// create a BDataReader for the compressed data
 		if (fData->IsEncodedInline()) {
 			fDataReader = new(std::nothrow) BBufferDataReader(
 				fData->InlineData(), fData->CompressedSize());
+			chunkCacheID = 0;
+				// offsets are relative to the inline data, don't cache
 		} else
 			fDataReader = new(std::nothrow) BFDDataReader(fd);
 
@@ -78,7 +80,7 @@ struct PackageFile::DataAccessor {
 
 		// create a BPackageDataReader
 		status_t error = GlobalFactory::Default()->CreatePackageDataReader(
-			fDataReader, *fData, fReader);
+			fDataReader, *fData, chunkCacheID, fReader);
 		if (error != B_OK)
 			RETURN_ERROR(error);
 
@@ -164,7 +166,8 @@ PackageFile::VFSInit(dev_t deviceID, ino_t nodeID)
 	if (fDataAccessor == NULL)
 		RETURN_ERROR(B_NO_MEMORY);
 
-	status_t error = fDataAccessor->Init(deviceID, nodeID, fd);
+	status_t error = fDataAccessor->Init(deviceID, nodeID, fd,
+		fPackage->ChunkCacheID());
 	if (error != B_OK) {
 		delete fDataAccessor;
 		fDataAccessor = NULL;
@@ -6,10 +6,10 @@
 
 #include "PackageNode.h"
 
-#include <stdlib.h>
 #include <string.h>
 
 #include "DebugSupport.h"
+#include "StringPool.h"
 
 
 PackageNode::PackageNode(Package* package, mode_t mode)
@@ -29,7 +29,7 @@ PackageNode::~PackageNode()
 	while (PackageNodeAttribute* attribute = fAttributes.RemoveHead())
 		delete attribute;
 
-	free(fName);
+	StringPool::Put(fName);
 }
 
 
@@ -37,7 +37,7 @@ status_t
 PackageNode::Init(PackageDirectory* parent, const char* name)
 {
 	fParent = parent;
-	fName = strdup(name);
+	fName = StringPool::Get(name);
 	if (fName == NULL)
 		RETURN_ERROR(B_NO_MEMORY);
 
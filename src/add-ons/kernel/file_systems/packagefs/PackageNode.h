@@ -68,7 +68,7 @@ public:
 protected:
 			Package*			fPackage;
 			PackageDirectory*	fParent;
-			char*				fName;
+			const char*			fName;
 			mode_t				fMode;
 			uid_t				fUserID;
 			gid_t				fGroupID;
@@ -6,8 +6,7 @@
 
 #include "PackageNodeAttribute.h"
 
-#include <stdlib.h>
-#include <string.h>
+#include "StringPool.h"
 
 
 PackageNodeAttribute::PackageNodeAttribute(uint32 type,
@@ -23,13 +22,13 @@ PackageNodeAttribute::PackageNodeAttribute(uint32 type,
 
 PackageNodeAttribute::~PackageNodeAttribute()
 {
-	free(fName);
+	StringPool::Put(fName);
 }
 
 
 status_t
 PackageNodeAttribute::Init(const char* name)
 {
-	fName = strdup(name);
+	fName = StringPool::Get(name);
 	return fName != NULL ? B_OK : B_NO_MEMORY;
 }
@@ -36,7 +36,7 @@ public:
 
 protected:
 			BPackageData		fData;
-			char*				fName;
+			const char*			fName;
 			void*				fIndexCookie;
 			uint32				fType;
 };
@@ -6,8 +6,7 @@
 
 #include "PackageSymlink.h"
 
-#include <stdlib.h>
-#include <string.h>
+#include "StringPool.h"
 
 
 PackageSymlink::PackageSymlink(Package* package, mode_t mode)
@@ -20,7 +19,7 @@ PackageSymlink::PackageSymlink(Package* package, mode_t mode)
 
 PackageSymlink::~PackageSymlink()
 {
-	free(fSymlinkPath);
+	StringPool::Put(fSymlinkPath);
 }
 
 
@@ -30,7 +29,7 @@ PackageSymlink::SetSymlinkPath(const char* path)
 	if (path == NULL)
 		return B_OK;
 
-	fSymlinkPath = strdup(path);
+	fSymlinkPath = StringPool::Get(path);
 	return fSymlinkPath != NULL ? B_OK : B_NO_MEMORY;
 }
 
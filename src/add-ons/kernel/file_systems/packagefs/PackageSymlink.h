@@ -19,7 +19,7 @@ public:
 	virtual	const char*			SymlinkPath() const;
 
 private:
-				char*			fSymlinkPath;
+			const char*			fSymlinkPath;
 };
 
 
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "StringPool.h"
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <new>
+
+#include <lock.h>
+#include <util/AutoLock.h>
+#include <util/khash.h>
+#include <util/OpenHashTable.h>
+
+#include "DebugSupport.h"
+
+
+static const size_t kInitialStringTableSize = 4096;
+
+
+struct StringData {
+	StringData*	hashNext;
+	uint32		hash;
+	int32		referenceCount;
+	char		string[1];
+
+	static StringData* FromString(const char* string)
+	{
+		return (StringData*)(string - offsetof(StringData, string));
+	}
+};
+
+
+struct StringDataHashDefinition {
+	typedef const char*		KeyType;
+	typedef	StringData		ValueType;
+
+	size_t HashKey(const char* key) const
+	{
+		return hash_hash_string(key);
+	}
+
+	size_t Hash(const StringData* value) const
+	{
+		return value->hash;
+	}
+
+	bool Compare(const char* key, const StringData* value) const
+	{
+		return strcmp(value->string, key) == 0;
+	}
+
+	StringData*& GetLink(StringData* value) const
+	{
+		return value->hashNext;
+	}
+};
+
+
+typedef BOpenHashTable<StringDataHashDefinition> StringDataHashTable;
+
+
+static mutex sLock;
+static StringDataHashTable* sStrings = NULL;
+static size_t sReferenceCount = 0;
+static size_t sMemoryUsage = 0;
+
+
+/*static*/ status_t
+StringPool::Init()
+{
+	sStrings = new(std::nothrow) StringDataHashTable;
+	if (sStrings == NULL)
+		RETURN_ERROR(B_NO_MEMORY);
+
+	status_t error = sStrings->Init(kInitialStringTableSize);
+	if (error != B_OK) {
+		delete sStrings;
+		sStrings = NULL;
+		RETURN_ERROR(error);
+	}
+
+	mutex_init(&sLock, "packagefs string pool");
+	return B_OK;
+}
+
+
+/*static*/ void
+StringPool::Cleanup()
+{
+	if (sStrings == NULL)
+		return;
+
+	if (sStrings->CountElements() > 0) {
+		ERROR("StringPool::Cleanup(): %" B_PRIuSIZE " strings still in use\n",
+			sStrings->CountElements());
+	}
+
+	StringData* data = sStrings->Clear(true);
+	while (data != NULL) {
+		StringData* next = data->hashNext;
+		free(data);
+		data = next;
+	}
+
+	delete sStrings;
+	sStrings = NULL;
+
+	mutex_destroy(&sLock);
+}
+
+
+/*!	Returns the pooled copy of \a string, adding it to the pool, if it isn't
+	in there yet. The caller gets a reference to the returned string.
+	Returns \c NULL, if the memory for a new string could not be allocated.
+*/
+/*static*/ const char*
+StringPool::Get(const char* string)
+{
+	MutexLocker locker(sLock);
+
+	StringData* data = sStrings->Lookup(string);
+	if (data != NULL) {
+		data->referenceCount++;
+		sReferenceCount++;
+		return data->string;
+	}
+
+	size_t length = strlen(string);
+	size_t size = offsetof(StringData, string) + length + 1;
+	data = (StringData*)malloc(size);
+	if (data == NULL)
+		return NULL;
+
+	data->hash = hash_hash_string(string);
+	data->referenceCount = 1;
+	memcpy(data->string, string, length + 1);
+
+	if (sStrings->Insert(data) != B_OK) {
+		free(data);
+		return NULL;
+	}
+
+	sReferenceCount++;
+	sMemoryUsage += size;
+	return data->string;
+}
+
+
+/*!	Releases a reference to a string returned by Get(). \a string may be
+	\c NULL.
+*/
+/*static*/ void
+StringPool::Put(const char* string)
+{
+	if (string == NULL)
+		return;
+
+	StringData* data = StringData::FromString(string);
+
+	MutexLocker locker(sLock);
+
+	sReferenceCount--;
+	if (--data->referenceCount > 0)
+		return;
+
+	sStrings->RemoveUnchecked(data);
+	sMemoryUsage -= offsetof(StringData, string) + strlen(data->string) + 1;
+	free(data);
+}
+
+
+/*!	Returns the number of strings in the pool, the number of references to
+	them, and the memory used by the strings. Doesn't lock, so that it can be
+	used from the kernel debugger.
+*/
+/*static*/ void
+StringPool::GetStatistics(size_t& _stringCount, size_t& _referenceCount,
+	size_t& _memoryUsage)
+{
+	_stringCount = sStrings != NULL ? sStrings->CountElements() : 0;
+	_referenceCount = sReferenceCount;
+	_memoryUsage = sMemoryUsage;
+}
@@ -0,0 +1,31 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+
+#include <SupportDefs.h>
+
+
+/*!	A global pool of reference counted, immutable strings.
+	The same node and attribute names appear over and over again in the
+	packages (and in the nodes of the volume merging them), so they are only
+	stored once. Strings returned by Get() must be released with Put().
+*/
+class StringPool {
+public:
+	static	status_t			Init();
+	static	void				Cleanup();
+
+	static	const char*			Get(const char* string);
+	static	void				Put(const char* string);
+
+	static	void				GetStatistics(size_t& _stringCount,
+									size_t& _referenceCount,
+									size_t& _memoryUsage);
+};
+
+
+#endif	// STRING_POOL_H
@@ -34,7 +34,7 @@ read_package_data(const BPackageData& data, BDataReader* dataReader,
 	// create a BPackageDataReader
 	BPackageDataReader* reader;
 	status_t error = GlobalFactory::Default()->CreatePackageDataReader(
-		dataReader, data, reader);
+		dataReader, data, 0, reader);
 	if (error != B_OK)
 		RETURN_ERROR(error);
 	ObjectDeleter<BPackageDataReader> readerDeleter(reader);
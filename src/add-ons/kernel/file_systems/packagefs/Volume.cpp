@@ -58,6 +58,9 @@ using BPackageKit::BHPKG::BPrivate::PackageReaderImpl;
 // node ID of the root directory
 static const ino_t kRootDirectoryID = 1;
 
+// maximum number of threads parsing packages at the same time
+static const int32 kMaxPackageLoaderThreads = 8;
+
 static const uint32 kAllStatFields = B_STAT_MODE | B_STAT_UID | B_STAT_GID
 	| B_STAT_SIZE | B_STAT_ACCESS_TIME | B_STAT_MODIFICATION_TIME
 	| B_STAT_CREATION_TIME | B_STAT_CHANGE_TIME;
@@ -414,6 +417,134 @@ private:
 };
 
 
+// #pragma mark - ParallelPackageLoader
+
+
+/*!	Loads a number of packages using several threads. Parsing a package does
+	not touch any state shared with other packages, so they can be loaded
+	independently; the packages and their results are kept in the order they
+	were added, though, so that they can be added to the node tree in a
+	deterministic order afterwards.
+*/
+struct Volume::ParallelPackageLoader {
+	ParallelPackageLoader(Volume* volume)
+		:
+		fVolume(volume),
+		fPackages(NULL),
+		fErrors(NULL),
+		fCount(0),
+		fCapacity(0),
+		fNextIndex(0)
+	{
+	}
+
+	~ParallelPackageLoader()
+	{
+		for (int32 i = 0; i < fCount; i++)
+			fPackages[i]->ReleaseReference();
+
+		free(fPackages);
+		free(fErrors);
+	}
+
+	status_t AddPackage(Package* package)
+	{
+		if (fCount == fCapacity) {
+			int32 capacity = fCapacity > 0 ? fCapacity * 2 : 64;
+
+			Package** packages = (Package**)realloc(fPackages,
+				capacity * sizeof(Package*));
+			if (packages == NULL)
+				RETURN_ERROR(B_NO_MEMORY);
+			fPackages = packages;
+
+			status_t* errors = (status_t*)realloc(fErrors,
+				capacity * sizeof(status_t));
+			if (errors == NULL)
+				RETURN_ERROR(B_NO_MEMORY);
+			fErrors = errors;
+
+			fCapacity = capacity;
+		}
+
+		fPackages[fCount] = package;
+		fErrors[fCount] = B_NO_INIT;
+		fCount++;
+
+		return B_OK;
+	}
+
+	void LoadPackages()
+	{
+		int32 threadCount = 1;
+		system_info info;
+		if (get_system_info(&info) == B_OK)
+			threadCount = info.cpu_count;
+		threadCount = min_c(min_c(threadCount, kMaxPackageLoaderThreads),
+			fCount);
+
+		// the calling thread does its share of the work, too
+		thread_id threads[kMaxPackageLoaderThreads];
+		int32 spawnedCount = 0;
+		for (int32 i = 1; i < threadCount; i++) {
+			thread_id thread = spawn_kernel_thread(&_LoaderEntry,
+				"packagefs package parser", B_NORMAL_PRIORITY, this);
+			if (thread < 0)
+				break;
+
+			threads[spawnedCount++] = thread;
+			resume_thread(thread);
+		}
+
+		_Loader();
+
+		for (int32 i = 0; i < spawnedCount; i++)
+			wait_for_thread(threads[i], NULL);
+	}
+
+	int32 CountPackages() const
+	{
+		return fCount;
+	}
+
+	Package* PackageAt(int32 index) const
+	{
+		return fPackages[index];
+	}
+
+	status_t ErrorAt(int32 index) const
+	{
+		return fErrors[index];
+	}
+
+private:
+	static status_t _LoaderEntry(void* data)
+	{
+		((ParallelPackageLoader*)data)->_Loader();
+		return B_OK;
+	}
+
+	void _Loader()
+	{
+		while (true) {
+			int32 index = atomic_add(&fNextIndex, 1);
+			if (index >= fCount)
+				return;
+
+			fErrors[index] = fVolume->_LoadPackage(fPackages[index]);
+		}
+	}
+
+private:
+	Volume*		fVolume;
+	Package**	fPackages;
+	status_t*	fErrors;
+	int32		fCount;
+	int32		fCapacity;
+	vint32		fNextIndex;
+};
+
+
 // #pragma mark - DomainDirectoryListener
 
 
@@ -835,6 +966,50 @@ Volume::AddPackageDomain(const char* path)
 }
 
 
+#ifdef PACKAGEFS_DEBUGGER_COMMANDS
+
+/*!	Prints the memory used by each package of the volume. To be called from
+	the kernel debugger only.
+*/
+void
+Volume::DumpPackageMemoryUsage() const
+{
+	kprintf("%-48s %8s %8s %10s %10s\n", "package", "nodes", "attrs",
+		"memory", "strings");
+
+	PackageMemoryUsage total;
+	memset(&total, 0, sizeof(total));
+
+	for (PackageDomainList::ConstIterator it = fPackageDomains.GetIterator();
+			PackageDomain* domain = it.Next();) {
+		kprintf("domain %s:\n", domain->Path());
+
+		for (PackageFileNameHashTable::Iterator packageIt
+					= domain->Packages().GetIterator();
+				Package* package = packageIt.Next();) {
+			PackageMemoryUsage usage;
+			package->GetMemoryUsage(usage);
+
+			kprintf("%-48s %8" B_PRIuSIZE " %8" B_PRIuSIZE " %10" B_PRIuSIZE
+				" %10" B_PRIuSIZE "\n", package->FileName(), usage.nodeCount,
+				usage.attributeCount, usage.objectMemory,
+				usage.sharedStringMemory);
+
+			total.nodeCount += usage.nodeCount;
+			total.attributeCount += usage.attributeCount;
+			total.objectMemory += usage.objectMemory;
+			total.sharedStringMemory += usage.sharedStringMemory;
+		}
+	}
+
+	kprintf("%-48s %8" B_PRIuSIZE " %8" B_PRIuSIZE " %10" B_PRIuSIZE
+		" %10" B_PRIuSIZE "\n", "total", total.nodeCount,
+		total.attributeCount, total.objectMemory, total.sharedStringMemory);
+}
+
+#endif	// PACKAGEFS_DEBUGGER_COMMANDS
+
+
 void
 Volume::PackageLinkNodeAdded(Node* node)
 {
@@ -968,32 +1143,64 @@ Volume::_AddPackageDomain(PackageDomain* domain, bool notify)
 	}
 	CObjectDeleter<DIR, int> dirCloser(dir, closedir);
 
+	bigtime_t startTime = system_time();
+	ParallelPackageLoader loader(this);
+
 	while (dirent* entry = readdir(dir)) {
 		// skip "." and ".."
 		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
 			continue;
 
-		_DomainEntryCreated(domain, domain->DeviceID(), domain->NodeID(),
-			-1, entry->d_name, false, notify);
-// TODO: -1 node ID?
+		Package* package;
+		if (_CreatePackage(domain, entry->d_name, package) != B_OK)
+			continue;
+
+		error = loader.AddPackage(package);
+		if (error != B_OK) {
+			package->ReleaseReference();
+			RETURN_ERROR(error);
+		}
 	}
 
-	// add the packages to the node tree
+	dirCloser.Delete();
+
+	// parse the packages
+	loader.LoadPackages();
+
+	// add the packages to the domain and the node tree, in directory order
 	VolumeWriteLocker systemVolumeLocker(_SystemVolumeIfNotSelf());
 	VolumeWriteLocker volumeLocker(this);
-	for (PackageFileNameHashTable::Iterator it
-			= domain->Packages().GetIterator(); Package* package = it.Next();) {
+
+	int32 packageCount = loader.CountPackages();
+	for (int32 i = 0; i < packageCount; i++) {
+		Package* package = loader.PackageAt(i);
+		if (loader.ErrorAt(i) == B_OK
+			&& domain->FindPackage(package->FileName()) == NULL) {
+			domain->AddPackage(package);
+		}
+	}
+
+	for (int32 i = 0; i < packageCount; i++) {
+		Package* package = loader.PackageAt(i);
+		if (domain->FindPackage(package->FileName()) != package)
+			continue;
+
 		error = _AddPackageContent(package, notify);
 		if (error != B_OK) {
-			for (it.Rewind(); Package* activePackage = it.Next();) {
-				if (activePackage == package)
-					break;
-				_RemovePackageContent(activePackage, NULL, notify);
+			for (int32 k = 0; k < i; k++) {
+				Package* activePackage = loader.PackageAt(k);
+				if (domain->FindPackage(activePackage->FileName())
+						== activePackage) {
+					_RemovePackageContent(activePackage, NULL, notify);
+				}
 			}
 			RETURN_ERROR(error);
 		}
 	}
 
+	INFORM("added %" B_PRId32 " packages from \"%s\" in %" B_PRId64 " ms\n",
+		packageCount, domain->Path(), (system_time() - startTime) / 1000);
+
 	fPackageDomains.Add(domain);
 	domain->AcquireReference();
 
@@ -1018,6 +1225,36 @@ Volume::_RemovePackageDomain(PackageDomain* domain)
 }
 
 
+/*!	Creates a package object for the entry \a name of the given \a domain,
+	if it is a file. The package still needs to be loaded.
+	The caller gets a reference to the package.
+*/
+status_t
+Volume::_CreatePackage(PackageDomain* domain, const char* name,
+	Package*& _package)
+{
+	// check whether the entry is a file
+	struct stat st;
+	if (fstatat(domain->DirectoryFD(), name, &st, 0) < 0)
+		return errno;
+	if (!S_ISREG(st.st_mode))
+		return B_BAD_VALUE;
+
+	// create a package
+	Package* package = new(std::nothrow) Package(domain, st.st_dev, st.st_ino);
+	if (package == NULL)
+		RETURN_ERROR(B_NO_MEMORY);
+	BReference<Package> packageReference(package, true);
+
+	status_t error = package->Init(name);
+	if (error != B_OK)
+		return error;
+
+	_package = packageReference.Detach();
+	return B_OK;
+}
+
+
 status_t
 Volume::_LoadPackage(Package* package)
 {
@@ -1592,22 +1829,12 @@ Volume::_DomainEntryCreated(PackageDomain* domain, dev_t deviceID,
 		return;
 	}
 
-	// check whether the entry is a file
-	struct stat st;
-	if (fstatat(domain->DirectoryFD(), name, &st, 0) < 0
-		|| !S_ISREG(st.st_mode)) {
-		return;
-	}
-
 	// create a package
-	Package* package = new(std::nothrow) Package(domain, st.st_dev, st.st_ino);
-	if (package == NULL)
-		return;
-	BReference<Package> packageReference(package, true);
-
-	status_t error = package->Init(name);
+	Package* package;
+	status_t error = _CreatePackage(domain, name, package);
 	if (error != B_OK)
 		return;
+	BReference<Package> packageReference(package, true);
 
 	error = _LoadPackage(package);
 	if (error != B_OK)
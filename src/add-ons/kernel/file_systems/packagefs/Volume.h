@@ -96,6 +96,10 @@ public:
 
 			status_t			AddPackageDomain(const char* path);
 
+#ifdef PACKAGEFS_DEBUGGER_COMMANDS
+			void				DumpPackageMemoryUsage() const;
+#endif
+
 private:
 	// PackageLinksListener
 	virtual	void				PackageLinkNodeAdded(Node* node);
@@ -111,11 +115,13 @@ private:
 			struct PackageLoaderErrorOutput;
 			struct PackageLoaderContentHandler;
 			struct DomainDirectoryListener;
+			struct ParallelPackageLoader;
 			struct ShineThroughDirectory;
 
 			friend struct AddPackageDomainJob;
 			friend struct DomainDirectoryEventJob;
 			friend struct DomainDirectoryListener;
+			friend struct ParallelPackageLoader;
 
 			typedef DoublyLinkedList<Job> JobList;
 			typedef DoublyLinkedList<PackageDomain> PackageDomainList;
@@ -132,6 +138,8 @@ private:
 			status_t			_AddPackageDomain(PackageDomain* domain,
 									bool notify);
 			void				_RemovePackageDomain(PackageDomain* domain);
+			status_t			_CreatePackage(PackageDomain* domain,
+									const char* name, Package*& _package);
 			status_t			_LoadPackage(Package* package);
 
 			status_t			_AddPackageContent(Package* package,
@@ -24,6 +24,7 @@
 #include "GlobalFactory.h"
 #include "Query.h"
 #include "PackageFSRoot.h"
+#include "StringPool.h"
 #include "Utils.h"
 #include "Volume.h"
 
@@ -1065,6 +1066,38 @@ packagefs_rewind_query(fs_volume* fsVolume, void* cookie)
 }
 
 
+#ifdef PACKAGEFS_DEBUGGER_COMMANDS
+
+
+// #pragma mark - Debugger Commands
+
+
+static int
+dump_package_memory_usage(int argc, char** argv)
+{
+	if (argc != 2) {
+		print_debugger_command_usage(argv[0]);
+		return 0;
+	}
+
+	Volume* volume = (Volume*)parse_expression(argv[1]);
+	volume->DumpPackageMemoryUsage();
+
+	size_t stringCount;
+	size_t referenceCount;
+	size_t stringMemory;
+	StringPool::GetStatistics(stringCount, referenceCount, stringMemory);
+	kprintf("\nstring pool: %" B_PRIuSIZE " strings, %" B_PRIuSIZE
+		" references, %" B_PRIuSIZE " bytes\n", stringCount, referenceCount,
+		stringMemory);
+
+	return 0;
+}
+
+
+#endif	// PACKAGEFS_DEBUGGER_COMMANDS
+
+
 // #pragma mark - Module Interface
 
 
@@ -1084,21 +1117,45 @@ packagefs_std_ops(int32 op, ...)
 				return error;
 			}
 
+			error = StringPool::Init();
+			if (error != B_OK) {
+				ERROR("Failed to init StringPool\n");
+				GlobalFactory::DeleteDefault();
+				exit_debugging();
+				return error;
+			}
+
 			error = PackageFSRoot::GlobalInit();
 			if (error != B_OK) {
 				ERROR("Failed to init PackageFSRoot\n");
+				StringPool::Cleanup();
 				GlobalFactory::DeleteDefault();
 				exit_debugging();
 				return error;
 			}
 
+#ifdef PACKAGEFS_DEBUGGER_COMMANDS
+			add_debugger_command_etc("packagefs_memory",
+				&dump_package_memory_usage,
+				"Print the memory used by the packages of a packagefs volume",
+				"<volume address>\n"
+				"Prints the memory used by the packages of a packagefs volume,\n"
+				"as well as that of the global string pool.\n",
+				0);
+#endif
+
 			return B_OK;
 		}
 
 		case B_MODULE_UNINIT:
 		{
 			PRINT("package_std_ops(): B_MODULE_UNINIT\n");
+#ifdef PACKAGEFS_DEBUGGER_COMMANDS
+			remove_debugger_command("packagefs_memory",
+				&dump_package_memory_usage);
+#endif
 			PackageFSRoot::GlobalUninit();
+			StringPool::Cleanup();
 			GlobalFactory::DeleteDefault();
 			exit_debugging();
 			return B_OK;
@@ -78,6 +78,9 @@ KernelDebug::DebugPort(int argc, char** argv)
 	kprintf("  size:         %ld\n", port->fPort.fInfo.size);
 	kprintf("  capacity:     %ld\n", port->fPort.fCapacity);
 	kprintf("  buffer:       %p\n", port->fPort.fBuffer);
+	kprintf("  shared buffer: %p (%ld bytes, %ld reserved)\n",
+		port->fPort.fSharedBuffer, port->fPort.fInfo.shared_buffer_size,
+		port->fPort.fSharedBufferReservedSize);
 	return 0;
 }
 
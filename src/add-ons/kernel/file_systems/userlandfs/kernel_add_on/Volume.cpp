@@ -2148,6 +2148,10 @@ Volume::Read(void* _node, void* cookie, off_t pos, void* buffer,
 		return B_ERROR;
 	PortReleaser _(fFileSystem->GetPortPool(), port);
 
+	// Let the server read directly into the port's shared buffer, if it has
+	// enough room. Otherwise the data come with the reply.
+	SharedBufferReservation sharedBuffer(port->GetPort(), bufferSize);
+
 	// prepare the request
 	RequestAllocator allocator(port->GetPort());
 	ReadRequest* request;
@@ -2160,6 +2164,7 @@ Volume::Read(void* _node, void* cookie, off_t pos, void* buffer,
 	request->fileCookie = cookie;
 	request->pos = pos;
 	request->size = bufferSize;
+	request->sharedBufferOffset = sharedBuffer.Offset();
 
 	// send the request
 	KernelRequestHandler handler(this, READ_REPLY);
@@ -2172,10 +2177,17 @@ Volume::Read(void* _node, void* cookie, off_t pos, void* buffer,
 	// process the reply
 	if (reply->error != B_OK)
 		return reply->error;
-	void* readBuffer = reply->buffer.GetData();
-	if (reply->bytesRead > (uint32)reply->buffer.GetSize()
-		|| reply->bytesRead > bufferSize) {
-		return B_BAD_DATA;
+	void* readBuffer;
+	if (sharedBuffer.Offset() >= 0) {
+		readBuffer = sharedBuffer.Buffer();
+		if (reply->bytesRead > bufferSize)
+			return B_BAD_DATA;
+	} else {
+		readBuffer = reply->buffer.GetData();
+		if (reply->bytesRead > (uint32)reply->buffer.GetSize()
+			|| reply->bytesRead > bufferSize) {
+			return B_BAD_DATA;
+		}
 	}
 	if (reply->bytesRead > 0)
 		memcpy(buffer, readBuffer, reply->bytesRead);
@@ -2203,6 +2215,9 @@ Volume::Write(void* _node, void* cookie, off_t pos, const void* buffer,
 		return B_ERROR;
 	PortReleaser _(fFileSystem->GetPortPool(), port);
 
+	// pass the data in the port's shared buffer, if it has enough room
+	SharedBufferReservation sharedBuffer(port->GetPort(), size);
+
 	// prepare the request
 	RequestAllocator allocator(port->GetPort());
 	WriteRequest* request;
@@ -2214,9 +2229,16 @@ Volume::Write(void* _node, void* cookie, off_t pos, const void* buffer,
 	request->node = vnode->clientNode;
 	request->fileCookie = cookie;
 	request->pos = pos;
-	error = allocator.AllocateData(request->buffer, buffer, size, 1);
-	if (error != B_OK)
-		return error;
+	if (sharedBuffer.Offset() >= 0) {
+		if (size > 0)
+			memcpy(sharedBuffer.Buffer(), buffer, size);
+		request->sharedBufferOffset = sharedBuffer.Offset();
+		request->sharedBufferSize = size;
+	} else {
+		error = allocator.AllocateData(request->buffer, buffer, size, 1);
+		if (error != B_OK)
+			return error;
+	}
 
 	// send the request
 	KernelRequestHandler handler(this, WRITE_REPLY);
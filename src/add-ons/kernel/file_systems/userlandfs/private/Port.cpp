@@ -18,16 +18,25 @@ using std::nothrow;
 static const int32 kMinPortSize = 1024;			// 1 kB
 static const int32 kMaxPortSize = 64 * 1024;	// 64 kB
 
+// maximal shared buffer size
+static const int32 kMaxSharedBufferSize = 1024 * 1024;	// 1 MB
+
 
 // constructor
-Port::Port(int32 size)
+Port::Port(int32 size, int32 sharedBufferSize)
 	:
 	fBuffer(NULL),
 	fCapacity(0),
 	fReservedSize(0),
+	fSharedBuffer(NULL),
+	fSharedBufferArea(-1),
+	fSharedBufferReservedSize(0),
 	fInitStatus(B_NO_INIT),
 	fOwner(true)
 {
+	fInfo.shared_buffer_area = -1;
+	fInfo.shared_buffer_size = 0;
+
 	// adjust size to be within the sane bounds
 	if (size < kMinPortSize)
 		size = kMinPortSize;
@@ -51,6 +60,27 @@ Port::Port(int32 size)
 		fInitStatus = fInfo.client_port;
 		return;
 	}
+	// Create the shared buffer, if requested. The other side maps it, too,
+	// so that bulk data don't have to be copied through the port. Failing to
+	// create it is not fatal, the data are passed the normal way then.
+	if (sharedBufferSize > 0) {
+		sharedBufferSize = min_c(sharedBufferSize, kMaxSharedBufferSize);
+		sharedBufferSize = (sharedBufferSize + B_PAGE_SIZE - 1) / B_PAGE_SIZE
+			* B_PAGE_SIZE;
+		void* address;
+		fSharedBufferArea = create_area("port shared buffer", &address,
+#ifdef _KERNEL_MODE
+			B_ANY_KERNEL_ADDRESS,
+#else
+			B_ANY_ADDRESS,
+#endif
+			sharedBufferSize, B_NO_LOCK, B_READ_AREA | B_WRITE_AREA);
+		if (fSharedBufferArea >= 0) {
+			fSharedBuffer = (uint8*)address;
+			fInfo.shared_buffer_area = fSharedBufferArea;
+			fInfo.shared_buffer_size = sharedBufferSize;
+		}
+	}
 	fInfo.size = size;
 	fCapacity = size;
 	fInitStatus = B_OK;
@@ -63,9 +93,15 @@ Port::Port(const Info* info)
 	fBuffer(NULL),
 	fCapacity(0),
 	fReservedSize(0),
+	fSharedBuffer(NULL),
+	fSharedBufferArea(-1),
+	fSharedBufferReservedSize(0),
 	fInitStatus(B_NO_INIT),
 	fOwner(false)
 {
+	fInfo.shared_buffer_area = -1;
+	fInfo.shared_buffer_size = 0;
+
 	// check parameters
 	if (!info || info->owner_port < 0 || info->client_port < 0
 		|| info->size < kMinPortSize || info->size > kMaxPortSize) {
@@ -77,6 +113,31 @@ Port::Port(const Info* info)
 		fInitStatus = B_NO_MEMORY;
 		return;
 	}
+	// map the shared buffer, if there is one -- if that fails, we simply
+	// don't use it
+	if (info->shared_buffer_area >= 0 && info->shared_buffer_size > 0
+		&& info->shared_buffer_size <= kMaxSharedBufferSize) {
+		void* address;
+		fSharedBufferArea = clone_area("port shared buffer", &address,
+#ifdef _KERNEL_MODE
+			B_ANY_KERNEL_ADDRESS,
+#else
+			B_ANY_ADDRESS,
+#endif
+			B_READ_AREA | B_WRITE_AREA, info->shared_buffer_area);
+		if (fSharedBufferArea >= 0) {
+			area_info areaInfo;
+			if (get_area_info(fSharedBufferArea, &areaInfo) == B_OK
+				&& areaInfo.size >= (size_t)info->shared_buffer_size) {
+				fSharedBuffer = (uint8*)address;
+				fInfo.shared_buffer_area = info->shared_buffer_area;
+				fInfo.shared_buffer_size = info->shared_buffer_size;
+			} else {
+				delete_area(fSharedBufferArea);
+				fSharedBufferArea = -1;
+			}
+		}
+	}
 	// init the info
 	fInfo.owner_port = info->owner_port;
 	fInfo.client_port = info->client_port;
@@ -92,6 +153,8 @@ Port::~Port()
 {
 	Close();
 	delete[] fBuffer;
+	if (fSharedBufferArea >= 0)
+		delete_area(fSharedBufferArea);
 }
 
 
@@ -148,6 +211,37 @@ Port::Unreserve(int32 endOffset)
 }
 
 
+// ReserveSharedBuffer
+/*!	Reserves \a size bytes of the shared buffer and returns their offset, or
+	-1, if there is no shared buffer or not enough of it is left. Requests
+	can be nested, so reservations work like a stack: UnreserveSharedBuffer()
+	must be called with the returned offset in reverse order.
+*/
+int32
+Port::ReserveSharedBuffer(int32 size)
+{
+	if (fSharedBuffer == NULL || size < 0
+		|| size > fInfo.shared_buffer_size - fSharedBufferReservedSize) {
+		return -1;
+	}
+
+	int32 offset = fSharedBufferReservedSize;
+	fSharedBufferReservedSize += (size + 7) / 8 * 8;
+	if (fSharedBufferReservedSize > fInfo.shared_buffer_size)
+		fSharedBufferReservedSize = fInfo.shared_buffer_size;
+	return offset;
+}
+
+
+// UnreserveSharedBuffer
+void
+Port::UnreserveSharedBuffer(int32 offset)
+{
+	if (offset >= 0 && offset < fSharedBufferReservedSize)
+		fSharedBufferReservedSize = offset;
+}
+
+
 // Send
 status_t
 Port::Send(const void* message, int32 size)
@@ -22,8 +22,8 @@ struct RequestPort::AllocatorNode {
 
 
 // constructor
-RequestPort::RequestPort(int32 size)
-	: fPort(size),
+RequestPort::RequestPort(int32 size, int32 sharedBufferSize)
+	: fPort(size, sharedBufferSize),
 	  fCurrentAllocatorNode(NULL)
 {
 }
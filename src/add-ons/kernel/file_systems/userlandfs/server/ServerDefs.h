@@ -24,11 +24,13 @@ private:
 extern ServerSettings gServerSettings;
 
 static const int32 kRequestPortSize = B_PAGE_SIZE;
+static const int32 kRequestSharedBufferSize = 256 * 1024;
 
 }	// namespace UserlandFS
 
 using UserlandFS::ServerSettings;
 using UserlandFS::gServerSettings;
 using UserlandFS::kRequestPortSize;
+using UserlandFS::kRequestSharedBufferSize;
 
 #endif	// USERLAND_FS_SERVER_DEFS_H
@@ -1258,8 +1258,14 @@ UserlandRequestHandler::_HandleRequest(ReadRequest* request)
 
 	void* buffer;
 	if (result == B_OK) {
-		result = allocator.AllocateAddress(reply->buffer, size, 1, &buffer,
-			true);
+		if (request->sharedBufferOffset >= 0) {
+			// read directly into the shared buffer
+			result = _GetSharedBuffer(request->sharedBufferOffset, size,
+				&buffer);
+		} else {
+			result = allocator.AllocateAddress(reply->buffer, size, 1,
+				&buffer, true);
+		}
 	}
 
 	// execute the request
@@ -1288,12 +1294,20 @@ UserlandRequestHandler::_HandleRequest(WriteRequest* request)
 	if (!volume)
 		result = B_BAD_VALUE;
 
+	const void* buffer = request->buffer.GetData();
+	size_t size = request->buffer.GetSize();
+	if (result == B_OK && request->sharedBufferOffset >= 0) {
+		// the data are in the shared buffer
+		size = request->sharedBufferSize;
+		result = _GetSharedBuffer(request->sharedBufferOffset, size,
+			(void**)&buffer);
+	}
+
 	size_t bytesWritten;
 	if (result == B_OK) {
 		RequestThreadContext context(volume, request);
 		result = volume->Write(request->node, request->fileCookie,
-			request->pos, request->buffer.GetData(), request->buffer.GetSize(),
-			&bytesWritten);
+			request->pos, buffer, size, &bytesWritten);
 	}
 
 	// prepare the reply
@@ -2469,6 +2483,24 @@ UserlandRequestHandler::_HandleRequest(NodeMonitoringEventRequest* request)
 // #pragma mark - other
 
 
+// _GetSharedBuffer
+status_t
+UserlandRequestHandler::_GetSharedBuffer(int32 offset, size_t size,
+	void** _buffer)
+{
+	// the range is supplied by the kernel, but check it anyway
+	Port* port = fPort->GetPort();
+	int32 sharedBufferSize = port->GetSharedBufferSize();
+	if (offset < 0 || offset > sharedBufferSize
+		|| size > (size_t)(sharedBufferSize - offset)) {
+		RETURN_ERROR(B_BAD_VALUE);
+	}
+
+	*_buffer = (uint8*)port->GetSharedBuffer() + offset;
+	return B_OK;
+}
+
+
 // _SendReply
 status_t
 UserlandRequestHandler::_SendReply(RequestAllocator& allocator,
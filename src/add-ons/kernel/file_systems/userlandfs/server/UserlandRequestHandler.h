@@ -206,6 +206,8 @@ private:
 			status_t			_HandleRequest(
 									NodeMonitoringEventRequest* request);
 
+			status_t			_GetSharedBuffer(int32 offset, size_t size,
+									void** _buffer);
 			status_t			_SendReply(RequestAllocator& allocator,
 									bool expectsReceipt);
 
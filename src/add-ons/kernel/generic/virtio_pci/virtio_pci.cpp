@@ -0,0 +1,592 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+/*
+	virtio PCI transport library.
+
+	Implements the legacy virtio PCI interface (as found in the "transitional"
+	devices QEMU and KVM provide by default), and the split virtqueues shared
+	by all virtio device types.
+*/
+
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+#include <KernelExport.h>
+#include <PCI.h>
+
+#include <virtio.h>
+
+#include "virtio_ring.h"
+
+
+//#define TRACE_VIRTIO
+#ifdef TRACE_VIRTIO
+#	define TRACE(x...) dprintf("virtio_pci: " x)
+#else
+#	define TRACE(x...) ;
+#endif
+#define ERROR(x...) dprintf("virtio_pci: " x)
+
+
+struct virtio_queue {
+	virtio_device*		device;
+	virtio_queue*		next;
+	uint16				index;
+	uint16				size;
+
+	area_id				area;
+	vring_desc*			descriptors;
+	vring_avail*		avail;
+	vring_used*			used;
+
+	uint16				free_head;
+	uint16				free_count;
+	uint16				last_used;
+	uint16				kicked_index;
+	void**				cookies;
+
+	area_id				indirect_area;
+	vring_desc*			indirect;
+	phys_addr_t			indirect_physical;
+	uint16				indirect_count;
+};
+
+struct virtio_device {
+	pci_info			info;
+	uint16				io_base;
+	uint32				features;
+	virtio_queue*		queues;
+};
+
+
+static pci_module_info* sPCI;
+
+
+static inline uint8
+read_8(virtio_device* device, uint16 offset)
+{
+	return sPCI->read_io_8(device->io_base + offset);
+}
+
+
+static inline uint16
+read_16(virtio_device* device, uint16 offset)
+{
+	return sPCI->read_io_16(device->io_base + offset);
+}
+
+
+static inline uint32
+read_32(virtio_device* device, uint16 offset)
+{
+	return sPCI->read_io_32(device->io_base + offset);
+}
+
+
+static inline void
+write_8(virtio_device* device, uint16 offset, uint8 value)
+{
+	sPCI->write_io_8(device->io_base + offset, value);
+}
+
+
+static inline void
+write_16(virtio_device* device, uint16 offset, uint16 value)
+{
+	sPCI->write_io_16(device->io_base + offset, value);
+}
+
+
+static inline void
+write_32(virtio_device* device, uint16 offset, uint32 value)
+{
+	sPCI->write_io_32(device->io_base + offset, value);
+}
+
+
+static void
+add_status(virtio_device* device, uint8 status)
+{
+	write_8(device, VIRTIO_PCI_STATUS,
+		read_8(device, VIRTIO_PCI_STATUS) | status);
+}
+
+
+static void
+free_queue(virtio_queue* queue)
+{
+	virtio_device* device = queue->device;
+
+	write_16(device, VIRTIO_PCI_QUEUE_SELECT, queue->index);
+	write_32(device, VIRTIO_PCI_QUEUE_PFN, 0);
+
+	delete_area(queue->area);
+	if (queue->indirect_area >= 0)
+		delete_area(queue->indirect_area);
+	free(queue->cookies);
+	delete queue;
+}
+
+
+//	#pragma mark - device
+
+
+static status_t
+virtio_init_device(const pci_info* info, virtio_device** _device)
+{
+	if (info->vendor_id != VIRTIO_PCI_VENDOR_ID
+		|| info->device_id < VIRTIO_PCI_DEVICE_ID_MIN
+		|| info->device_id > VIRTIO_PCI_DEVICE_ID_MAX) {
+		return B_BAD_VALUE;
+	}
+
+	// Only legacy devices (revision 0) provide the I/O port interface
+	if (info->revision != 0
+		|| (info->u.h0.base_register_flags[0] & PCI_address_space) == 0) {
+		ERROR("device %02x:%02x.%x is not a legacy virtio device\n",
+			info->bus, info->device, info->function);
+		return B_NOT_SUPPORTED;
+	}
+
+	virtio_device* device = new(std::nothrow) virtio_device;
+	if (device == NULL)
+		return B_NO_MEMORY;
+
+	device->info = *info;
+	device->io_base = info->u.h0.base_registers[0];
+	device->features = 0;
+	device->queues = NULL;
+
+	// enable I/O space access and bus mastering
+	uint16 command = sPCI->read_pci_config(info->bus, info->device,
+		info->function, PCI_command, 2);
+	command |= PCI_command_io | PCI_command_master;
+	sPCI->write_pci_config(info->bus, info->device, info->function,
+		PCI_command, 2, command);
+
+	write_8(device, VIRTIO_PCI_STATUS, VIRTIO_STATUS_RESET);
+	add_status(device, VIRTIO_STATUS_ACKNOWLEDGE);
+	add_status(device, VIRTIO_STATUS_DRIVER);
+
+	TRACE("device at I/O base %#x, type %u\n", device->io_base,
+		info->u.h0.subsystem_id);
+
+	*_device = device;
+	return B_OK;
+}
+
+
+static void
+virtio_uninit_device(virtio_device* device)
+{
+	// the reset stops the device from using the queues
+	write_8(device, VIRTIO_PCI_STATUS, VIRTIO_STATUS_RESET);
+
+	while (device->queues != NULL) {
+		virtio_queue* queue = device->queues;
+		device->queues = queue->next;
+		free_queue(queue);
+	}
+
+	delete device;
+}
+
+
+static uint32
+virtio_negotiate_features(virtio_device* device, uint32 supported)
+{
+	uint32 offered = read_32(device, VIRTIO_PCI_HOST_FEATURES);
+	device->features = offered & supported;
+	write_32(device, VIRTIO_PCI_GUEST_FEATURES, device->features);
+
+	TRACE("features: offered %#" B_PRIx32 ", using %#" B_PRIx32 "\n", offered,
+		device->features);
+	return device->features;
+}
+
+
+static void
+virtio_set_driver_ok(virtio_device* device)
+{
+	add_status(device, VIRTIO_STATUS_DRIVER_OK);
+}
+
+
+static void
+virtio_set_failed(virtio_device* device)
+{
+	add_status(device, VIRTIO_STATUS_FAILED);
+}
+
+
+static void
+virtio_read_device_config(virtio_device* device, uint8 offset, void* buffer,
+	size_t size)
+{
+	uint8* bytes = (uint8*)buffer;
+	for (size_t i = 0; i < size; i++)
+		bytes[i] = read_8(device, VIRTIO_PCI_CONFIG + offset + i);
+}
+
+
+static void
+virtio_write_device_config(virtio_device* device, uint8 offset,
+	const void* buffer, size_t size)
+{
+	const uint8* bytes = (const uint8*)buffer;
+	for (size_t i = 0; i < size; i++)
+		write_8(device, VIRTIO_PCI_CONFIG + offset + i, bytes[i]);
+}
+
+
+static uint8
+virtio_interrupt_status(virtio_device* device)
+{
+	// reading the register also acknowledges the interrupt
+	return read_8(device, VIRTIO_PCI_ISR);
+}
+
+
+//	#pragma mark - queues
+
+
+static status_t
+virtio_alloc_queue(virtio_device* device, uint16 index, virtio_queue** _queue)
+{
+	write_16(device, VIRTIO_PCI_QUEUE_SELECT, index);
+
+	uint16 size = read_16(device, VIRTIO_PCI_QUEUE_SIZE);
+	if (size == 0)
+		return B_BAD_INDEX;
+	if (read_32(device, VIRTIO_PCI_QUEUE_PFN) != 0)
+		return B_BUSY;
+
+	virtio_queue* queue = new(std::nothrow) virtio_queue;
+	if (queue == NULL)
+		return B_NO_MEMORY;
+
+	queue->cookies = (void**)calloc(size, sizeof(void*));
+	if (queue->cookies == NULL) {
+		delete queue;
+		return B_NO_MEMORY;
+	}
+
+	// the legacy interface can only address the ring by a 32 bit page number
+	size_t areaSize = (vring_size(size) + B_PAGE_SIZE - 1)
+		& ~(size_t)(B_PAGE_SIZE - 1);
+	void* address;
+	queue->area = create_area("virtio queue", &address, B_ANY_KERNEL_ADDRESS,
+		areaSize, B_32_BIT_CONTIGUOUS, B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA);
+	if (queue->area < 0) {
+		status_t status = queue->area;
+		free(queue->cookies);
+		delete queue;
+		return status;
+	}
+
+	physical_entry entry;
+	get_memory_map(address, B_PAGE_SIZE, &entry, 1);
+	memset(address, 0, areaSize);
+
+	queue->device = device;
+	queue->index = index;
+	queue->size = size;
+	queue->descriptors = (vring_desc*)address;
+	queue->avail = (vring_avail*)((uint8*)address + vring_avail_offset(size));
+	queue->used = (vring_used*)((uint8*)address + vring_used_offset(size));
+	queue->last_used = 0;
+	queue->kicked_index = 0;
+	queue->indirect_area = -1;
+	queue->indirect = NULL;
+	queue->indirect_physical = 0;
+	queue->indirect_count = 0;
+
+	// chain all descriptors into the free list
+	queue->free_head = 0;
+	queue->free_count = size;
+	for (uint16 i = 0; i < size - 1; i++)
+		queue->descriptors[i].next = i + 1;
+
+	write_32(device, VIRTIO_PCI_QUEUE_PFN,
+		entry.address >> VIRTIO_PCI_QUEUE_ADDRESS_SHIFT);
+
+	queue->next = device->queues;
+	device->queues = queue;
+
+	TRACE("queue %u: %u entries at %#" B_PRIxPHYSADDR "\n", index, size,
+		entry.address);
+
+	*_queue = queue;
+	return B_OK;
+}
+
+
+static uint16
+virtio_queue_size(virtio_queue* queue)
+{
+	return queue->size;
+}
+
+
+static uint16
+virtio_queue_free_count(virtio_queue* queue)
+{
+	return queue->free_count;
+}
+
+
+static status_t
+virtio_set_queue_indirect(virtio_queue* queue, uint16 maxVectorCount)
+{
+	if ((queue->device->features & VIRTIO_FEATURE_RING_INDIRECT_DESC) == 0)
+		return B_NOT_SUPPORTED;
+	if (queue->indirect != NULL || maxVectorCount < 2)
+		return B_BAD_VALUE;
+
+	// every ring descriptor gets its own table, so that a request can always
+	// use the one of its head descriptor
+	size_t areaSize = ((size_t)queue->size * maxVectorCount
+		* sizeof(vring_desc) + B_PAGE_SIZE - 1) & ~(size_t)(B_PAGE_SIZE - 1);
+	void* address;
+	area_id area = create_area("virtio indirect descriptors", &address,
+		B_ANY_KERNEL_ADDRESS, areaSize, B_CONTIGUOUS,
+		B_KERNEL_READ_AREA | B_KERNEL_WRITE_AREA);
+	if (area < 0)
+		return area;
+
+	physical_entry entry;
+	get_memory_map(address, B_PAGE_SIZE, &entry, 1);
+
+	queue->indirect_area = area;
+	queue->indirect = (vring_desc*)address;
+	queue->indirect_physical = entry.address;
+	queue->indirect_count = maxVectorCount;
+	return B_OK;
+}
+
+
+/*!	Puts the request into the indirect table of the head descriptor, so that
+	it only occupies a single slot of the ring.
+*/
+static void
+queue_indirect_request(virtio_queue* queue, uint16 head,
+	const physical_entry* vector, size_t readVectorCount, size_t count)
+{
+	vring_desc* table = queue->indirect + (size_t)head * queue->indirect_count;
+
+	for (size_t i = 0; i < count; i++) {
+		table[i].address = vector[i].address;
+		table[i].length = vector[i].size;
+		table[i].flags = i + 1 < count ? VRING_DESC_F_NEXT : 0;
+		if (i >= readVectorCount)
+			table[i].flags |= VRING_DESC_F_WRITE;
+		table[i].next = i + 1;
+	}
+
+	// the "next" field still links the free list, and must be kept
+	vring_desc& descriptor = queue->descriptors[head];
+	descriptor.address = queue->indirect_physical
+		+ (phys_addr_t)head * queue->indirect_count * sizeof(vring_desc);
+	descriptor.length = count * sizeof(vring_desc);
+	descriptor.flags = VRING_DESC_F_INDIRECT;
+}
+
+
+static status_t
+virtio_queue_request(virtio_queue* queue, const physical_entry* vector,
+	size_t readVectorCount, size_t writtenVectorCount, void* cookie)
+{
+	size_t count = readVectorCount + writtenVectorCount;
+	if (count == 0)
+		return B_BAD_VALUE;
+
+	bool indirect = queue->indirect != NULL && count > 1
+		&& count <= queue->indirect_count;
+	if ((indirect ? 1 : count) > queue->free_count)
+		return B_BUSY;
+
+	uint16 head = queue->free_head;
+	uint16 index = head;
+	uint16 last = head;
+
+	if (indirect) {
+		queue_indirect_request(queue, head, vector, readVectorCount, count);
+		index = queue->descriptors[head].next;
+		count = 1;
+	}
+
+	for (size_t i = 0; !indirect && i < count; i++) {
+		vring_desc& descriptor = queue->descriptors[index];
+		descriptor.address = vector[i].address;
+		descriptor.length = vector[i].size;
+		descriptor.flags = VRING_DESC_F_NEXT;
+		if (i >= readVectorCount)
+			descriptor.flags |= VRING_DESC_F_WRITE;
+
+		last = index;
+		index = descriptor.next;
+	}
+
+	queue->descriptors[last].flags &= ~VRING_DESC_F_NEXT;
+	queue->free_head = index;
+	queue->free_count -= count;
+	queue->cookies[head] = cookie;
+
+	uint16 availIndex = queue->avail->index;
+	queue->avail->ring[availIndex % queue->size] = head;
+
+	// the device must see the descriptors before the new index
+	memory_write_barrier();
+	queue->avail->index = availIndex + 1;
+
+	return B_OK;
+}
+
+
+static void
+virtio_kick_queue(virtio_queue* queue)
+{
+	uint16 oldIndex = queue->kicked_index;
+	uint16 newIndex = queue->avail->index;
+	queue->kicked_index = newIndex;
+
+	// make sure we see the flags the device set after our index update
+	memory_write_barrier();
+	memory_read_barrier();
+
+	bool notify;
+	if ((queue->device->features & VIRTIO_FEATURE_RING_EVENT_IDX) != 0) {
+		// only notify if the device stopped somewhere in the requests added
+		// since the last kick; while it's still busy, it'll find them anyway
+		notify = vring_need_event(*vring_avail_event(queue->used, queue->size),
+			newIndex, oldIndex);
+	} else
+		notify = (queue->used->flags & VRING_USED_F_NO_NOTIFY) == 0;
+
+	if (notify)
+		write_16(queue->device, VIRTIO_PCI_QUEUE_NOTIFY, queue->index);
+}
+
+
+static bool
+virtio_dequeue(virtio_queue* queue, void** _cookie, uint32* _usedLength)
+{
+	if (queue->last_used == queue->used->index)
+		return false;
+
+	// don't read the element before the index that covers it
+	memory_read_barrier();
+
+	vring_used_element& element
+		= queue->used->ring[queue->last_used % queue->size];
+	uint16 head = element.id;
+	if (_usedLength != NULL)
+		*_usedLength = element.length;
+	queue->last_used++;
+
+	*_cookie = queue->cookies[head];
+	queue->cookies[head] = NULL;
+
+	// return the descriptor chain to the free list
+	uint16 index = head;
+	uint16 count = 1;
+	while ((queue->descriptors[index].flags & VRING_DESC_F_NEXT) != 0) {
+		index = queue->descriptors[index].next;
+		count++;
+	}
+
+	queue->descriptors[index].next = queue->free_head;
+	queue->free_head = head;
+	queue->free_count += count;
+
+	return true;
+}
+
+
+static bool
+virtio_set_queue_interrupt(virtio_queue* queue, bool enabled)
+{
+	if (!enabled) {
+		queue->avail->flags |= VRING_AVAIL_F_NO_INTERRUPT;
+		return false;
+	}
+
+	queue->avail->flags &= ~VRING_AVAIL_F_NO_INTERRUPT;
+	if ((queue->device->features & VIRTIO_FEATURE_RING_EVENT_IDX) != 0) {
+		// the device ignores the flag, and interrupts once it moves past
+		// the used index we have seen last
+		*vring_used_event(queue->avail, queue->size) = queue->last_used;
+	}
+
+	// Anything the device finished before it could see the flag change
+	// would not trigger an interrupt anymore
+	memory_write_barrier();
+	memory_read_barrier();
+	return queue->last_used != queue->used->index;
+}
+
+
+//	#pragma mark -
+
+
+static status_t
+std_ops(int32 op, ...)
+{
+	switch (op) {
+		case B_MODULE_INIT:
+		case B_MODULE_UNINIT:
+			return B_OK;
+
+		default:
+			return B_ERROR;
+	}
+}
+
+
+module_dependency module_dependencies[] = {
+	{ B_PCI_MODULE_NAME, (module_info**)&sPCI },
+	{}
+};
+
+
+static virtio_pci_module_info sVirtioModule = {
+	{
+		VIRTIO_PCI_MODULE_NAME,
+		0,
+		std_ops
+	},
+
+	virtio_init_device,
+	virtio_uninit_device,
+
+	virtio_negotiate_features,
+	virtio_set_driver_ok,
+	virtio_set_failed,
+
+	virtio_read_device_config,
+	virtio_write_device_config,
+
+	virtio_interrupt_status,
+
+	virtio_alloc_queue,
+	virtio_queue_size,
+	virtio_queue_free_count,
+
+	virtio_queue_request,
+	virtio_kick_queue,
+	virtio_dequeue,
+
+	virtio_set_queue_interrupt,
+
+	virtio_set_queue_indirect
+};
+
+module_info* modules[] = {
+	(module_info*)&sVirtioModule,
+	NULL
+};
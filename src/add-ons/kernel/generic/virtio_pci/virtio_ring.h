@@ -0,0 +1,122 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef VIRTIO_RING_H
+#define VIRTIO_RING_H
+
+
+#include <SupportDefs.h>
+
+
+// legacy PCI transport registers, relative to the I/O BAR 0
+#define VIRTIO_PCI_HOST_FEATURES	0x00	// 32 bit
+#define VIRTIO_PCI_GUEST_FEATURES	0x04	// 32 bit
+#define VIRTIO_PCI_QUEUE_PFN		0x08	// 32 bit
+#define VIRTIO_PCI_QUEUE_SIZE		0x0c	// 16 bit
+#define VIRTIO_PCI_QUEUE_SELECT		0x0e	// 16 bit
+#define VIRTIO_PCI_QUEUE_NOTIFY		0x10	// 16 bit
+#define VIRTIO_PCI_STATUS			0x12	// 8 bit
+#define VIRTIO_PCI_ISR				0x13	// 8 bit
+#define VIRTIO_PCI_CONFIG			0x14	// without MSI-X
+
+#define VIRTIO_PCI_QUEUE_ADDRESS_SHIFT	12
+#define VIRTIO_PCI_RING_ALIGNMENT		4096
+
+// device status
+#define VIRTIO_STATUS_RESET			0x00
+#define VIRTIO_STATUS_ACKNOWLEDGE	0x01
+#define VIRTIO_STATUS_DRIVER		0x02
+#define VIRTIO_STATUS_DRIVER_OK		0x04
+#define VIRTIO_STATUS_FAILED		0x80
+
+
+// descriptor flags
+#define VRING_DESC_F_NEXT			0x01
+#define VRING_DESC_F_WRITE			0x02
+#define VRING_DESC_F_INDIRECT		0x04
+
+// avail ring flags
+#define VRING_AVAIL_F_NO_INTERRUPT	0x01
+
+// used ring flags
+#define VRING_USED_F_NO_NOTIFY		0x01
+
+
+struct vring_desc {
+	uint64	address;
+	uint32	length;
+	uint16	flags;
+	uint16	next;
+} _PACKED;
+
+struct vring_avail {
+	uint16	flags;
+	uint16	index;
+	uint16	ring[0];
+	// followed by uint16 used_event
+} _PACKED;
+
+struct vring_used_element {
+	uint32	id;
+	uint32	length;
+} _PACKED;
+
+struct vring_used {
+	uint16	flags;
+	uint16	index;
+	vring_used_element ring[0];
+	// followed by uint16 avail_event
+} _PACKED;
+
+
+static inline uint16*
+vring_used_event(vring_avail* avail, uint16 size)
+{
+	return &avail->ring[size];
+}
+
+
+static inline uint16*
+vring_avail_event(vring_used* used, uint16 size)
+{
+	return (uint16*)&used->ring[size];
+}
+
+
+/*!	Returns whether the other side asked to be notified when the index moves
+	from \a oldIndex to \a newIndex, given the \a event index it published.
+*/
+static inline bool
+vring_need_event(uint16 event, uint16 newIndex, uint16 oldIndex)
+{
+	return (uint16)(newIndex - event - 1) < (uint16)(newIndex - oldIndex);
+}
+
+
+static inline size_t
+vring_avail_offset(uint16 size)
+{
+	return size * sizeof(vring_desc);
+}
+
+
+static inline size_t
+vring_used_offset(uint16 size)
+{
+	size_t offset = vring_avail_offset(size) + sizeof(vring_avail)
+		+ (size + 1) * sizeof(uint16);
+	return (offset + VIRTIO_PCI_RING_ALIGNMENT - 1)
+		& ~(size_t)(VIRTIO_PCI_RING_ALIGNMENT - 1);
+}
+
+
+static inline size_t
+vring_size(uint16 size)
+{
+	return vring_used_offset(size) + sizeof(vring_used)
+		+ size * sizeof(vring_used_element) + sizeof(uint16);
+}
+
+
+#endif	// VIRTIO_RING_H
@@ -702,7 +702,8 @@ net_protocol_module_info sICMPModule = {
 	NULL,		// process_ancillary_data()
 	NULL,		// process_ancillary_data_no_container()
 	NULL,		// send_data_no_buffer()
-	NULL		// read_data_no_buffer()
+	NULL,		// read_data_no_buffer()
+	NULL		// read_multiple_data()
 };
 
 module_dependency module_dependencies[] = {
@@ -1956,7 +1956,8 @@ net_protocol_module_info gIPv4Module = {
 	NULL,		// process_ancillary_data()
 	ipv4_process_ancillary_data_no_container,
 	NULL,		// send_data_no_buffer()
-	NULL		// read_data_no_buffer()
+	NULL,		// read_data_no_buffer()
+	NULL		// read_multiple_data()
 };
 
 module_dependency module_dependencies[] = {
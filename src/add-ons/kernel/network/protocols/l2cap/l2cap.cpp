@@ -400,7 +400,8 @@ net_protocol_module_info gL2CAPModule = {
 	NULL,		// process_ancillary_data()
 	NULL,		// process_ancillary_data_no_container()
 	NULL,		// send_data_no_buffer()
-	NULL		// read_data_no_buffer()
+	NULL,		// read_data_no_buffer()
+	NULL		// read_multiple_data()
 };
 
 module_dependency module_dependencies[] = {
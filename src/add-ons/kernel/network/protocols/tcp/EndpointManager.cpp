@@ -175,6 +175,54 @@ ConnectionHashDefinition::GetLink(TCPEndpoint* endpoint) const
 //	#pragma mark -
 
 
+ListenerHashDefinition::ListenerHashDefinition(EndpointManager* manager)
+	:
+	fManager(manager)
+{
+}
+
+
+size_t
+ListenerHashDefinition::HashKey(const sockaddr* local) const
+{
+	return fManager->AddressModule()->hash_address(local, true);
+}
+
+
+size_t
+ListenerHashDefinition::Hash(TCPEndpoint* endpoint) const
+{
+	return HashKey(*endpoint->LocalAddress());
+}
+
+
+bool
+ListenerHashDefinition::Compare(const sockaddr* local,
+	TCPEndpoint* endpoint) const
+{
+	return endpoint->LocalAddress().EqualTo(local, true);
+}
+
+
+bool
+ListenerHashDefinition::CompareValues(TCPEndpoint* first,
+	TCPEndpoint* second) const
+{
+	return first->LocalAddress().EqualTo(*second->LocalAddress(), true);
+}
+
+
+TCPEndpoint*&
+ListenerHashDefinition::GetLink(TCPEndpoint* endpoint) const
+{
+	// an endpoint is either listening, or part of a connection
+	return endpoint->fConnectionHashLink;
+}
+
+
+//	#pragma mark -
+
+
 size_t
 EndpointHashDefinition::HashKey(uint16 port) const
 {
@@ -214,18 +262,43 @@ EndpointHashDefinition::GetLink(TCPEndpoint* endpoint) const
 //	#pragma mark -
 
 
+EndpointManager::ConnectionStripe::ConnectionStripe(EndpointManager* manager)
+	:
+	table(manager)
+{
+	rw_lock_init(&lock, "TCP connection stripe");
+}
+
+
+EndpointManager::ConnectionStripe::~ConnectionStripe()
+{
+	rw_lock_destroy(&lock);
+}
+
+
+//	#pragma mark -
+
+
 EndpointManager::EndpointManager(net_domain* domain)
 	:
 	fDomain(domain),
-	fConnectionHash(this),
+	fListenerHash(this),
 	fLastPort(kFirstEphemeralPort)
 {
 	rw_lock_init(&fLock, "TCP endpoint manager");
+	rw_lock_init(&fListenerLock, "TCP listeners");
+
+	for (uint32 i = 0; i < kConnectionStripes; i++)
+		fConnectionStripes[i] = NULL;
 }
 
 
 EndpointManager::~EndpointManager()
 {
+	for (uint32 i = 0; i < kConnectionStripes; i++)
+		delete fConnectionStripes[i];
+
+	rw_lock_destroy(&fListenerLock);
 	rw_lock_destroy(&fLock);
 }
 
@@ -233,7 +306,17 @@ EndpointManager::~EndpointManager()
 status_t
 EndpointManager::Init()
 {
-	status_t status = fConnectionHash.Init();
+	for (uint32 i = 0; i < kConnectionStripes; i++) {
+		fConnectionStripes[i] = new(std::nothrow) ConnectionStripe(this);
+		if (fConnectionStripes[i] == NULL)
+			return B_NO_MEMORY;
+
+		status_t status = fConnectionStripes[i]->table.Init();
+		if (status != B_OK)
+			return status;
+	}
+
+	status_t status = fListenerHash.Init();
 	if (status == B_OK)
 		status = fEndpointHash.Init();
 
@@ -244,14 +327,82 @@ EndpointManager::Init()
 //	#pragma mark - connections
 
 
+/*!	Returns the stripe that holds the connection between \a local and
+	\a peer. The stripe's lock protects its part of the connection table.
+*/
+EndpointManager::ConnectionStripe*
+EndpointManager::_StripeFor(const sockaddr* local, const sockaddr* peer) const
+{
+	// use the upper bits, as the lower ones select the bucket within the
+	// stripe's table
+	uint32 hash = AddressModule()->hash_address_pair(local, peer) * 0x9e3779b1;
+	return fConnectionStripes[hash >> (32 - kConnectionStripeShift)];
+}
+
+
 /*!	Returns the endpoint matching the connection.
-	You must hold the manager's lock when calling this method (either read or
+	You must hold the \a stripe's lock when calling this method (either read
+	or write).
+*/
+TCPEndpoint*
+EndpointManager::_LookupConnection(ConnectionStripe* stripe,
+	const sockaddr* local, const sockaddr* peer)
+{
+	return stripe->table.Lookup(std::make_pair(local, peer));
+}
+
+
+/*!	Returns the listening endpoint that should accept a connection from
+	\a peer to \a local.
+	If several sockets have been bound to the same address using SO_REUSEPORT,
+	incoming connections are distributed among them by the hash of the peer
+	address, so that a given peer always ends up at the same listener.
+	You must hold the fListenerLock when calling this method (either read or
 	write).
 */
 TCPEndpoint*
-EndpointManager::_LookupConnection(const sockaddr* local, const sockaddr* peer)
+EndpointManager::_LookupListener(const sockaddr* local, const sockaddr* peer)
 {
-	return fConnectionHash.Lookup(std::make_pair(local, peer));
+	ListenerTable::ValueIterator iterator = fListenerHash.Lookup(local);
+	if (!iterator.HasNext())
+		return NULL;
+
+	uint32 count = 0;
+	while (iterator.HasNext()) {
+		iterator.Next();
+		count++;
+	}
+
+	iterator.Rewind();
+	TCPEndpoint* listener = iterator.Next();
+
+	if (count > 1 && peer != NULL) {
+		uint32 index = AddressModule()->hash_address(peer, true) % count;
+		while (index-- > 0)
+			listener = iterator.Next();
+	}
+
+	return listener;
+}
+
+
+/*!	Removes the \a endpoint from the connection or listener table, depending
+	on which one it is in.
+	You must hold the fLock when calling this method.
+*/
+bool
+EndpointManager::_RemoveConnection(TCPEndpoint* endpoint)
+{
+	if (endpoint->PeerAddress().IsEmpty(false)) {
+		WriteLocker _(fListenerLock);
+		return fListenerHash.Remove(endpoint);
+	}
+
+	ConnectionStripe* stripe = _StripeFor(*endpoint->LocalAddress(),
+		*endpoint->PeerAddress());
+
+	WriteLocker _(stripe->lock);
+	return stripe->table.Remove(endpoint);
 }
 
 
@@ -261,8 +412,6 @@ EndpointManager::SetConnection(TCPEndpoint* endpoint, const sockaddr* _local,
 {
 	TRACE(("EndpointManager::SetConnection(%p)\n", endpoint));
 
-	WriteLocker _(fLock);
-
 	SocketAddressStorage local(AddressModule());
 	local.SetTo(_local);
 
@@ -272,14 +421,36 @@ EndpointManager::SetConnection(TCPEndpoint* endpoint, const sockaddr* _local,
 		local.SetPort(port);
 	}
 
-	if (_LookupConnection(*local, peer) != NULL)
-		return EADDRINUSE;
+	ConnectionStripe* stripe = _StripeFor(*local, peer);
+	WriteLocker _(stripe->lock);
+
+	TCPEndpoint* other = _LookupConnection(stripe, *local, peer);
+	if (other != NULL) {
+		// A connection that is only lingering in TIME_WAIT may be replaced
+		// if the new incarnation starts beyond the sequence space of the old
+		// one (RFC 1122, 4.2.2.13), so that delayed segments can't be
+		// mistaken for new data. Our initial sequence numbers only advance
+		// slowly with the system time and wrap around, so this isn't a given.
+		// The old endpoint is left to its timer, but it won't receive any
+		// segments anymore.
+		// Its state can only be looked at with its lock held. Since its
+		// timer locks it before the stripe, we may only try to get it here.
+		if (mutex_trylock(&other->fLock) != B_OK)
+			return EADDRINUSE;
+		MutexLocker otherLocker(other->fLock, true);
+
+		if (other->State() != TIME_WAIT
+			|| endpoint->fInitialSendSequence <= other->fSendMax)
+			return EADDRINUSE;
+
+		stripe->table.Remove(other);
+	}
 
 	endpoint->LocalAddress().SetTo(*local);
 	endpoint->PeerAddress().SetTo(peer);
 	T(Connect(endpoint));
 
-	fConnectionHash.Insert(endpoint);
+	stripe->table.Insert(endpoint);
 	return B_OK;
 }
 
@@ -299,14 +470,23 @@ EndpointManager::SetPassive(TCPEndpoint* endpoint)
 			return status;
 	}
 
+	WriteLocker listenerLocker(fListenerLock);
+
+	// several listeners may share an address if all of them ask for it
+	ListenerTable::ValueIterator iterator
+		= fListenerHash.Lookup(*endpoint->LocalAddress());
+	while (iterator.HasNext()) {
+		TCPEndpoint* listener = iterator.Next();
+		if ((endpoint->socket->options & SO_REUSEPORT) == 0
+			|| (listener->socket->options & SO_REUSEPORT) == 0)
+			return EADDRINUSE;
+	}
+
 	SocketAddressStorage passive(AddressModule());
 	passive.SetToEmpty();
 
-	if (_LookupConnection(*endpoint->LocalAddress(), *passive))
-		return EADDRINUSE;
-
 	endpoint->PeerAddress().SetTo(*passive);
-	fConnectionHash.Insert(endpoint);
+	fListenerHash.Insert(endpoint);
 	return B_OK;
 }
 
@@ -314,9 +494,10 @@ EndpointManager::SetPassive(TCPEndpoint* endpoint)
 TCPEndpoint*
 EndpointManager::FindConnection(sockaddr* local, sockaddr* peer)
 {
-	ReadLocker _(fLock);
+	ConnectionStripe* stripe = _StripeFor(local, peer);
+	ReadLocker stripeLocker(stripe->lock);
 
-	TCPEndpoint *endpoint = _LookupConnection(local, peer);
+	TCPEndpoint *endpoint = _LookupConnection(stripe, local, peer);
 	if (endpoint != NULL) {
 		TRACE(("TCP: Received packet corresponds to explicit endpoint %p\n",
 			endpoint));
@@ -324,12 +505,13 @@ EndpointManager::FindConnection(sockaddr* local, sockaddr* peer)
 			return endpoint;
 	}
 
+	stripeLocker.Unlock();
+
 	// no explicit endpoint exists, check for wildcard endpoints
 
-	SocketAddressStorage wildcard(AddressModule());
-	wildcard.SetToEmpty();
+	ReadLocker listenerLocker(fListenerLock);
 
-	endpoint = _LookupConnection(local, *wildcard);
+	endpoint = _LookupListener(local, peer);
 	if (endpoint != NULL) {
 		TRACE(("TCP: Received packet corresponds to wildcard endpoint %p\n",
 			endpoint));
@@ -341,7 +523,7 @@ EndpointManager::FindConnection(sockaddr* local, sockaddr* peer)
 	localWildcard.SetToEmpty();
 	localWildcard.SetPort(AddressModule()->get_port(local));
 
-	endpoint = _LookupConnection(*localWildcard, *wildcard);
+	endpoint = _LookupListener(*localWildcard, peer);
 	if (endpoint != NULL) {
 		TRACE(("TCP: Received packet corresponds to local wildcard endpoint "
 			"%p\n", endpoint));
@@ -431,6 +613,12 @@ EndpointManager::_BindToAddress(WriteLocker& locker, TCPEndpoint* endpoint,
 					break;
 				}
 
+				// listeners that want to share the port are sorted out
+				// in SetPassive()
+				if ((endpoint->socket->options & SO_REUSEPORT) != 0
+					&& (user->socket->options & SO_REUSEPORT) != 0)
+					continue;
+
 				if ((endpoint->socket->options & SO_REUSEADDR) == 0)
 					return EADDRINUSE;
 
@@ -520,7 +708,7 @@ EndpointManager::Unbind(TCPEndpoint* endpoint)
 	if (!fEndpointHash.Remove(endpoint))
 		panic("bound endpoint %p not in hash!", endpoint);
 
-	fConnectionHash.Remove(endpoint);
+	_RemoveConnection(endpoint);
 
 	(*endpoint->LocalAddress())->sa_len = 0;
 
@@ -573,18 +761,28 @@ EndpointManager::Dump() const
 	kprintf("%10s %21s %21s %8s %8s %12s\n", "address", "local", "peer",
 		"recv-q", "send-q", "state");
 
-	ConnectionTable::Iterator iterator = fConnectionHash.GetIterator();
+	ListenerTable::Iterator listenerIterator = fListenerHash.GetIterator();
+	while (listenerIterator.HasNext())
+		_DumpEndpoint(listenerIterator.Next());
 
-	while (iterator.HasNext()) {
-		TCPEndpoint *endpoint = iterator.Next();
+	for (uint32 i = 0; i < kConnectionStripes; i++) {
+		ConnectionTable::Iterator iterator
+			= fConnectionStripes[i]->table.GetIterator();
+		while (iterator.HasNext())
+			_DumpEndpoint(iterator.Next());
+	}
+}
 
-		char localBuf[64], peerBuf[64];
-		endpoint->LocalAddress().AsString(localBuf, sizeof(localBuf), true);
-		endpoint->PeerAddress().AsString(peerBuf, sizeof(peerBuf), true);
 
-		kprintf("%p %21s %21s %8lu %8lu %12s\n", endpoint, localBuf, peerBuf,
-			endpoint->fReceiveQueue.Available(), endpoint->fSendQueue.Used(),
-			name_for_state(endpoint->State()));
-	}
+/*static*/ void
+EndpointManager::_DumpEndpoint(TCPEndpoint* endpoint)
+{
+	char localBuf[64], peerBuf[64];
+	endpoint->LocalAddress().AsString(localBuf, sizeof(localBuf), true);
+	endpoint->PeerAddress().AsString(peerBuf, sizeof(peerBuf), true);
+
+	kprintf("%p %21s %21s %8lu %8lu %12s\n", endpoint, localBuf, peerBuf,
+		endpoint->fReceiveQueue.Available(), endpoint->fSendQueue.Used(),
+		name_for_state(endpoint->State()));
 }
 
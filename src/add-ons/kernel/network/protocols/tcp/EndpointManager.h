@@ -52,6 +52,31 @@ private:
 };
 
 
+class ListenerHashDefinition {
+public:
+	typedef const sockaddr* KeyType;
+	typedef TCPEndpoint ValueType;
+
+							ListenerHashDefinition(EndpointManager* manager);
+							ListenerHashDefinition(
+									const ListenerHashDefinition& definition)
+								: fManager(definition.fManager)
+							{
+							}
+
+			size_t			HashKey(const sockaddr* local) const;
+			size_t			Hash(TCPEndpoint* endpoint) const;
+			bool			Compare(const sockaddr* local,
+								TCPEndpoint* endpoint) const;
+			bool			CompareValues(TCPEndpoint* first,
+								TCPEndpoint* second) const;
+			TCPEndpoint*&	GetLink(TCPEndpoint* endpoint) const;
+
+private:
+	EndpointManager*		fManager;
+};
+
+
 class EndpointHashDefinition {
 public:
 	typedef uint16 KeyType;
@@ -95,8 +120,26 @@ public:
 			void			Dump() const;
 
 private:
-			TCPEndpoint*	_LookupConnection(const sockaddr* local,
+	typedef BOpenHashTable<ConnectionHashDefinition> ConnectionTable;
+	typedef MultiHashTable<ListenerHashDefinition> ListenerTable;
+	typedef MultiHashTable<EndpointHashDefinition> EndpointTable;
+
+	struct ConnectionStripe {
+								ConnectionStripe(EndpointManager* manager);
+								~ConnectionStripe();
+
+			rw_lock				lock;
+			ConnectionTable		table;
+	};
+
+			ConnectionStripe* _StripeFor(const sockaddr* local,
+								const sockaddr* peer) const;
+			TCPEndpoint*	_LookupConnection(ConnectionStripe* stripe,
+								const sockaddr* local, const sockaddr* peer);
+			TCPEndpoint*	_LookupListener(const sockaddr* local,
 								const sockaddr* peer);
+			bool			_RemoveConnection(TCPEndpoint* endpoint);
+	static	void			_DumpEndpoint(TCPEndpoint* endpoint);
 			status_t		_Bind(TCPEndpoint* endpoint,
 								const sockaddr* address);
 			status_t		_BindToAddress(WriteLocker& locker,
@@ -104,12 +147,16 @@ private:
 			status_t		_BindToEphemeral(TCPEndpoint* endpoint,
 								const sockaddr* address);
 
-	typedef BOpenHashTable<ConnectionHashDefinition> ConnectionTable;
-	typedef MultiHashTable<EndpointHashDefinition> EndpointTable;
+	static const uint32		kConnectionStripeShift = 4;
+	static const uint32		kConnectionStripes = 1 << kConnectionStripeShift;
 
 	rw_lock					fLock;
+		// protects fEndpointHash and fLastPort; must be acquired before
+		// any of the stripe locks or fListenerLock
 	net_domain*				fDomain;
-	ConnectionTable			fConnectionHash;
+	ConnectionStripe*		fConnectionStripes[kConnectionStripes];
+	rw_lock					fListenerLock;
+	ListenerTable			fListenerHash;
 	EndpointTable			fEndpointHash;
 	uint16					fLastPort;
 };
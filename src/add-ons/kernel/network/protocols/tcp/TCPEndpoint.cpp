@@ -2129,13 +2129,16 @@ TCPEndpoint::_PrepareSendPath(const sockaddr* peer)
 			fFlags |= FLAG_LOCAL;
 	}
 
+	// the connection manager needs the initial sequence to decide whether
+	// an old connection in TIME_WAIT may be replaced
+	fInitialSendSequence = system_time() >> 4;
+
 	// make sure connection does not already exist
 	status_t status = fManager->SetConnection(this, *LocalAddress(), peer,
 		fRoute->interface_address->local);
 	if (status < B_OK)
 		return status;
 
-	fInitialSendSequence = system_time() >> 4;
 	fSendNext = fInitialSendSequence;
 	fSendUnacknowledged = fInitialSendSequence;
 	fSendMax = fInitialSendSequence;
@@ -137,6 +137,7 @@ private:
 	TCPEndpoint*	fEndpointHashLink;
 	friend class EndpointManager;
 	friend class ConnectionHashDefinition;
+	friend class ListenerHashDefinition;
 	friend class EndpointHashDefinition;
 
 	mutex			fLock;
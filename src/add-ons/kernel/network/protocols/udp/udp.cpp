@@ -90,6 +90,8 @@ public:
 			ssize_t				BytesAvailable();
 			status_t			FetchData(size_t numBytes, uint32 flags,
 									net_buffer** _buffer);
+			status_t			FetchMultipleData(uint32 flags,
+									net_buffer** _buffers, uint32* _count);
 
 			status_t			StoreData(net_buffer* buffer);
 			status_t			DeliverData(net_buffer* buffer);
@@ -1048,6 +1050,23 @@ UdpEndpoint::FetchData(size_t numBytes, uint32 flags, net_buffer **_buffer)
 }
 
 
+status_t
+UdpEndpoint::FetchMultipleData(uint32 flags, net_buffer** _buffers,
+	uint32* _count)
+{
+	TRACE_EP("FetchMultipleData(0x%lx, %lu)", flags, *_count);
+
+	status_t status = DequeueMultiple(flags, _buffers, _count);
+	TRACE_EP("  FetchMultipleData(): returned from fifo status: %s",
+		strerror(status));
+	if (status != B_OK)
+		return status;
+
+	TRACE_EP("  FetchMultipleData(): returns %lu buffers", *_count);
+	return B_OK;
+}
+
+
 status_t
 UdpEndpoint::StoreData(net_buffer *buffer)
 {
@@ -1234,6 +1253,15 @@ udp_read_data(net_protocol *protocol, size_t numBytes, uint32 flags,
 }
 
 
+status_t
+udp_read_multiple_data(net_protocol *protocol, uint32 flags,
+	net_buffer **_buffers, uint32 *_count)
+{
+	return ((UdpEndpoint *)protocol)->FetchMultipleData(flags, _buffers,
+		_count);
+}
+
+
 ssize_t
 udp_read_avail(net_protocol *protocol)
 {
@@ -1457,7 +1485,8 @@ net_protocol_module_info sUDPModule = {
 	NULL,		// process_ancillary_data()
 	udp_process_ancillary_data_no_container,
 	NULL,		// send_data_no_buffer()
-	NULL		// read_data_no_buffer()
+	NULL,		// read_data_no_buffer()
+	udp_read_multiple_data
 };
 
 module_dependency module_dependencies[] = {
@@ -456,13 +456,13 @@ UnixEndpoint::Send(const iovec *vecs, size_t vecCount,
 
 	// Notify select()ing readers, if we successfully wrote anything.
 	size_t readable = peerFifo->Readable();
-	bool notifyRead = (error == B_OK && readable > 0
+	bool notifyRead = (result >= 0 && readable > 0
 		&& !peerFifo->IsReadShutdown());
 
 	// Notify select()ing writers, if we failed to write anything and there's
 	// still room to write.
 	size_t writable = peerFifo->Writable();
-	bool notifyWrite = (error != B_OK && writable > 0
+	bool notifyWrite = (result < 0 && writable > 0
 		&& !peerFifo->IsWriteShutdown());
 
 	// re-lock our endpoint (unlock FIFO to respect locking order)
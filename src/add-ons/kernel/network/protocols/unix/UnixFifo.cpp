@@ -98,7 +98,8 @@ UnixRequest::AddAncillaryData(ancillary_data_container* data)
 UnixBufferQueue::UnixBufferQueue(size_t capacity)
 	:
 	fBuffer(NULL),
-	fCapacity(capacity)
+	fCapacity(capacity),
+	fAncillaryDataTailOffset(0)
 {
 }
 
@@ -176,8 +177,11 @@ UnixBufferQueue::Read(UnixRequest& request)
 				entry = fAncillaryData.Head();
 			}
 
-			if (entry != NULL)
+			if (entry != NULL) {
 				entry->offset -= offsetDelta;
+				fAncillaryDataTailOffset -= bytesRead;
+			} else
+				fAncillaryDataTailOffset = 0;
 		}
 
 		request.AddBytesTransferred(bytesRead);
@@ -207,14 +211,9 @@ UnixBufferQueue::Write(UnixRequest& request)
 
 		ancillaryEntryDeleter.SetTo(ancillaryEntry);
 		ancillaryEntry->data = request.AncillaryData();
-		ancillaryEntry->offset = Readable();
 
 		// The offsets are relative to the previous entry.
-		AncillaryDataList::Iterator it = fAncillaryData.GetIterator();
-		while (AncillaryDataEntry* entry = it.Next())
-			ancillaryEntry->offset -= entry->offset;
-			// TODO: This is inefficient when the list is long. Rather also
-			// store and maintain the absolute offset of the last queued entry.
+		ancillaryEntry->offset = Readable() - fAncillaryDataTailOffset;
 	}
 
 	// write as much as we can
@@ -235,6 +234,7 @@ UnixBufferQueue::Write(UnixRequest& request)
 
 		if (ancillaryEntry != NULL) {
 			fAncillaryData.Add(ancillaryEntry);
+			fAncillaryDataTailOffset += ancillaryEntry->offset;
 			ancillaryEntryDeleter.Detach();
 			request.SetAncillaryData(NULL);
 			ancillaryEntry = NULL;
@@ -251,8 +251,29 @@ UnixBufferQueue::Write(UnixRequest& request)
 status_t
 UnixBufferQueue::SetCapacity(size_t capacity)
 {
-// TODO:...
-return B_ERROR;
+	size_t readable = Readable();
+	if (capacity < readable)
+		capacity = readable;
+	if (capacity == fCapacity)
+		return B_OK;
+
+	ring_buffer* newBuffer = create_ring_buffer(capacity);
+	if (newBuffer == NULL)
+		return B_NO_MEMORY;
+
+	// Move the queued data over. The ancillary data offsets are relative to
+	// the read position, so they remain valid.
+	iovec vecs[2];
+	int32 vecCount = ring_buffer_get_vecs(fBuffer, vecs);
+	for (int32 i = 0; i < vecCount; i++) {
+		ring_buffer_write(newBuffer, (const uint8*)vecs[i].iov_base,
+			vecs[i].iov_len);
+	}
+
+	delete_ring_buffer(fBuffer);
+	fBuffer = newBuffer;
+	fCapacity = capacity;
+	return B_OK;
 }
 
 
@@ -81,6 +81,9 @@ private:
 	ring_buffer*		fBuffer;
 	size_t				fCapacity;
 	AncillaryDataList	fAncillaryData;
+	size_t				fAncillaryDataTailOffset;
+		// the offset of the last ancillary data entry relative to the
+		// current read position, i.e. the sum of all entry offsets
 };
 
 
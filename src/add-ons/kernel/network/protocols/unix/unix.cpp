@@ -511,7 +511,8 @@ net_protocol_module_info gUnixModule = {
 	unix_process_ancillary_data,
 	NULL,
 	unix_send_data_no_buffer,
-	unix_read_data_no_buffer
+	unix_read_data_no_buffer,
+	NULL		// read_multiple_data()
 };
 
 module_dependency module_dependencies[] = {
@@ -139,6 +139,8 @@ register_domain(int family, const char* name,
 	domain->module = module;
 	domain->address_module = addressModule;
 
+	init_route_cache(domain);
+
 	sDomains.Add(domain);
 
 	*_domain = domain;
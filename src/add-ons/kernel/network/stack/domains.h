@@ -25,6 +25,8 @@ struct net_domain_private : net_domain,
 
 	RouteList			routes;
 	RouteInfoList		route_infos;
+	uint32				route_generation;
+	route_cache_entry	route_cache[ROUTE_CACHE_SIZE];
 };
 
 
@@ -45,6 +45,10 @@
 #endif
 
 
+// the most buffers socket_receive_multiple() takes from the protocol at once
+static const uint32 kMaxReceiveMultiple = 64;
+
+
 struct net_socket_private;
 typedef DoublyLinkedList<net_socket_private> SocketList;
 
@@ -334,6 +338,94 @@ socket_receive_no_buffer(net_socket* socket, msghdr* header, void* data,
 }
 
 
+/*!	Copies the contents of \a buffer, which has been read from the socket's
+	protocol, into the \a header, and frees it.
+*/
+static ssize_t
+socket_receive_buffer(net_socket* socket, net_buffer* buffer, msghdr* header,
+	void* data, size_t length, int flags)
+{
+	// process ancillary data
+	if (header != NULL) {
+		if (buffer != NULL && header->msg_control != NULL) {
+			ancillary_data_container* container
+				= gNetBufferModule.get_ancillary_data(buffer);
+			status_t status;
+			if (container != NULL)
+				status = process_ancillary_data(socket, container, header);
+			else
+				status = process_ancillary_data(socket, buffer, header);
+			if (status != B_OK) {
+				gNetBufferModule.free(buffer);
+				return status;
+			}
+		} else
+			header->msg_controllen = 0;
+	}
+
+	// TODO: - returning a NULL buffer when received 0 bytes
+	//         may not make much sense as we still need the address
+	//       - gNetBufferModule.read() uses memcpy() instead of user_memcpy
+
+	size_t nameLen = 0;
+
+	if (header) {
+		// TODO: - consider the control buffer options
+		nameLen = header->msg_namelen;
+		header->msg_namelen = 0;
+		header->msg_flags = 0;
+	}
+
+	if (buffer == NULL)
+		return 0;
+
+	size_t bytesReceived = buffer->size, bytesCopied = 0;
+
+	length = min_c(bytesReceived, length);
+	if (gNetBufferModule.read(buffer, 0, data, length) < B_OK) {
+		gNetBufferModule.free(buffer);
+		return ENOBUFS;
+	}
+
+	// if first copy was a success, proceed to following
+	// copies as required
+	bytesCopied += length;
+
+	if (header) {
+		// we only start considering at iovec[1]
+		// as { data, length } is iovec[0]
+		for (int i = 1; i < header->msg_iovlen && bytesCopied < bytesReceived;
+				i++) {
+			iovec& vec = header->msg_iov[i];
+			size_t toRead = min_c(bytesReceived - bytesCopied, vec.iov_len);
+			if (gNetBufferModule.read(buffer, bytesCopied, vec.iov_base,
+					toRead) < B_OK) {
+				break;
+			}
+
+			bytesCopied += toRead;
+		}
+
+		if (header->msg_name != NULL) {
+			header->msg_namelen = min_c(nameLen, buffer->source->sa_len);
+			memcpy(header->msg_name, buffer->source, header->msg_namelen);
+		}
+	}
+
+	gNetBufferModule.free(buffer);
+
+	if (bytesCopied < bytesReceived) {
+		if (header)
+			header->msg_flags = MSG_TRUNC;
+
+		if (flags & MSG_TRUNC)
+			return bytesReceived;
+	}
+
+	return bytesCopied;
+}
+
+
 #if ENABLE_DEBUGGER_COMMANDS
 
 
@@ -1231,82 +1323,69 @@ socket_receive(net_socket* socket, msghdr* header, void* data, size_t length,
 	if (status != B_OK)
 		return status;
 
-	// process ancillary data
-	if (header != NULL) {
-		if (buffer != NULL && header->msg_control != NULL) {
-			ancillary_data_container* container
-				= gNetBufferModule.get_ancillary_data(buffer);
-			if (container != NULL)
-				status = process_ancillary_data(socket, container, header);
-			else
-				status = process_ancillary_data(socket, buffer, header);
-			if (status != B_OK) {
-				gNetBufferModule.free(buffer);
-				return status;
-			}
-		} else
-			header->msg_controllen = 0;
-	}
-
-	// TODO: - returning a NULL buffer when received 0 bytes
-	//         may not make much sense as we still need the address
-	//       - gNetBufferModule.read() uses memcpy() instead of user_memcpy
-
-	size_t nameLen = 0;
-
-	if (header) {
-		// TODO: - consider the control buffer options
-		nameLen = header->msg_namelen;
-		header->msg_namelen = 0;
-		header->msg_flags = 0;
-	}
-
-	if (buffer == NULL)
-		return 0;
-
-	size_t bytesReceived = buffer->size, bytesCopied = 0;
-
-	length = min_c(bytesReceived, length);
-	if (gNetBufferModule.read(buffer, 0, data, length) < B_OK) {
-		gNetBufferModule.free(buffer);
-		return ENOBUFS;
-	}
+	return socket_receive_buffer(socket, buffer, header, data, length, flags);
+}
 
-	// if first copy was a success, proceed to following
-	// copies as required
-	bytesCopied += length;
 
-	if (header) {
-		// we only start considering at iovec[1]
-		// as { data, length } is iovec[0]
-		for (i = 1; i < header->msg_iovlen && bytesCopied < bytesReceived; i++) {
-			iovec& vec = header->msg_iov[i];
-			size_t toRead = min_c(bytesReceived - bytesCopied, vec.iov_len);
-			if (gNetBufferModule.read(buffer, bytesCopied, vec.iov_base,
-					toRead) < B_OK) {
-				break;
+/*!	Receives up to \a count messages. Like socket_receive(), it waits for
+	the first one according to \a flags, but then only takes the ones that
+	are already queued. If the protocol supports it, they are all taken out
+	of its queue at once.
+	Returns the number of messages received, and sets their \c msg_len
+	fields.
+*/
+ssize_t
+socket_receive_multiple(net_socket* socket, mmsghdr* messages, uint32 count,
+	int flags)
+{
+	if (socket->first_info->read_multiple_data == NULL) {
+		uint32 received = 0;
+		while (received < count) {
+			msghdr& header = messages[received].msg_hdr;
+			ssize_t bytesReceived = socket_receive(socket, &header,
+				header.msg_iovlen > 0 ? header.msg_iov[0].iov_base : NULL,
+				header.msg_iovlen > 0 ? header.msg_iov[0].iov_len : 0, flags);
+			if (bytesReceived < 0) {
+				if (received > 0)
+					break;
+				return bytesReceived;
 			}
 
-			bytesCopied += toRead;
+			messages[received++].msg_len = bytesReceived;
+			flags |= MSG_DONTWAIT;
 		}
 
-		if (header->msg_name != NULL) {
-			header->msg_namelen = min_c(nameLen, buffer->source->sa_len);
-			memcpy(header->msg_name, buffer->source, header->msg_namelen);
-		}
+		return received;
 	}
 
-	gNetBufferModule.free(buffer);
+	net_buffer* buffers[kMaxReceiveMultiple];
+	if (count > kMaxReceiveMultiple)
+		count = kMaxReceiveMultiple;
+	if (count == 0)
+		return 0;
 
-	if (bytesCopied < bytesReceived) {
-		if (header)
-			header->msg_flags = MSG_TRUNC;
+	status_t status = socket->first_info->read_multiple_data(
+		socket->first_protocol, flags, buffers, &count);
+	if (status != B_OK)
+		return status;
 
-		if (flags & MSG_TRUNC)
-			return bytesReceived;
+	for (uint32 i = 0; i < count; i++) {
+		msghdr& header = messages[i].msg_hdr;
+		ssize_t bytesReceived = socket_receive_buffer(socket, buffers[i],
+			&header, header.msg_iovlen > 0 ? header.msg_iov[0].iov_base : NULL,
+			header.msg_iovlen > 0 ? header.msg_iov[0].iov_len : 0, flags);
+		if (bytesReceived < 0) {
+			// the remaining buffers are dropped like the failed one
+			for (uint32 j = i + 1; j < count; j++)
+				gNetBufferModule.free(buffers[j]);
+
+			return i > 0 ? (ssize_t)i : bytesReceived;
+		}
+
+		messages[i].msg_len = bytesReceived;
 	}
 
-	return bytesCopied;
+	return count;
 }
 
 
@@ -1763,6 +1842,7 @@ net_socket_module_info gNetSocketModule = {
 	socket_getsockopt,
 	socket_listen,
 	socket_receive,
+	socket_receive_multiple,
 	socket_send,
 	socket_setsockopt,
 	socket_shutdown,
@@ -137,8 +137,12 @@ find_route(struct net_domain* _domain, const net_route* description)
 }
 
 
+/*!	Finds the route to \a address. If \a _first is given, it is set to
+	whether the returned route is the first matching one in the list; only
+	then does the result not depend on the link state of other routes.
+*/
 static net_route_private*
-find_route(net_domain* _domain, const sockaddr* address)
+find_route(net_domain* _domain, const sockaddr* address, bool* _first = NULL)
 {
 	net_domain_private* domain = (net_domain_private*)_domain;
 
@@ -156,11 +160,11 @@ find_route(net_domain* _domain, const sockaddr* address)
 		net_route_private* route = iterator.Next();
 
 		if (route->mask) {
-			sockaddr maskedAddress;
+			sockaddr_storage maskedAddress;
 			domain->address_module->mask_address(address, route->mask,
-				&maskedAddress);
-			if (!domain->address_module->equal_addresses(&maskedAddress,
-					route->destination))
+				(sockaddr*)&maskedAddress);
+			if (!domain->address_module->equal_addresses(
+					(sockaddr*)&maskedAddress, route->destination))
 				continue;
 		} else if (!domain->address_module->equal_addresses(address,
 				route->destination))
@@ -180,13 +184,71 @@ find_route(net_domain* _domain, const sockaddr* address)
 		TRACE("  found route: %s, flags %lx\n",
 			AddressString(domain, route->destination).Data(), route->flags);
 
+		if (_first != NULL)
+			*_first = candidate == NULL;
 		return route;
 	}
 
+	if (_first != NULL)
+		*_first = false;
 	return candidate;
 }
 
 
+static inline route_cache_entry&
+route_cache_entry_for(net_domain_private* domain, const sockaddr* address)
+{
+	uint32 hash = domain->address_module->hash_address(address, false);
+	return domain->route_cache[(hash ^ (hash >> 16)) % ROUTE_CACHE_SIZE];
+}
+
+
+/*!	Invalidates all entries of the route cache; must be called whenever the
+	route list changes.
+*/
+static inline void
+flush_route_cache(net_domain_private* domain)
+{
+	ASSERT_LOCKED_RECURSIVE(&domain->lock);
+
+	if (++domain->route_generation == 0) {
+		// skip the generation that marks unused entries
+		domain->route_generation = 1;
+		for (int32 i = 0; i < ROUTE_CACHE_SIZE; i++)
+			domain->route_cache[i].generation = 0;
+	}
+}
+
+
+/*!	Same as find_route(), but consults the domain's destination cache first.
+	Only results that don't depend on the link state of other routes are
+	cached; the link state of the cached route itself is checked on every hit.
+*/
+static net_route_private*
+lookup_route(net_domain_private* domain, const sockaddr* address)
+{
+	route_cache_entry& entry = route_cache_entry_for(domain, address);
+
+	if (entry.generation == domain->route_generation
+		&& domain->address_module->equal_addresses(
+			(sockaddr*)&entry.destination, address)
+		&& (entry.route->interface_address->interface->device->flags
+			& IFF_LINK) != 0) {
+		return entry.route;
+	}
+
+	bool first;
+	net_route_private* route = find_route(domain, address, &first);
+	if (route != NULL && first && address->sa_len <= sizeof(sockaddr_storage)) {
+		memcpy(&entry.destination, address, address->sa_len);
+		entry.route = route;
+		entry.generation = domain->route_generation;
+	}
+
+	return route;
+}
+
+
 static void
 put_route_internal(struct net_domain_private* domain, net_route* _route)
 {
@@ -230,7 +292,7 @@ get_route_internal(struct net_domain_private* domain,
 				break;
 		}
 	} else
-		route = find_route(domain, address);
+		route = lookup_route(domain, address);
 
 	if (route != NULL && atomic_add(&route->ref_count, 1) == 0) {
 		// route has been deleted already
@@ -287,6 +349,19 @@ fill_route_entry(route_entry* target, void* _buffer, size_t bufferSize,
 //	#pragma mark - exported functions
 
 
+/*!	Initializes the destination cache of a newly registered domain. */
+void
+init_route_cache(net_domain_private* domain)
+{
+	domain->route_generation = 1;
+
+	for (int32 i = 0; i < ROUTE_CACHE_SIZE; i++) {
+		domain->route_cache[i].route = NULL;
+		domain->route_cache[i].generation = 0;
+	}
+}
+
+
 /*!	Determines the size of a buffer large enough to contain the whole
 	routing table.
 */
@@ -511,6 +586,7 @@ add_route(struct net_domain* _domain, const struct net_route* newRoute)
 	}
 
 	domain->routes.Insert(before, route);
+	flush_route_cache(domain);
 	update_route_infos(domain);
 
 	return B_OK;
@@ -539,6 +615,7 @@ remove_route(struct net_domain* _domain, const struct net_route* removeRoute)
 		return B_ENTRY_NOT_FOUND;
 
 	domain->routes.Remove(route);
+	flush_route_cache(domain);
 
 	put_route_internal(domain, route);
 	update_route_infos(domain);
@@ -566,7 +643,7 @@ get_route_information(struct net_domain* _domain, void* value, size_t length)
 
 	RecursiveLocker locker(domain->lock);
 
-	net_route_private* route = find_route(domain, (sockaddr*)&destination);
+	net_route_private* route = lookup_route(domain, (sockaddr*)&destination);
 	if (route == NULL)
 		return B_ENTRY_NOT_FOUND;
 
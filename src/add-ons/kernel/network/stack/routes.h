@@ -27,10 +27,23 @@ struct net_route_private
 };
 
 typedef DoublyLinkedList<net_route_private> RouteList;
+
+
+#define ROUTE_CACHE_SIZE	64
+
+struct route_cache_entry {
+	sockaddr_storage	destination;
+	net_route_private*	route;
+	uint32				generation;
+		// the entry is only valid as long as this matches the domain's
+		// route generation
+};
+
 typedef DoublyLinkedList<net_route_info,
 	DoublyLinkedListCLink<net_route_info> > RouteInfoList;
 
 
+void init_route_cache(struct net_domain_private* domain);
 uint32 route_table_size(struct net_domain_private* domain);
 status_t list_routes(struct net_domain_private* domain, void* buffer,
 				size_t size);
@@ -119,6 +119,14 @@ stack_interface_recvmsg(net_socket* socket, struct msghdr* message, int flags)
 }
 
 
+static ssize_t
+stack_interface_recvmmsg(net_socket* socket, struct mmsghdr* messages,
+	uint32 count, int flags)
+{
+	return gNetSocketModule.receive_multiple(socket, messages, count, flags);
+}
+
+
 static ssize_t
 stack_interface_send(net_socket* socket, const void* data, size_t length,
 	int flags)
@@ -279,6 +287,7 @@ net_stack_interface_module_info gNetStackInterfaceModule = {
 	&stack_interface_recv,
 	&stack_interface_recvfrom,
 	&stack_interface_recvmsg,
+	&stack_interface_recvmmsg,
 
 	&stack_interface_send,
 	&stack_interface_sendto,
@@ -127,6 +127,28 @@ LinkReceiver::HasMessages() const
 }
 
 
+/*!	Returns whether the next message has already been read from the port
+	into the buffer, and if so, its \a code, without consuming it. This is
+	used to batch a sequence of messages that arrived together.
+*/
+bool
+LinkReceiver::PeekBufferedMessage(int32& code) const
+{
+	int32 start = fRecvStart + fReplySize;
+	int32 remaining = fDataSize - start;
+	if (remaining < (int32)sizeof(message_header))
+		return false;
+
+	message_header* header = (message_header*)(fRecvBuffer + start);
+	if (header->size > remaining
+		|| header->size < (int32)sizeof(message_header))
+		return false;
+
+	code = header->code;
+	return true;
+}
+
+
 bool
 LinkReceiver::NeedsReply() const
 {
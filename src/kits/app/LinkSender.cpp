@@ -29,8 +29,10 @@
 #endif
 
 static const size_t kMaxStringSize = 4096;
-static const size_t kWatermark = kInitialBufferSize - 24;
-	// if a message is started after this mark, the buffer is flushed automatically
+static const size_t kWatermarkMargin = 24;
+	// if a message is started after the batch size minus this margin, the
+	// buffer is flushed automatically
+static const size_t kMaxBatchSize = 16384;
 
 namespace BPrivate {
 
@@ -40,6 +42,7 @@ LinkSender::LinkSender(port_id port)
 	fTargetTeam(-1),
 	fBuffer(NULL),
 	fBufferSize(0),
+	fBatchSize(kInitialBufferSize),
 
 	fCurrentEnd(0),
 	fCurrentStart(0),
@@ -78,10 +81,20 @@ LinkSender::StartMessage(int32 code, size_t minSize)
 	// Eventually flush buffer to make space for the new message.
 	// Note, we do not take the actual buffer size into account to not
 	// delay the time between buffer flushes too much.
-	if (fBufferSize > 0 && (minSize > SpaceLeft() || fCurrentStart >= kWatermark)) {
+	bool batchFull = fCurrentStart >= fBatchSize - kWatermarkMargin;
+	if (fBufferSize > 0 && (minSize > SpaceLeft() || batchFull)) {
 		status_t status = Flush();
 		if (status < B_OK)
 			return status;
+
+		if (batchFull && fBatchSize < kMaxBatchSize) {
+			// We get messages faster than we are asked to flush them, so
+			// we put more of them into a single port message from now on.
+			fBatchSize *= 2;
+			if (fBatchSize > fBufferSize)
+				AdjustBuffer(fBatchSize);
+				// if this fails, we just keep the smaller buffer
+		}
 	}
 
 	if (minSize > fBufferSize) {
@@ -326,6 +339,12 @@ LinkSender::Flush(bigtime_t timeout, bool needsReply)
 	STRACE(("info: LinkSender Flush() messages total of %ld bytes on port %ld.\n",
 		fCurrentEnd, fPort));
 
+	if (fCurrentEnd < fBatchSize / 4 && fBatchSize > kInitialBufferSize) {
+		// We are asked to flush long before the batch would be full, so
+		// the burst that made us grow it is over.
+		fBatchSize /= 2;
+	}
+
 	fCurrentEnd = 0;
 	fCurrentStart = 0;
 
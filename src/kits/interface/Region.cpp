@@ -24,15 +24,17 @@ const static int32 kDataBlockSize = 8;
 
 /*! \brief Initializes a region. The region will have no rects,
 	and its fBounds will be invalid.
+
+	Like regions with a single rect, empty regions keep their data in
+	fBounds, and do not allocate any memory.
 */
 BRegion::BRegion()
 	:
 	fCount(0),
-	fDataSize(0),
+	fDataSize(1),
 	fBounds((clipping_rect){ 0, 0, 0, 0 }),
-	fData(NULL)
+	fData(&fBounds)
 {
-	_SetSize(kDataBlockSize);
 }
 
 
@@ -42,9 +44,9 @@ BRegion::BRegion()
 BRegion::BRegion(const BRegion& region)
 	:
 	fCount(0),
-	fDataSize(0),
+	fDataSize(1),
 	fBounds((clipping_rect){ 0, 0, 0, 0 }),
-	fData(NULL)
+	fData(&fBounds)
 {
 	*this = region;
 }
@@ -105,7 +107,7 @@ BRegion::operator=(const BRegion& region)
 
 	// handle reallocation if we're too small to contain
 	// the other region
-	if (_SetSize(region.fDataSize)) {
+	if (_SetSize(region.fCount)) {
 		memcpy(fData, region.fData, region.fCount * sizeof(clipping_rect));
 
 		fBounds = region.fBounds;
@@ -406,6 +408,18 @@ BRegion::Include(clipping_rect rect)
 	rect.right ++;
 	rect.bottom ++;
 
+	if (fCount == 0 || (rect.left <= fBounds.left && rect.top <= fBounds.top
+			&& rect.right >= fBounds.right && rect.bottom >= fBounds.bottom)) {
+		// the rect covers the whole region
+		_SetToInternal(rect);
+		return;
+	}
+	if (fCount == 1 && fBounds.left <= rect.left && fBounds.top <= rect.top
+		&& fBounds.right >= rect.right && fBounds.bottom >= rect.bottom) {
+		// the rect is already part of the region
+		return;
+	}
+
 	// use private clipping_rect constructor which avoids malloc()
 	BRegion t(rect);
 
@@ -422,6 +436,17 @@ BRegion::Include(clipping_rect rect)
 void
 BRegion::Include(const BRegion* region)
 {
+	if (region == this || region->fCount == 0)
+		return;
+	if (fCount == 0) {
+		*this = *region;
+		return;
+	}
+	if (region->fCount == 1) {
+		Include(region->FrameInt());
+		return;
+	}
+
 	BRegion result;
 	Support::XUnionRegion(this, region, &result);
 
@@ -455,6 +480,14 @@ BRegion::Exclude(clipping_rect rect)
 	rect.right ++;
 	rect.bottom ++;
 
+	if (fCount == 0 || !_Overlaps(fBounds, rect))
+		return;
+	if (rect.left <= fBounds.left && rect.top <= fBounds.top
+		&& rect.right >= fBounds.right && rect.bottom >= fBounds.bottom) {
+		MakeEmpty();
+		return;
+	}
+
 	// use private clipping_rect constructor which avoids malloc()
 	BRegion t(rect);
 
@@ -472,6 +505,18 @@ BRegion::Exclude(clipping_rect rect)
 void
 BRegion::Exclude(const BRegion* region)
 {
+	if (region == this) {
+		MakeEmpty();
+		return;
+	}
+	if (fCount == 0 || region->fCount == 0
+		|| !_Overlaps(fBounds, region->fBounds))
+		return;
+	if (region->fCount == 1) {
+		Exclude(region->FrameInt());
+		return;
+	}
+
 	BRegion result;
 	Support::XSubtractRegion(this, region, &result);
 
@@ -489,6 +534,38 @@ BRegion::Exclude(const BRegion* region)
 void
 BRegion::IntersectWith(const BRegion* region)
 {
+	if (region == this || fCount == 0)
+		return;
+	if (region->fCount == 0 || !_Overlaps(fBounds, region->fBounds)) {
+		MakeEmpty();
+		return;
+	}
+
+	const clipping_rect& other = region->fBounds;
+	if (region->fCount == 1 && other.left <= fBounds.left
+		&& other.top <= fBounds.top && other.right >= fBounds.right
+		&& other.bottom >= fBounds.bottom) {
+		// the region is completely inside the other rect
+		return;
+	}
+	if (fCount == 1) {
+		if (fBounds.left <= other.left && fBounds.top <= other.top
+			&& fBounds.right >= other.right
+			&& fBounds.bottom >= other.bottom) {
+			// the other region is completely inside our rect
+			*this = *region;
+			return;
+		}
+		if (region->fCount == 1) {
+			_SetToInternal((clipping_rect){
+				max_c(fBounds.left, other.left),
+				max_c(fBounds.top, other.top),
+				min_c(fBounds.right, other.right),
+				min_c(fBounds.bottom, other.bottom) });
+			return;
+		}
+	}
+
 	BRegion result;
 	Support::XIntersectRegion(this, region, &result);
 
@@ -516,6 +593,33 @@ BRegion::ExclusiveInclude(const BRegion* region)
 // #pragma mark -
 
 
+/*!	\brief Sets the region to the given rect, which is already in internal
+		rect format and valid. Keeps any allocated memory for later use.
+*/
+void
+BRegion::_SetToInternal(const clipping_rect& rect)
+{
+	if (fData == NULL) {
+		// a previous allocation failed
+		fData = &fBounds;
+		fDataSize = 1;
+	}
+	fData[0] = rect;
+	fBounds = rect;
+	fCount = 1;
+}
+
+
+/*!	\brief Returns whether the two rects in internal rect format overlap.
+*/
+/*static*/ bool
+BRegion::_Overlaps(const clipping_rect& a, const clipping_rect& b)
+{
+	return a.right > b.left && a.left < b.right && a.bottom > b.top
+		&& a.top < b.bottom;
+}
+
+
 /*!	\brief Takes over the data of a region and marks that region empty.
 	\param region The region to adopt the data from.
 */
@@ -558,7 +662,8 @@ BRegion::_SetSize(long newSize)
 	if (newSize > 0) {
 		if (fData == &fBounds) {
 			fData = (clipping_rect*)malloc(newSize * sizeof(clipping_rect));
-			fData[0] = fBounds;
+			if (fData != NULL)
+				fData[0] = fBounds;
 		} else if (fData) {
 			clipping_rect* resizedData = (clipping_rect*)realloc(fData,
 				newSize * sizeof(clipping_rect));
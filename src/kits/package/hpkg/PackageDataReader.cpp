@@ -14,6 +14,7 @@
 #include <package/hpkg/HPKGDefsPrivate.h>
 #include <package/hpkg/BufferCache.h>
 #include <package/hpkg/CachedBuffer.h>
+#include <package/hpkg/ChunkCache.h>
 #include <package/hpkg/DataOutput.h>
 #include <package/hpkg/PackageData.h>
 #include <package/hpkg/ZlibDecompressor.h>
@@ -157,10 +158,13 @@ private:
 
 class ZlibPackageDataReader : public BPackageDataReader {
 public:
-	ZlibPackageDataReader(BDataReader* dataReader, BBufferCache* bufferCache)
+	ZlibPackageDataReader(BDataReader* dataReader, BBufferCache* bufferCache,
+		ChunkCache* chunkCache, uint64 chunkCacheID)
 		:
 		BPackageDataReader(dataReader),
 		fBufferCache(bufferCache),
+		fChunkCache(chunkCache),
+		fChunkCacheID(chunkCacheID),
 		fUncompressBuffer(NULL),
 		fOffsetTable(NULL)
 	{
@@ -295,8 +299,18 @@ private:
 		uint32 uncompressedSize = (uint64)chunkIndex + 1 < fChunkCount
 			? fChunkSize : fUncompressedSize - chunkIndex * fChunkSize;
 
+		// Compressed chunks might have been uncompressed before, by us or by
+		// the reader of another file.
+		bool compressed = compressedSize != uncompressedSize;
+		if (compressed && fChunkCache != NULL
+			&& fChunkCache->LookupChunk(fChunkCacheID, offset,
+				fUncompressBuffer->Buffer(), uncompressedSize)) {
+			fUncompressedChunk = chunkIndex;
+			return B_OK;
+		}
+
 		// read the chunk
-		if (compressedSize == uncompressedSize) {
+		if (!compressed) {
 			// the chunk is not compressed -- read it directly into the
 			// uncompressed buffer
 			error = fDataReader->ReadData(offset, fUncompressBuffer->Buffer(),
@@ -328,6 +342,11 @@ private:
 			return error;
 		}
 
+		if (compressed && fChunkCache != NULL) {
+			fChunkCache->AddChunk(fChunkCacheID, offset,
+				fUncompressBuffer->Buffer(), uncompressedSize);
+		}
+
 		fUncompressedChunk = chunkIndex;
 		return B_OK;
 	}
@@ -401,6 +420,8 @@ private:
 
 private:
 	BBufferCache*	fBufferCache;
+	ChunkCache*		fChunkCache;
+	uint64			fChunkCacheID;
 	CachedBuffer*	fUncompressBuffer;
 	int64			fUncompressedChunk;
 
@@ -429,6 +450,15 @@ BPackageDataReaderFactory::BPackageDataReaderFactory(BBufferCache* bufferCache)
 status_t
 BPackageDataReaderFactory::CreatePackageDataReader(BDataReader* dataReader,
 	const BPackageData& data, BPackageDataReader*& _reader)
+{
+	return CreatePackageDataReader(dataReader, data, NULL, 0, _reader);
+}
+
+
+status_t
+BPackageDataReaderFactory::CreatePackageDataReader(BDataReader* dataReader,
+	const BPackageData& data, ChunkCache* chunkCache, uint64 chunkCacheID,
+	BPackageDataReader*& _reader)
 {
 	BPackageDataReader* reader;
 
@@ -439,7 +469,7 @@ BPackageDataReaderFactory::CreatePackageDataReader(BDataReader* dataReader,
 			break;
 		case B_HPKG_COMPRESSION_ZLIB:
 			reader = new(std::nothrow) ZlibPackageDataReader(dataReader,
-				fBufferCache);
+				fBufferCache, chunkCache, chunkCacheID);
 			break;
 		default:
 			return B_BAD_VALUE;
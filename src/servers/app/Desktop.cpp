@@ -607,6 +607,35 @@ Desktop::KeyEvent(uint32 what, int32 key, int32 modifiers)
 }
 
 
+// #pragma mark - Locking
+
+
+#if MULTI_LOCKER_DEBUG
+//! Makes sure the screen lock is never held when acquiring the window lock.
+#	define ASSERT_WINDOW_LOCK_ORDER() \
+		assert(fWindowLock.IsWriteLocked() || fWindowLock.IsReadLocked() \
+			|| (!fScreenLock.IsWriteLocked() && !fScreenLock.IsReadLocked()))
+#else
+#	define ASSERT_WINDOW_LOCK_ORDER() ;
+#endif
+
+
+bool
+Desktop::LockSingleWindow()
+{
+	ASSERT_WINDOW_LOCK_ORDER();
+	return fWindowLock.ReadLock();
+}
+
+
+bool
+Desktop::LockAllWindows()
+{
+	ASSERT_WINDOW_LOCK_ORDER();
+	return fWindowLock.WriteLock();
+}
+
+
 // #pragma mark - Mouse and cursor methods
 
 
@@ -1392,7 +1421,7 @@ Desktop::MoveWindowBy(Window* window, float x, float y, int32 workspace)
 	window->MoveBy((int32)x, (int32)y);
 
 	BRegion background;
-	_RebuildClippingForAllWindows(background);
+	_RebuildClippingAfterWindowChange(window, newDirtyRegion, background);
 
 	// construct the region that is possible to be blitted
 	// to move the contents of the window
@@ -1468,7 +1497,8 @@ Desktop::ResizeWindowBy(Window* window, float x, float y)
 	window->ResizeBy((int32)x, (int32)y, &newDirtyRegion);
 
 	BRegion background;
-	_RebuildClippingForAllWindows(background);
+	_RebuildClippingAfterWindowChange(window, previouslyOccupiedRegion,
+		background);
 
 	// we just care for the region outside the window
 	previouslyOccupiedRegion.Exclude(&window->VisibleRegion());
@@ -3164,6 +3194,133 @@ Desktop::_RebuildClippingForAllWindows(BRegion& stillAvailableOnScreen)
 }
 
 
+/*!	Like _RebuildClippingForAllWindows(), but only for the case that just
+	\a changedWindow has been moved or resized, and nothing else changed.
+	The windows in front of it keep their clipping, and of those behind it,
+	only the ones that overlap its previous or new visible region get their
+	clipping updated. The clipping of the other windows, and of their views,
+	stays valid.
+*/
+void
+Desktop::_RebuildClippingAfterWindowChange(Window* changedWindow,
+	const BRegion& previousVisibleRegion, BRegion& stillAvailableOnScreen)
+{
+	stillAvailableOnScreen = fScreenRegion;
+
+	// the area in which the clipping of the windows behind changedWindow
+	// may have changed
+	BRegion changedRegion(previousVisibleRegion);
+	bool behindChangedWindow = false;
+
+	WindowStack* stack = changedWindow->GetWindowStack();
+
+	for (Window* window = CurrentWindows().LastWindow(); window != NULL;
+			window = window->PreviousWindow(fCurrentWorkspace)) {
+		if (window->IsHidden())
+			continue;
+
+		// the other windows in the stack are moved along
+		bool moved = window == changedWindow
+			|| (stack != NULL && window->GetWindowStack() == stack);
+		bool changed = moved;
+		if (!changed && behindChangedWindow) {
+			BRect frame = window->Frame();
+			::Decorator* decorator = window->Decorator();
+			if (decorator != NULL)
+				frame = frame | decorator->GetFootprint().Frame();
+
+			changed = changedRegion.Intersects(frame);
+		}
+
+		if (moved) {
+			// the windows behind it may have been covered by its tabs, too;
+			// its visible region is only updated in SetClipping()
+			changedRegion.Include(&window->VisibleRegion());
+		}
+
+		if (changed) {
+			window->SetClipping(&stillAvailableOnScreen);
+			window->SetScreen(_DetermineScreenFor(window->Frame()));
+
+			if (window->ServerWindow()->IsDirectlyAccessing()) {
+				window->ServerWindow()->HandleDirectConnection(
+					B_DIRECT_MODIFY | B_CLIPPING_MODIFIED);
+			}
+		}
+
+		if (moved) {
+			changedRegion.Include(&window->VisibleRegion());
+			behindChangedWindow = true;
+		}
+
+		// that windows region is not available on screen anymore
+		stillAvailableOnScreen.Exclude(&window->VisibleRegion());
+	}
+
+#if DEBUG
+	_CheckClipping(stillAvailableOnScreen);
+#endif
+}
+
+
+#if DEBUG
+static bool
+equal_regions(const BRegion& a, const BRegion& b)
+{
+	BRegion difference(a);
+	difference.Exclude(&b);
+	if (difference.CountRects() > 0)
+		return false;
+
+	difference = b;
+	difference.Exclude(&a);
+	return difference.CountRects() == 0;
+}
+
+
+/*!	Makes sure that _RebuildClippingAfterWindowChange() left the windows
+	with the same clipping that _RebuildClippingForAllWindows() gives them.
+*/
+void
+Desktop::_CheckClipping(const BRegion& stillAvailableOnScreen)
+{
+	int32 count = 0;
+	for (Window* window = CurrentWindows().LastWindow(); window != NULL;
+			window = window->PreviousWindow(fCurrentWorkspace)) {
+		count++;
+	}
+
+	BRegion* visibleRegions = new (std::nothrow) BRegion[count];
+	if (visibleRegions == NULL)
+		return;
+
+	int32 index = 0;
+	for (Window* window = CurrentWindows().LastWindow(); window != NULL;
+			window = window->PreviousWindow(fCurrentWorkspace)) {
+		visibleRegions[index++] = window->VisibleRegion();
+	}
+
+	BRegion available;
+	_RebuildClippingForAllWindows(available);
+
+	index = 0;
+	for (Window* window = CurrentWindows().LastWindow(); window != NULL;
+			window = window->PreviousWindow(fCurrentWorkspace)) {
+		if (!equal_regions(visibleRegions[index++], window->VisibleRegion())) {
+			debug_printf("Desktop: wrong clipping of window \"%s\" after "
+				"a window change\n", window->Title());
+			debugger("Desktop: incremental clipping differs from a rebuild");
+		}
+	}
+
+	if (!equal_regions(available, stillAvailableOnScreen))
+		debugger("Desktop: wrong background region after a window change");
+
+	delete[] visibleRegions;
+}
+#endif	// DEBUG
+
+
 void
 Desktop::_TriggerWindowRedrawing(BRegion& newDirtyRegion)
 {
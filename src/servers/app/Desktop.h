@@ -53,6 +53,18 @@ namespace BPrivate {
 };
 
 
+/*	Lock order
+
+	The locks of the desktop must always be acquired in this order:
+	1. the ServerWindow (MessageLooper) lock of a window
+	2. the window lock, either for a single window (read), or for all
+	   windows (write); a read lock can never be turned into a write lock
+	3. the screen lock
+	4. the locks of the HWInterface, ie. the DrawingEngine
+	Debug builds of the MultiLocker check the rules for the window lock.
+*/
+
+
 class Desktop : public DesktopObservable, public MessageLooper,
 	public ScreenOwner {
 public:
@@ -77,13 +89,11 @@ public:
 			filter_result		KeyEvent(uint32 what, int32 key,
 									int32 modifiers);
 	// Locking
-			bool				LockSingleWindow()
-									{ return fWindowLock.ReadLock(); }
+			bool				LockSingleWindow();
 			void				UnlockSingleWindow()
 									{ fWindowLock.ReadUnlock(); }
 
-			bool				LockAllWindows()
-									{ return fWindowLock.WriteLock(); }
+			bool				LockAllWindows();
 			void				UnlockAllWindows()
 									{ fWindowLock.WriteUnlock(); }
 
@@ -287,6 +297,14 @@ private:
 			Screen*				_DetermineScreenFor(BRect frame);
 			void				_RebuildClippingForAllWindows(
 									BRegion& stillAvailableOnScreen);
+			void				_RebuildClippingAfterWindowChange(
+									Window* changedWindow,
+									const BRegion& previousVisibleRegion,
+									BRegion& stillAvailableOnScreen);
+#if DEBUG
+			void				_CheckClipping(
+									const BRegion& stillAvailableOnScreen);
+#endif
 			void				_TriggerWindowRedrawing(
 									BRegion& newDirtyRegion);
 			void				_SetBackground(BRegion& background);
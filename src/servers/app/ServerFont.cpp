@@ -822,11 +822,32 @@ ServerFont::StringWidth(const char *string, int32 numBytes,
 
 	bool kerning = true; // TODO make this a property?
 
+	// Widths without escapement delta are remembered by the cache entry,
+	// since the same strings tend to be measured over and over again
+	FontCacheReference cacheReference;
+	if (deltaArray == NULL) {
+		FontCacheEntry* entry = GlyphLayoutEngine::FontCacheEntryFor(*this,
+			NULL, string, numBytes, cacheReference, false);
+		float width;
+		if (entry != NULL
+			&& entry->CachedStringWidth(string, numBytes, fSpacing, &width))
+			return width;
+
+		// LayoutGlyphs() needs to lock the entry itself
+		cacheReference.Unset();
+		cacheReference.SetTo(NULL, false);
+	}
+
 	StringWidthConsumer consumer;
 	if (!GlyphLayoutEngine::LayoutGlyphs(consumer, *this, string, numBytes,
-			deltaArray, kerning, fSpacing))
+			deltaArray, kerning, fSpacing, NULL, &cacheReference))
 		return 0.0;
 
+	if (deltaArray == NULL && cacheReference.Entry() != NULL) {
+		cacheReference.Entry()->CacheStringWidth(string, numBytes, fSpacing,
+			consumer.width);
+	}
+
 	return consumer.width;
 }
 
@@ -123,6 +123,10 @@ static profile sRedrawProcessingTime;
 //static profile sNextMessageTime;
 #endif
 
+// The maximum number of consecutive AS_FILL_RECT messages that are drawn
+// together, see _DispatchViewDrawingMessage().
+static const int32 kMaxFillRectBatch = 64;
+
 
 //	#pragma mark -
 
@@ -2249,7 +2253,30 @@ ServerWindow::_DispatchViewDrawingMessage(int32 code,
 				rect.bottom));
 
 			fCurrentView->ConvertToScreenForDrawing(&rect);
-			drawingEngine->FillRect(rect);
+
+			// Applications that fill many small rects in a row (charts,
+			// lists, terminals) send them in a single link buffer. Since no
+			// state can change in between, we collect all of them that are
+			// already buffered, and let the drawing engine fill them at once.
+			BRect rects[kMaxFillRectBatch];
+			rects[0] = rect;
+			int32 count = 1;
+			int32 nextCode;
+			while (count < kMaxFillRectBatch
+				&& link.PeekBufferedMessage(nextCode)
+				&& nextCode == AS_FILL_RECT) {
+				if (link.GetNextMessage(nextCode) != B_OK
+					|| link.Read<BRect>(&rect) != B_OK)
+					break;
+
+				fCurrentView->ConvertToScreenForDrawing(&rect);
+				rects[count++] = rect;
+			}
+
+			if (count == 1)
+				drawingEngine->FillRect(rects[0]);
+			else
+				drawingEngine->FillRects(rects, count);
 			break;
 		}
 		case AS_FILL_RECT_GRADIENT:
@@ -3439,21 +3466,8 @@ ServerWindow::_MessageLooper()
 				}
 			}
 
-			if (atomic_and(&fRedrawRequested, 0) != 0) {
-#ifdef PROFILE_MESSAGE_LOOP
-				bigtime_t redrawStart = system_time();
-#endif
-				fWindow->RedrawDirtyRegion();
-#ifdef PROFILE_MESSAGE_LOOP
-				diff = system_time() - redrawStart;
-				atomic_add(&sRedrawProcessingTime.count, 1);
-# ifndef HAIKU_TARGET_PLATFORM_LIBBE_TEST
-				atomic_add64(&sRedrawProcessingTime.time, diff);
-# else
-				sRedrawProcessingTime.time += diff;
-# endif
-#endif
-			}
+			if (!needsAllWindowsLocked)
+				_RedrawIfRequested();
 
 #ifdef PROFILE_MESSAGE_LOOP
 			bigtime_t dispatchStart = system_time();
@@ -3476,9 +3490,18 @@ ServerWindow::_MessageLooper()
 			}
 #endif
 
-			if (needsAllWindowsLocked)
+			if (needsAllWindowsLocked) {
 				fDesktop->UnlockAllWindows();
 
+				// Redraw only after having given up the all-window lock, so
+				// that the other windows don't have to wait for us.
+				if (fRedrawRequested != 0) {
+					fDesktop->LockSingleWindow();
+					lockedDesktopSingleWindow = true;
+					_RedrawIfRequested();
+				}
+			}
+
 			// Only process up to 70 waiting messages at once (we have the
 			// Desktop locked), but don't hold the lock longer than 10 ms
 			if (!receiver.HasMessages() || ++messagesProcessed > 70
@@ -3512,6 +3535,31 @@ ServerWindow::_MessageLooper()
 }
 
 
+/*!	Redraws the dirty region of the window if that has been requested.
+	The caller must only hold the single window lock of the desktop.
+*/
+void
+ServerWindow::_RedrawIfRequested()
+{
+	if (atomic_and(&fRedrawRequested, 0) == 0)
+		return;
+
+#ifdef PROFILE_MESSAGE_LOOP
+	bigtime_t redrawStart = system_time();
+#endif
+	fWindow->RedrawDirtyRegion();
+#ifdef PROFILE_MESSAGE_LOOP
+	bigtime_t diff = system_time() - redrawStart;
+	atomic_add(&sRedrawProcessingTime.count, 1);
+# ifndef HAIKU_TARGET_PLATFORM_LIBBE_TEST
+	atomic_add64(&sRedrawProcessingTime.time, diff);
+# else
+	sRedrawProcessingTime.time += diff;
+# endif
+#endif
+}
+
+
 void
 ServerWindow::ScreenChanged(const BMessage* message)
 {
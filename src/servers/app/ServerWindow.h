@@ -133,6 +133,7 @@ private:
 			bool				_DispatchPictureMessage(int32 code,
 									BPrivate::LinkReceiver &link);
 			void				_MessageLooper();
+			void				_RedrawIfRequested();
 	virtual void				_PrepareQuit();
 	virtual void				_GetLooperName(char* name, size_t size);
 
@@ -1927,6 +1927,13 @@ Window::BeginUpdate(BPrivate::PortLink& link)
 	// supress back to front buffer copies in the drawing engine
 	fDrawingEngine->SetCopyToFrontEnabled(false);
 
+	if (!fCurrentUpdateSession->IsExpose()) {
+		// make sure that pending copies don't show the update half done;
+		// for an expose session, the background has already been drawn,
+		// and must still show if the client never ends the update
+		fDrawingEngine->CancelCopyToFront(*dirty);
+	}
+
 	if (!fCurrentUpdateSession->IsExpose()
 		&& fDrawingEngine->LockParallelAccess()) {
 		fDrawingEngine->SuspendAutoSync();
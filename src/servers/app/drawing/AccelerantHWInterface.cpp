@@ -688,11 +688,11 @@ AccelerantHWInterface::SetMode(const display_mode& mode)
 			// clear out backbuffer, alpha is 255 this way
 			memset(fBackBuffer->Bits(), 255, fBackBuffer->BitsLength());
 		}
-#if 0
-// NOTE: Currently disabled, because it make the double buffered mode flicker
-// again. See HWInterface::Invalidate() for more information.
-		SetAsyncDoubleBuffered(doubleBuffered);
-#endif
+		// NOTE: The update queue is never removed again here, since we hold
+		// the write lock its thread might be waiting for. It is simply not
+		// used while we are single buffered.
+		if (doubleBuffered)
+			SetAsyncDoubleBuffered(true);
 	}
 
 	// update color palette configuration if necessary
@@ -218,6 +218,17 @@ DrawingEngine::CopyToFront(/*const*/ BRegion& region)
 }
 
 
+/*!	Makes sure that \a region is not transferred to the front buffer before
+	the next CopyToFront() call covering it, even if it had been drawn to
+	before.
+*/
+void
+DrawingEngine::CancelCopyToFront(const BRegion& region)
+{
+	fGraphicsCard->CancelInvalidation(region);
+}
+
+
 // #pragma mark -
 
 
@@ -1021,9 +1032,20 @@ DrawingEngine::FillRegion(BRegion& r)
 {
 	ASSERT_PARALLEL_LOCKED();
 
+	if (_FillRegion(r))
+		_CopyToFront(r.Frame());
+}
+
+
+/*!	Fills \a r, but leaves copying it to the front buffer to the caller.
+	Returns \c false if nothing was drawn.
+*/
+bool
+DrawingEngine::_FillRegion(BRegion& r)
+{
 	BRect clipped = fPainter->ClipRect(r.Frame());
 	if (!clipped.IsValid())
-		return;
+		return false;
 
 	AutoFloatingOverlaysHider overlaysHider(fGraphicsCard, clipped);
 
@@ -1062,7 +1084,41 @@ DrawingEngine::FillRegion(BRegion& r)
 			touched = touched | fPainter->FillRect(r.RectAt(i));
 	}
 
-	_CopyToFront(r.Frame());
+	return true;
+}
+
+
+/*!	Fills all \a rects with the current pattern and colors, with the same
+	result as calling FillRect() for each of them.
+	In the B_OP_COPY and B_OP_OVER modes filling a pixel twice does not change
+	it any further, so the rects are merged into a single region first; the
+	region is then filled at once, and its rects are copied to the front
+	buffer together.
+*/
+void
+DrawingEngine::FillRects(const BRect* rects, int32 count)
+{
+	ASSERT_PARALLEL_LOCKED();
+
+	if (count == 1 || (fPainter->DrawingMode() != B_OP_COPY
+			&& fPainter->DrawingMode() != B_OP_OVER)) {
+		for (int32 i = 0; i < count; i++)
+			FillRect(rects[i]);
+		return;
+	}
+
+	BRegion region;
+	for (int32 i = 0; i < count; i++) {
+		BRect rect = rects[i];
+		make_rect_valid(rect);
+		rect = fPainter->AlignAndClipRect(rect);
+		if (rect.IsValid())
+			region.Include(rect);
+	}
+
+	// only copy the rects themselves, their frame may cover much more
+	if (region.CountRects() > 0 && _FillRegion(region) && fCopyToFront)
+		fGraphicsCard->InvalidateRegion(region);
 }
 
 
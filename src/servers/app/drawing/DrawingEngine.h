@@ -47,6 +47,7 @@ public:
 			bool			CopyToFrontEnabled() const
 								{ return fCopyToFront; }
 	virtual	void			CopyToFront(/*const*/ BRegion& region);
+			void			CancelCopyToFront(const BRegion& region);
 
 	// locking
 			bool			LockParallelAccess();
@@ -129,6 +130,7 @@ public:
 	virtual	void			FillRegion(BRegion& region);
 	virtual	void			FillRegion(BRegion& region,
 								const BGradient& gradient);
+	virtual	void			FillRects(const BRect* rects, int32 count);
 
 	virtual	void			DrawRoundRect(BRect rect, float xrad,
 								float yrad, bool filled);
@@ -191,6 +193,7 @@ private:
 								uint32 height, uint32 bytesPerRow,
 								int32 xOffset, int32 yOffset) const;
 
+			bool			_FillRegion(BRegion& region);
 	inline	void			_CopyToFront(const BRect& frame);
 
 			Painter*		fPainter;
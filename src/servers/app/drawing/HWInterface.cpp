@@ -147,10 +147,10 @@ HWInterface::SetCursor(ServerCursor* cursor)
 		if (fCursor)
 			fCursor->AcquireReference();
 
-		Invalidate(oldFrame);
+		_InvalidateCursor(oldFrame);
 
 		_AdoptDragBitmap(fDragBitmap, fDragBitmapOffset);
-		Invalidate(_CursorFrame());
+		_InvalidateCursor(_CursorFrame());
 	}
 	fFloatingOverlaysLock.Unlock();
 }
@@ -196,13 +196,13 @@ HWInterface::SetCursorVisible(bool visible)
 			IntRect r = _CursorFrame();
 
 			_DrawCursor(r);
-			Invalidate(r);
+			_InvalidateCursor(r);
 		} else {
 			IntRect r = _CursorFrame();
 			fCursorVisible = visible;
 
 			_RestoreCursorArea();
-			Invalidate(r);
+			_InvalidateCursor(r);
 		}
 	}
 	fFloatingOverlaysLock.Unlock();
@@ -261,10 +261,10 @@ HWInterface::MoveCursorTo(float x, float y)
 			}
 			IntRect newFrame = _CursorFrame();
 			if (newFrame.Intersects(oldFrame))
-				Invalidate(oldFrame | newFrame);
+				_InvalidateCursor(oldFrame | newFrame);
 			else {
-				Invalidate(oldFrame);
-				Invalidate(newFrame);
+				_InvalidateCursor(oldFrame);
+				_InvalidateCursor(newFrame);
 			}
 		}
 	}
@@ -354,26 +354,49 @@ status_t
 HWInterface::Invalidate(const BRect& frame)
 {
 	if (IsDoubleBuffered()) {
-#if 0
-// NOTE: The UpdateQueue works perfectly fine, but it screws the
-// flicker-free-ness of the double buffered rendering. The problem being the
-// asynchronous nature. The UpdateQueue will transfer regions of the screen
-// which have been clean at the time we are in this function, but which have
-// been damaged meanwhile by drawing into them again. All in all, the
-// UpdateQueue is good for reducing the number of times that the transfer
-// is performed, and makes it happen during refresh only, but until there
-// is a smarter way to synchronize this all better, I've disabled it.
+		// NOTE: The UpdateQueue collects the damaged areas, and transfers
+		// them once per refresh, with exclusive access, so that no drawing
+		// operation is caught halfway. Areas that are redrawn in several
+		// steps (update sessions) are taken out of the queue with
+		// CancelInvalidation() until they are complete.
 		if (fUpdateExecutor != NULL) {
 			fUpdateExecutor->AddRect(frame);
 			return B_OK;
 		}
-#endif
 		return CopyBackToFront(frame);
 	}
 	return B_OK;
 }
 
 
+/*!	Like Invalidate(), but in double buffered mode, the area is transferred
+	right away instead of by the UpdateQueue. The software cursor has no
+	area backup there, so it would otherwise wait for the queue's thread to
+	get exclusive access, and freeze while a long drawing operation is in
+	progress.
+*/
+status_t
+HWInterface::_InvalidateCursor(const BRect& frame)
+{
+	if (IsDoubleBuffered() && fUpdateExecutor != NULL)
+		return CopyBackToFront(frame);
+
+	return Invalidate(frame);
+}
+
+
+/*!	Removes \a region from the areas that are waiting to be transferred to
+	the front buffer, because it is about to be redrawn in several steps.
+	The caller needs to invalidate it again when it is done.
+*/
+void
+HWInterface::CancelInvalidation(const BRegion& region)
+{
+	if (fUpdateExecutor != NULL)
+		fUpdateExecutor->RemoveRegion(region);
+}
+
+
 /*! The object must already be locked!
 */
 status_t
@@ -1054,7 +1077,7 @@ HWInterface::_AdoptDragBitmap(const ServerBitmap* bitmap, const BPoint& offset)
 		fCursorAndDragBitmap = fCursor;
 	}
 
-	Invalidate(cursorFrame);
+	_InvalidateCursor(cursorFrame);
 
 // NOTE: the EventDispatcher does the reference counting stuff for us
 // TODO: You can not simply call Release() on a ServerBitmap like you
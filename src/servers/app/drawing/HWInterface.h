@@ -160,6 +160,7 @@ public:
 	// Invalidate is used for scheduling an area for updating
 	virtual	status_t			InvalidateRegion(BRegion& region);
 	virtual	status_t			Invalidate(const BRect& frame);
+			void				CancelInvalidation(const BRegion& region);
 	// while as CopyBackToFront() actually performs the operation
 	// either directly or asynchronously by the UpdateQueue thread
 	virtual	status_t			CopyBackToFront(const BRect& frame);
@@ -200,6 +201,7 @@ protected:
 
 			IntRect				_CursorFrame() const;
 			void				_RestoreCursorArea() const;
+			status_t			_InvalidateCursor(const BRect& frame);
 			void				_AdoptDragBitmap(const ServerBitmap* bitmap,
 									const BPoint& offset);
 
@@ -0,0 +1,49 @@
+/*
+ * Copyright 2013, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef ALPHA_BLENDING_H
+#define ALPHA_BLENDING_H
+
+
+#include <string.h>
+
+#include <SupportDefs.h>
+
+
+extern "C" {
+	// in painter_alpha_blend.nasm, numPixels must be a multiple of four
+	void blend_row_alpha_sse2(uint8* dst, const uint8* src, int32 numPixels);
+}
+
+
+/*!	Blends a row of B_RGBA32 pixels with per pixel alpha onto \a dst.
+	Opaque source pixels are copied unchanged, the others keep the alpha of
+	the destination. blend_row_alpha_sse2() must produce the exact same
+	result.
+*/
+static inline void
+blend_row_alpha(uint8* dst, const uint8* src, int32 numPixels)
+{
+	uint32* d = (uint32*)dst;
+	int32 bytes = numPixels * 4;
+	uint8 buffer[bytes];
+	uint8* b = buffer;
+	while (numPixels--) {
+		if (src[3] == 255) {
+			*(uint32*)b = *(uint32*)src;
+		} else {
+			*(uint32*)b = *d;
+			b[0] = ((src[0] - b[0]) * src[3] + (b[0] << 8)) >> 8;
+			b[1] = ((src[1] - b[1]) * src[3] + (b[1] << 8)) >> 8;
+			b[2] = ((src[2] - b[2]) * src[3] + (b[2] << 8)) >> 8;
+		}
+		d++;
+		b += 4;
+		src += 4;
+	}
+	memcpy(dst, buffer, bytes);
+}
+
+
+#endif	// ALPHA_BLENDING_H
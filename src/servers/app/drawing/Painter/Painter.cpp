@@ -51,10 +51,12 @@
 #include <AutoDeleter.h>
 #include <View.h>
 
+#include "AlphaBlending.h"
 #include "DrawingMode.h"
 #include "GlobalSubpixelSettings.h"
 #include "PatternHandler.h"
 #include "RenderingBuffer.h"
+#include "RenderWorkers.h"
 #include "ServerBitmap.h"
 #include "ServerFont.h"
 #include "SystemPalette.h"
@@ -86,6 +88,7 @@ using std::nothrow;
 // Defines for SIMD support.
 #define APPSERVER_SIMD_MMX	(1 << 0)
 #define APPSERVER_SIMD_SSE	(1 << 1)
+#define APPSERVER_SIMD_SSE2	(1 << 2)
 
 // Prototypes for assembler routines
 extern "C" {
@@ -149,6 +152,8 @@ detect_simd()
 				cpuSIMD |= APPSERVER_SIMD_MMX;
 			if (edx & (1 << 25))
 				cpuSIMD |= APPSERVER_SIMD_SSE;
+			if (edx & (1 << 26))
+				cpuSIMD |= APPSERVER_SIMD_SSE2;
 		} else {
 			// no flags can be identified
 			cpuSIMD = 0;
@@ -1857,24 +1862,21 @@ static inline void
 copy_bitmap_row_bgr32_alpha(uint8* dst, const uint8* src, int32 numPixels,
 	const rgb_color* colorMap)
 {
-	uint32* d = (uint32*)dst;
-	int32 bytes = numPixels * 4;
-	uint8 buffer[bytes];
-	uint8* b = buffer;
-	while (numPixels--) {
-		if (src[3] == 255) {
-			*(uint32*)b = *(uint32*)src;
-		} else {
-			*(uint32*)b = *d;
-			b[0] = ((src[0] - b[0]) * src[3] + (b[0] << 8)) >> 8;
-			b[1] = ((src[1] - b[1]) * src[3] + (b[1] << 8)) >> 8;
-			b[2] = ((src[2] - b[2]) * src[3] + (b[2] << 8)) >> 8;
-		}
-		d++;
-		b += 4;
-		src += 4;
+#ifdef __INTEL__
+	if ((sSIMDFlags & APPSERVER_SIMD_SSE2) != 0 && numPixels >= 4) {
+		// blend four pixels at a time, and the rest below
+		int32 simdPixels = numPixels & ~3;
+		blend_row_alpha_sse2(dst, src, simdPixels);
+		numPixels -= simdPixels;
+		if (numPixels == 0)
+			return;
+
+		dst += simdPixels * 4;
+		src += simdPixels * 4;
 	}
-	memcpy(dst, buffer, bytes);
+#endif
+
+	blend_row_alpha(dst, src, numPixels);
 }
 
 
@@ -2272,6 +2274,329 @@ Painter::_DrawBitmapNearestNeighborCopy32(agg::rendering_buffer& srcBuffer,
 }
 
 
+namespace {
+
+struct FilterInfo {
+	uint16 index;	// index into source bitmap row/column
+	uint16 weight;	// weight of the pixel at index [0..255]
+};
+
+enum {
+	kOptimizeForLowFilterRatio = 0,
+	kUseDefaultVersion,
+	kUseSIMDVersion
+};
+
+// Clipping rectangles at least this large are scaled by the render workers.
+static const int32 kMinParallelScalePixels = 256 * 256;
+
+
+/*!	Scales the part of a bitmap that falls into one clipping rectangle.
+	The rows are independent of each other, so they can be scaled in bands
+	by the render workers.
+*/
+class BilinearScaleJob : public RenderWorkers::Job {
+public:
+	BilinearScaleJob(agg::rendering_buffer& srcBuffer, FilterInfo* xWeights,
+			FilterInfo* yWeights, int codeSelect, uint8* dst, uint32 dstBPR,
+			int32 xIndexL, int32 xIndexR, int32 first, int32 last)
+		:
+		fSrcBuffer(srcBuffer),
+		fXWeights(xWeights),
+		fYWeights(yWeights),
+		fCodeSelect(codeSelect),
+		fDst(dst),
+		fDstBPR(dstBPR),
+		fXIndexL(xIndexL),
+		fXIndexR(xIndexR),
+		fFirst(first),
+		fLast(last)
+	{
+	}
+
+	virtual void Run(int32 first, int32 last);
+
+private:
+	agg::rendering_buffer&	fSrcBuffer;
+	FilterInfo*				fXWeights;
+	FilterInfo*				fYWeights;
+	int						fCodeSelect;
+	uint8*					fDst;
+	uint32					fDstBPR;
+	int32					fXIndexL;
+	int32					fXIndexR;
+	int32					fFirst;
+	int32					fLast;
+};
+
+
+void
+BilinearScaleJob::Run(int32 y1, int32 y2)
+{
+	agg::rendering_buffer& srcBuffer = fSrcBuffer;
+	FilterInfo* xWeights = fXWeights;
+	FilterInfo* yWeights = fYWeights;
+	const uint32 dstBPR = fDstBPR;
+	const uint32 srcBPR = srcBuffer.stride();
+	const int32 xIndexL = fXIndexL;
+	const int32 xIndexR = fXIndexR;
+
+	// buffer offset into destination
+	uint8* dst = fDst + (y1 - fFirst) * dstBPR;
+
+	// Only the very last row of the clipping rectangle may have to be
+	// handled separately, not the last row of every band.
+	const bool isLastBand = y2 == fLast;
+
+	switch (fCodeSelect) {
+		case kOptimizeForLowFilterRatio:
+		{
+			// In this mode, we anticipate to hit many destination pixels
+			// that map directly to a source pixel, we have more branches
+			// in the inner loop but save time because of the special
+			// cases. If there are too few direct hit pixels, the branches
+			// only waste time.
+			for (; y1 <= y2; y1++) {
+				// cache the weight of the top and bottom row
+				const uint16 wTop = yWeights[y1].weight;
+				const uint16 wBottom = 255 - yWeights[y1].weight;
+
+				// buffer offset into source (top row)
+				register const uint8* src
+					= srcBuffer.row_ptr(yWeights[y1].index);
+				// buffer handle for destination to be incremented per
+				// pixel
+				register uint8* d = dst;
+
+				if (wTop == 255) {
+					for (int32 x = xIndexL; x <= xIndexR; x++) {
+						const uint8* s = src + xWeights[x].index;
+						// This case is important to prevent out
+						// of bounds access at bottom edge of the source
+						// bitmap. If the scale is low and integer, it will
+						// also help the speed.
+						if (xWeights[x].weight == 255) {
+							// As above, but to prevent out of bounds
+							// on the right edge.
+							*(uint32*)d = *(uint32*)s;
+						} else {
+							// Only the left and right pixels are
+							// interpolated, since the top row has 100%
+							// weight.
+							const uint16 wLeft = xWeights[x].weight;
+							const uint16 wRight = 255 - wLeft;
+							d[0] = (s[0] * wLeft + s[4] * wRight) >> 8;
+							d[1] = (s[1] * wLeft + s[5] * wRight) >> 8;
+							d[2] = (s[2] * wLeft + s[6] * wRight) >> 8;
+						}
+						d += 4;
+					}
+				} else {
+					for (int32 x = xIndexL; x <= xIndexR; x++) {
+						const uint8* s = src + xWeights[x].index;
+						if (xWeights[x].weight == 255) {
+							// Prevent out of bounds access on the right
+							// edge or simply speed up.
+							const uint8* sBottom = s + srcBPR;
+							d[0] = (s[0] * wTop + sBottom[0] * wBottom)
+								>> 8;
+							d[1] = (s[1] * wTop + sBottom[1] * wBottom)
+								>> 8;
+							d[2] = (s[2] * wTop + sBottom[2] * wBottom)
+								>> 8;
+						} else {
+							// calculate the weighted sum of all four
+							// interpolated pixels
+							const uint16 wLeft = xWeights[x].weight;
+							const uint16 wRight = 255 - wLeft;
+							// left and right of top row
+							uint32 t0 = (s[0] * wLeft + s[4] * wRight)
+								* wTop;
+							uint32 t1 = (s[1] * wLeft + s[5] * wRight)
+								* wTop;
+							uint32 t2 = (s[2] * wLeft + s[6] * wRight)
+								* wTop;
+
+							// left and right of bottom row
+							s += srcBPR;
+							t0 += (s[0] * wLeft + s[4] * wRight) * wBottom;
+							t1 += (s[1] * wLeft + s[5] * wRight) * wBottom;
+							t2 += (s[2] * wLeft + s[6] * wRight) * wBottom;
+
+							d[0] = t0 >> 16;
+							d[1] = t1 >> 16;
+							d[2] = t2 >> 16;
+						}
+						d += 4;
+					}
+				}
+				dst += dstBPR;
+			}
+			break;
+		}
+
+		case kUseDefaultVersion:
+		{
+			// In this mode we anticipate many pixels wich need filtering,
+			// there are no special cases for direct hit pixels except for
+			// the last column/row and the right/bottom corner pixel.
+
+			// The last column/row handling does not need to be performed
+			// for all clipping rects!
+			int32 yMax = y2;
+			if (isLastBand && yWeights[yMax].weight == 255)
+				yMax--;
+			int32 xIndexMax = xIndexR;
+			if (xWeights[xIndexMax].weight == 255)
+				xIndexMax--;
+
+			for (; y1 <= yMax; y1++) {
+				// cache the weight of the top and bottom row
+				const uint16 wTop = yWeights[y1].weight;
+				const uint16 wBottom = 255 - yWeights[y1].weight;
+
+				// buffer offset into source (top row)
+				register const uint8* src
+					= srcBuffer.row_ptr(yWeights[y1].index);
+				// buffer handle for destination to be incremented per
+				// pixel
+				register uint8* d = dst;
+
+				for (int32 x = xIndexL; x <= xIndexMax; x++) {
+					const uint8* s = src + xWeights[x].index;
+					// calculate the weighted sum of all four
+					// interpolated pixels
+					const uint16 wLeft = xWeights[x].weight;
+					const uint16 wRight = 255 - wLeft;
+					// left and right of top row
+					uint32 t0 = (s[0] * wLeft + s[4] * wRight) * wTop;
+					uint32 t1 = (s[1] * wLeft + s[5] * wRight) * wTop;
+					uint32 t2 = (s[2] * wLeft + s[6] * wRight) * wTop;
+
+					// left and right of bottom row
+					s += srcBPR;
+					t0 += (s[0] * wLeft + s[4] * wRight) * wBottom;
+					t1 += (s[1] * wLeft + s[5] * wRight) * wBottom;
+					t2 += (s[2] * wLeft + s[6] * wRight) * wBottom;
+					d[0] = t0 >> 16;
+					d[1] = t1 >> 16;
+					d[2] = t2 >> 16;
+					d += 4;
+				}
+				// last column of pixels if necessary
+				if (xIndexMax < xIndexR) {
+					const uint8* s = src + xWeights[xIndexR].index;
+					const uint8* sBottom = s + srcBPR;
+					d[0] = (s[0] * wTop + sBottom[0] * wBottom) >> 8;
+					d[1] = (s[1] * wTop + sBottom[1] * wBottom) >> 8;
+					d[2] = (s[2] * wTop + sBottom[2] * wBottom) >> 8;
+				}
+
+				dst += dstBPR;
+			}
+
+			// last row of pixels if necessary
+			// buffer offset into source (bottom row)
+			register const uint8* src
+				= srcBuffer.row_ptr(yWeights[y2].index);
+			// buffer handle for destination to be incremented per pixel
+			register uint8* d = dst;
+
+			if (yMax < y2) {
+				for (int32 x = xIndexL; x <= xIndexMax; x++) {
+					const uint8* s = src + xWeights[x].index;
+					const uint16 wLeft = xWeights[x].weight;
+					const uint16 wRight = 255 - wLeft;
+					d[0] = (s[0] * wLeft + s[4] * wRight) >> 8;
+					d[1] = (s[1] * wLeft + s[5] * wRight) >> 8;
+					d[2] = (s[2] * wLeft + s[6] * wRight) >> 8;
+					d += 4;
+				}
+			}
+
+			// pixel in bottom right corner if necessary
+			if (yMax < y2 && xIndexMax < xIndexR) {
+				const uint8* s = src + xWeights[xIndexR].index;
+				*(uint32*)d = *(uint32*)s;
+			}
+			break;
+		}
+
+#ifdef __INTEL__
+		case kUseSIMDVersion:
+		{
+			// Basically the same as the "standard" mode, but we use SIMD
+			// routines for the processing of the single display lines.
+
+			// The last column/row handling does not need to be performed
+			// for all clipping rects!
+			int32 yMax = y2;
+			if (isLastBand && yWeights[yMax].weight == 255)
+				yMax--;
+			int32 xIndexMax = xIndexR;
+			if (xWeights[xIndexMax].weight == 255)
+				xIndexMax--;
+
+			for (; y1 <= yMax; y1++) {
+				// cache the weight of the top and bottom row
+				const uint16 wTop = yWeights[y1].weight;
+				const uint16 wBottom = 255 - yWeights[y1].weight;
+
+				// buffer offset into source (top row)
+				const uint8* src = srcBuffer.row_ptr(yWeights[y1].index);
+				// buffer handle for destination to be incremented per
+				// pixel
+				uint8* d = dst;
+				bilinear_scale_xloop_mmxsse(src, dst, xWeights,	xIndexL,
+					xIndexMax, wTop, srcBPR);
+				// increase pointer by processed pixels
+				d += (xIndexMax - xIndexL + 1) * 4;
+
+				// last column of pixels if necessary
+				if (xIndexMax < xIndexR) {
+					const uint8* s = src + xWeights[xIndexR].index;
+					const uint8* sBottom = s + srcBPR;
+					d[0] = (s[0] * wTop + sBottom[0] * wBottom) >> 8;
+					d[1] = (s[1] * wTop + sBottom[1] * wBottom) >> 8;
+					d[2] = (s[2] * wTop + sBottom[2] * wBottom) >> 8;
+				}
+
+				dst += dstBPR;
+			}
+
+			// last row of pixels if necessary
+			// buffer offset into source (bottom row)
+			register const uint8* src
+				= srcBuffer.row_ptr(yWeights[y2].index);
+			// buffer handle for destination to be incremented per pixel
+			register uint8* d = dst;
+
+			if (yMax < y2) {
+				for (int32 x = xIndexL; x <= xIndexMax; x++) {
+					const uint8* s = src + xWeights[x].index;
+					const uint16 wLeft = xWeights[x].weight;
+					const uint16 wRight = 255 - wLeft;
+					d[0] = (s[0] * wLeft + s[4] * wRight) >> 8;
+					d[1] = (s[1] * wLeft + s[5] * wRight) >> 8;
+					d[2] = (s[2] * wLeft + s[6] * wRight) >> 8;
+					d += 4;
+				}
+			}
+
+			// pixel in bottom right corner if necessary
+			if (yMax < y2 && xIndexMax < xIndexR) {
+				const uint8* s = src + xWeights[xIndexR].index;
+				*(uint32*)d = *(uint32*)s;
+			}
+			break;
+		}
+#endif	// __INTEL__
+	}
+}
+
+}	// namespace
+
+
 // _DrawBitmapBilinearCopy32
 void
 Painter::_DrawBitmapBilinearCopy32(agg::rendering_buffer& srcBuffer,
@@ -2304,11 +2629,6 @@ Painter::_DrawBitmapBilinearCopy32(agg::rendering_buffer& srcBuffer,
 			- viewRect.top);
 	}
 
-	struct FilterInfo {
-		uint16 index;	// index into source bitmap row/column
-		uint16 weight;	// weight of the pixel at index [0..255]
-	};
-
 //#define FILTER_INFOS_ON_HEAP
 #ifdef FILTER_INFOS_ON_HEAP
 	FilterInfo* xWeights = new (nothrow) FilterInfo[dstWidth];
@@ -2384,15 +2704,8 @@ Painter::_DrawBitmapBilinearCopy32(agg::rendering_buffer& srcBuffer,
 	const int32 bottom = (int32)viewRect.bottom;
 
 	const uint32 dstBPR = fBuffer.stride();
-	const uint32 srcBPR = srcBuffer.stride();
 
 	// Figure out which version of the code we want to use...
-	enum {
-		kOptimizeForLowFilterRatio = 0,
-		kUseDefaultVersion,
-		kUseSIMDVersion
-	};
-
 	int codeSelect = kUseDefaultVersion;
 
 	uint32 neededSIMDFlags = APPSERVER_SIMD_MMX | APPSERVER_SIMD_SSE;
@@ -2431,250 +2744,15 @@ Painter::_DrawBitmapBilinearCopy32(agg::rendering_buffer& srcBuffer,
 //printf("x: %ld - %ld\n", xIndexL, xIndexR);
 //printf("y: %ld - %ld\n", y1, y2);
 
-		switch (codeSelect) {
-			case kOptimizeForLowFilterRatio:
-			{
-				// In this mode, we anticipate to hit many destination pixels
-				// that map directly to a source pixel, we have more branches
-				// in the inner loop but save time because of the special
-				// cases. If there are too few direct hit pixels, the branches
-				// only waste time.
-				for (; y1 <= y2; y1++) {
-					// cache the weight of the top and bottom row
-					const uint16 wTop = yWeights[y1].weight;
-					const uint16 wBottom = 255 - yWeights[y1].weight;
-
-					// buffer offset into source (top row)
-					register const uint8* src
-						= srcBuffer.row_ptr(yWeights[y1].index);
-					// buffer handle for destination to be incremented per
-					// pixel
-					register uint8* d = dst;
-
-					if (wTop == 255) {
-						for (int32 x = xIndexL; x <= xIndexR; x++) {
-							const uint8* s = src + xWeights[x].index;
-							// This case is important to prevent out
-							// of bounds access at bottom edge of the source
-							// bitmap. If the scale is low and integer, it will
-							// also help the speed.
-							if (xWeights[x].weight == 255) {
-								// As above, but to prevent out of bounds
-								// on the right edge.
-								*(uint32*)d = *(uint32*)s;
-							} else {
-								// Only the left and right pixels are
-								// interpolated, since the top row has 100%
-								// weight.
-								const uint16 wLeft = xWeights[x].weight;
-								const uint16 wRight = 255 - wLeft;
-								d[0] = (s[0] * wLeft + s[4] * wRight) >> 8;
-								d[1] = (s[1] * wLeft + s[5] * wRight) >> 8;
-								d[2] = (s[2] * wLeft + s[6] * wRight) >> 8;
-							}
-							d += 4;
-						}
-					} else {
-						for (int32 x = xIndexL; x <= xIndexR; x++) {
-							const uint8* s = src + xWeights[x].index;
-							if (xWeights[x].weight == 255) {
-								// Prevent out of bounds access on the right
-								// edge or simply speed up.
-								const uint8* sBottom = s + srcBPR;
-								d[0] = (s[0] * wTop + sBottom[0] * wBottom)
-									>> 8;
-								d[1] = (s[1] * wTop + sBottom[1] * wBottom)
-									>> 8;
-								d[2] = (s[2] * wTop + sBottom[2] * wBottom)
-									>> 8;
-							} else {
-								// calculate the weighted sum of all four
-								// interpolated pixels
-								const uint16 wLeft = xWeights[x].weight;
-								const uint16 wRight = 255 - wLeft;
-								// left and right of top row
-								uint32 t0 = (s[0] * wLeft + s[4] * wRight)
-									* wTop;
-								uint32 t1 = (s[1] * wLeft + s[5] * wRight)
-									* wTop;
-								uint32 t2 = (s[2] * wLeft + s[6] * wRight)
-									* wTop;
-
-								// left and right of bottom row
-								s += srcBPR;
-								t0 += (s[0] * wLeft + s[4] * wRight) * wBottom;
-								t1 += (s[1] * wLeft + s[5] * wRight) * wBottom;
-								t2 += (s[2] * wLeft + s[6] * wRight) * wBottom;
-
-								d[0] = t0 >> 16;
-								d[1] = t1 >> 16;
-								d[2] = t2 >> 16;
-							}
-							d += 4;
-						}
-					}
-					dst += dstBPR;
-				}
-				break;
-			}
-
-			case kUseDefaultVersion:
-			{
-				// In this mode we anticipate many pixels wich need filtering,
-				// there are no special cases for direct hit pixels except for
-				// the last column/row and the right/bottom corner pixel.
-
-				// The last column/row handling does not need to be performed
-				// for all clipping rects!
-				int32 yMax = y2;
-				if (yWeights[yMax].weight == 255)
-					yMax--;
-				int32 xIndexMax = xIndexR;
-				if (xWeights[xIndexMax].weight == 255)
-					xIndexMax--;
-
-				for (; y1 <= yMax; y1++) {
-					// cache the weight of the top and bottom row
-					const uint16 wTop = yWeights[y1].weight;
-					const uint16 wBottom = 255 - yWeights[y1].weight;
-
-					// buffer offset into source (top row)
-					register const uint8* src
-						= srcBuffer.row_ptr(yWeights[y1].index);
-					// buffer handle for destination to be incremented per
-					// pixel
-					register uint8* d = dst;
-
-					for (int32 x = xIndexL; x <= xIndexMax; x++) {
-						const uint8* s = src + xWeights[x].index;
-						// calculate the weighted sum of all four
-						// interpolated pixels
-						const uint16 wLeft = xWeights[x].weight;
-						const uint16 wRight = 255 - wLeft;
-						// left and right of top row
-						uint32 t0 = (s[0] * wLeft + s[4] * wRight) * wTop;
-						uint32 t1 = (s[1] * wLeft + s[5] * wRight) * wTop;
-						uint32 t2 = (s[2] * wLeft + s[6] * wRight) * wTop;
-
-						// left and right of bottom row
-						s += srcBPR;
-						t0 += (s[0] * wLeft + s[4] * wRight) * wBottom;
-						t1 += (s[1] * wLeft + s[5] * wRight) * wBottom;
-						t2 += (s[2] * wLeft + s[6] * wRight) * wBottom;
-						d[0] = t0 >> 16;
-						d[1] = t1 >> 16;
-						d[2] = t2 >> 16;
-						d += 4;
-					}
-					// last column of pixels if necessary
-					if (xIndexMax < xIndexR) {
-						const uint8* s = src + xWeights[xIndexR].index;
-						const uint8* sBottom = s + srcBPR;
-						d[0] = (s[0] * wTop + sBottom[0] * wBottom) >> 8;
-						d[1] = (s[1] * wTop + sBottom[1] * wBottom) >> 8;
-						d[2] = (s[2] * wTop + sBottom[2] * wBottom) >> 8;
-					}
-
-					dst += dstBPR;
-				}
+		BilinearScaleJob job(srcBuffer, xWeights, yWeights, codeSelect, dst,
+			dstBPR, xIndexL, xIndexR, y1, y2);
 
-				// last row of pixels if necessary
-				// buffer offset into source (bottom row)
-				register const uint8* src
-					= srcBuffer.row_ptr(yWeights[y2].index);
-				// buffer handle for destination to be incremented per pixel
-				register uint8* d = dst;
-
-				if (yMax < y2) {
-					for (int32 x = xIndexL; x <= xIndexMax; x++) {
-						const uint8* s = src + xWeights[x].index;
-						const uint16 wLeft = xWeights[x].weight;
-						const uint16 wRight = 255 - wLeft;
-						d[0] = (s[0] * wLeft + s[4] * wRight) >> 8;
-						d[1] = (s[1] * wLeft + s[5] * wRight) >> 8;
-						d[2] = (s[2] * wLeft + s[6] * wRight) >> 8;
-						d += 4;
-					}
-				}
-
-				// pixel in bottom right corner if necessary
-				if (yMax < y2 && xIndexMax < xIndexR) {
-					const uint8* s = src + xWeights[xIndexR].index;
-					*(uint32*)d = *(uint32*)s;
-				}
-				break;
-			}
-
-#ifdef __INTEL__
-			case kUseSIMDVersion:
-			{
-				// Basically the same as the "standard" mode, but we use SIMD
-				// routines for the processing of the single display lines.
-
-				// The last column/row handling does not need to be performed
-				// for all clipping rects!
-				int32 yMax = y2;
-				if (yWeights[yMax].weight == 255)
-					yMax--;
-				int32 xIndexMax = xIndexR;
-				if (xWeights[xIndexMax].weight == 255)
-					xIndexMax--;
-
-				for (; y1 <= yMax; y1++) {
-					// cache the weight of the top and bottom row
-					const uint16 wTop = yWeights[y1].weight;
-					const uint16 wBottom = 255 - yWeights[y1].weight;
-
-					// buffer offset into source (top row)
-					const uint8* src = srcBuffer.row_ptr(yWeights[y1].index);
-					// buffer handle for destination to be incremented per
-					// pixel
-					uint8* d = dst;
-					bilinear_scale_xloop_mmxsse(src, dst, xWeights,	xIndexL,
-						xIndexMax, wTop, srcBPR);
-					// increase pointer by processed pixels
-					d += (xIndexMax - xIndexL + 1) * 4;
-
-					// last column of pixels if necessary
-					if (xIndexMax < xIndexR) {
-						const uint8* s = src + xWeights[xIndexR].index;
-						const uint8* sBottom = s + srcBPR;
-						d[0] = (s[0] * wTop + sBottom[0] * wBottom) >> 8;
-						d[1] = (s[1] * wTop + sBottom[1] * wBottom) >> 8;
-						d[2] = (s[2] * wTop + sBottom[2] * wBottom) >> 8;
-					}
-
-					dst += dstBPR;
-				}
-
-				// last row of pixels if necessary
-				// buffer offset into source (bottom row)
-				register const uint8* src
-					= srcBuffer.row_ptr(yWeights[y2].index);
-				// buffer handle for destination to be incremented per pixel
-				register uint8* d = dst;
-
-				if (yMax < y2) {
-					for (int32 x = xIndexL; x <= xIndexMax; x++) {
-						const uint8* s = src + xWeights[x].index;
-						const uint16 wLeft = xWeights[x].weight;
-						const uint16 wRight = 255 - wLeft;
-						d[0] = (s[0] * wLeft + s[4] * wRight) >> 8;
-						d[1] = (s[1] * wLeft + s[5] * wRight) >> 8;
-						d[2] = (s[2] * wLeft + s[6] * wRight) >> 8;
-						d += 4;
-					}
-				}
-
-				// pixel in bottom right corner if necessary
-				if (yMax < y2 && xIndexMax < xIndexR) {
-					const uint8* s = src + xWeights[xIndexR].index;
-					*(uint32*)d = *(uint32*)s;
-				}
-				break;
-			}
-#endif	// __INTEL__
-		}
+		RenderWorkers* workers = RenderWorkers::Default();
+		if (workers != NULL
+			&& (x2 - x1 + 1) * (y2 - y1 + 1) >= kMinParallelScalePixels) {
+			workers->Run(job, y1, y2);
+		} else
+			job.Run(y1, y2);
 	} while (fBaseRenderer.next_clip_box());
 
 #ifdef FILTER_INFOS_ON_HEAP
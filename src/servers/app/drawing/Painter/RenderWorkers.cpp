@@ -0,0 +1,199 @@
+/*
+ * Copyright 2013, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+#include "RenderWorkers.h"
+
+#include <new>
+#include <pthread.h>
+
+
+using std::nothrow;
+
+
+// Bands should not get too small, or the synchronization overhead eats up
+// what is gained by the parallel rendering.
+static const int32 kMinBandHeight = 8;
+// More bands than threads, so that an unevenly expensive job still keeps
+// all threads busy until the end.
+static const int32 kBandsPerThread = 4;
+
+static pthread_once_t sDefaultInitOnce = PTHREAD_ONCE_INIT;
+static RenderWorkers* sDefault = NULL;
+
+
+RenderWorkers::Job::~Job()
+{
+}
+
+
+// #pragma mark -
+
+
+RenderWorkers::RenderWorkers()
+	:
+	fLock("render workers"),
+	fStartSem(-1),
+	fDoneSem(-1),
+	fWorkerCount(0),
+	fQuitting(false),
+	fJob(NULL),
+	fFirst(0),
+	fLast(-1),
+	fBandSize(0),
+	fBandCount(0),
+	fNextBand(0)
+{
+}
+
+
+RenderWorkers::~RenderWorkers()
+{
+	fQuitting = true;
+	if (fStartSem >= 0)
+		release_sem_etc(fStartSem, fWorkerCount, 0);
+
+	for (int32 i = 0; i < fWorkerCount; i++) {
+		status_t result;
+		wait_for_thread(fWorkers[i], &result);
+	}
+
+	delete_sem(fStartSem);
+	delete_sem(fDoneSem);
+}
+
+
+/*!	Returns the pool shared by all drawing threads. Its threads are only
+	spawned when it is first used.
+*/
+/*static*/ RenderWorkers*
+RenderWorkers::Default()
+{
+	pthread_once(&sDefaultInitOnce, &_InitDefault);
+	return sDefault;
+}
+
+
+/*!	Renders the rows from \a first to \a last of \a job, and returns when
+	all of them are done. If the workers are already busy with the job of
+	another drawing thread, the job is rendered by the calling thread alone
+	instead of waiting for them.
+*/
+void
+RenderWorkers::Run(Job& job, int32 first, int32 last)
+{
+	int32 rows = last - first + 1;
+	if (fWorkerCount == 0 || rows < 2 * kMinBandHeight
+		|| fLock.LockWithTimeout(0) != B_OK) {
+		job.Run(first, last);
+		return;
+	}
+
+	int32 bandCount = (fWorkerCount + 1) * kBandsPerThread;
+	int32 bandSize = (rows + bandCount - 1) / bandCount;
+	if (bandSize < kMinBandHeight)
+		bandSize = kMinBandHeight;
+
+	fJob = &job;
+	fFirst = first;
+	fLast = last;
+	fBandSize = bandSize;
+	fBandCount = (rows + bandSize - 1) / bandSize;
+	fNextBand = 0;
+
+	// Don't wake up more workers than there are bands to render
+	int32 workers = fBandCount - 1;
+	if (workers > fWorkerCount)
+		workers = fWorkerCount;
+
+	release_sem_etc(fStartSem, workers, 0);
+
+	_RunBands();
+
+	while (acquire_sem_etc(fDoneSem, workers, 0, 0) == B_INTERRUPTED)
+		;
+
+	fJob = NULL;
+	fLock.Unlock();
+}
+
+
+void
+RenderWorkers::_Init()
+{
+	system_info info;
+	if (get_system_info(&info) != B_OK || info.cpu_count < 2)
+		return;
+
+	fStartSem = create_sem(0, "render workers start");
+	fDoneSem = create_sem(0, "render workers done");
+	if (fStartSem < 0 || fDoneSem < 0)
+		return;
+
+	int32 count = info.cpu_count - 1;
+	if (count > kMaxWorkers)
+		count = kMaxWorkers;
+
+	for (int32 i = 0; i < count; i++) {
+		thread_id thread = spawn_thread(&_WorkerEntry, "render worker",
+			B_DISPLAY_PRIORITY, this);
+		if (thread < 0)
+			break;
+
+		fWorkers[fWorkerCount++] = thread;
+		resume_thread(thread);
+	}
+}
+
+
+/*static*/ void
+RenderWorkers::_InitDefault()
+{
+	sDefault = new(nothrow) RenderWorkers();
+	if (sDefault != NULL)
+		sDefault->_Init();
+}
+
+
+/*static*/ int32
+RenderWorkers::_WorkerEntry(void* cookie)
+{
+	((RenderWorkers*)cookie)->_Work();
+	return 0;
+}
+
+
+void
+RenderWorkers::_Work()
+{
+	while (true) {
+		status_t status = acquire_sem(fStartSem);
+		if (status == B_INTERRUPTED)
+			continue;
+		if (status != B_OK || fQuitting)
+			break;
+
+		_RunBands();
+		release_sem(fDoneSem);
+	}
+}
+
+
+void
+RenderWorkers::_RunBands()
+{
+	while (true) {
+		int32 band = atomic_add(&fNextBand, 1);
+		if (band >= fBandCount)
+			break;
+
+		int32 first = fFirst + band * fBandSize;
+		int32 last = first + fBandSize - 1;
+		if (last > fLast)
+			last = fLast;
+
+		fJob->Run(first, last);
+	}
+}
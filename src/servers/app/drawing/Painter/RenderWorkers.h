@@ -0,0 +1,68 @@
+/*
+ * Copyright 2013, Haiku, Inc. All rights reserved.
+ * Distributed under the terms of the MIT License.
+ */
+#ifndef RENDER_WORKERS_H
+#define RENDER_WORKERS_H
+
+
+#include <Locker.h>
+#include <OS.h>
+
+
+/*!	A small pool of threads that helps the drawing thread with expensive
+	operations on large areas of the frame buffer. A job is split into bands
+	of rows, which must be independent of each other; the workers and the
+	calling thread then render the bands concurrently.
+*/
+class RenderWorkers {
+public:
+	class Job {
+	public:
+		virtual					~Job();
+
+		// Renders all rows from first to last, inclusive.
+		virtual	void			Run(int32 first, int32 last) = 0;
+	};
+
+								~RenderWorkers();
+
+	static	RenderWorkers*		Default();
+
+			int32				CountWorkers() const
+									{ return fWorkerCount; }
+
+			void				Run(Job& job, int32 first, int32 last);
+
+private:
+								RenderWorkers();
+
+			void				_Init();
+	static	void				_InitDefault();
+
+	static	int32				_WorkerEntry(void* cookie);
+			void				_Work();
+			void				_RunBands();
+
+private:
+	enum {
+		kMaxWorkers = 7
+	};
+
+			BLocker				fLock;
+			sem_id				fStartSem;
+			sem_id				fDoneSem;
+			thread_id			fWorkers[kMaxWorkers];
+			int32				fWorkerCount;
+	volatile bool				fQuitting;
+
+			Job*				fJob;
+			int32				fFirst;
+			int32				fLast;
+			int32				fBandSize;
+			int32				fBandCount;
+			vint32				fNextBand;
+};
+
+
+#endif	// RENDER_WORKERS_H
@@ -65,13 +65,13 @@ UpdateQueue::Init()
 {
 	CALLED();
 
-	Shutdown();
-
-	fRetraceSem = fInterface->RetraceSemaphore();
-//	fRefreshDuration = fInterface->...
+	_UpdateTiming();
 
-	TRACE("fRetraceSem: %ld, fRefreshDuration: %lld\n",
-		fRetraceSem, fRefreshDuration);
+	// NOTE: This is called with the HWInterface write locked when the mode
+	// changes. The runner must not be stopped here, since it might just be
+	// waiting for that lock. It picks up the new timing on its own.
+	if (fUpdateExecutor >= B_OK)
+		return B_OK;
 
 	fQuitting = false;
 	fUpdateExecutor = spawn_thread(_ExecuteUpdatesEntry, "update queue runner",
@@ -111,6 +111,70 @@ UpdateQueue::AddRect(const BRect& rect)
 	}
 }
 
+// RemoveRegion
+/*!	Removes \a region from the pending updates. This is used when the area is
+	about to be redrawn in several steps, and will be added again once that
+	is complete; copying it to the front buffer in between would show the
+	half finished drawing.
+*/
+void
+UpdateQueue::RemoveRegion(const BRegion& region)
+{
+	if (Lock()) {
+		fUpdateRegion.Exclude(&region);
+		Unlock();
+	}
+}
+
+// _UpdateTiming
+void
+UpdateQueue::_UpdateTiming()
+{
+	fRetraceSem = fInterface->RetraceSemaphore();
+
+	display_mode mode;
+	fInterface->GetMode(&mode);
+	if (mode.timing.pixel_clock > 0 && mode.timing.h_total > 0
+		&& mode.timing.v_total > 0) {
+		// the pixel clock is in kHz
+		fRefreshDuration = (bigtime_t)mode.timing.h_total
+			* mode.timing.v_total * 1000 / mode.timing.pixel_clock;
+	} else
+		fRefreshDuration = 1000000 / 60;
+
+	TRACE("fRetraceSem: %ld, fRefreshDuration: %lld\n",
+		fRetraceSem, fRefreshDuration);
+}
+
+// _WaitForRefresh
+/*!	Waits until the next vertical retrace, or, if the retrace semaphore is
+	not available, for the duration of one refresh. Returns \c false when
+	the runner should quit.
+*/
+bool
+UpdateQueue::_WaitForRefresh()
+{
+	status_t err = B_ERROR;
+	sem_id retraceSem = fRetraceSem;
+	if (retraceSem >= 0) {
+		bigtime_t timeout = system_time() + fRefreshDuration * 2;
+		do {
+			err = acquire_sem_etc(retraceSem, 1,
+				B_ABSOLUTE_TIMEOUT | B_CAN_INTERRUPT, timeout);
+		} while (err == B_INTERRUPTED && !fQuitting);
+	}
+
+	if (err != B_OK && err != B_TIMED_OUT) {
+		// no retrace semaphore, or it has just been deleted by a mode change
+		bigtime_t timeout = system_time() + fRefreshDuration;
+		do {
+			err = snooze_until(timeout, B_SYSTEM_TIMEBASE);
+		} while (err == B_INTERRUPTED && !fQuitting);
+	}
+
+	return !fQuitting;
+}
+
 // _ExecuteUpdatesEntry
 int32
 UpdateQueue::_ExecuteUpdatesEntry(void* cookie)
@@ -123,50 +187,39 @@ UpdateQueue::_ExecuteUpdatesEntry(void* cookie)
 int32
 UpdateQueue::_ExecuteUpdates()
 {
-	while (!fQuitting) {
-		status_t err;
-		if (fRetraceSem >= 0) {
-			bigtime_t timeout = system_time() + fRefreshDuration * 2;
-//			TRACE("acquire_sem_etc(%lld)\n", timeout);
-			do {
-				err = acquire_sem_etc(fRetraceSem, 1,
-					B_ABSOLUTE_TIMEOUT | B_CAN_INTERRUPT, timeout);
-			} while (err == B_INTERRUPTED && !fQuitting);
-		} else {
-			bigtime_t timeout = system_time() + fRefreshDuration;
-//			TRACE("snooze_until(%lld)\n", timeout);
-			do {
-				err = snooze_until(timeout, B_SYSTEM_TIMEBASE);
-			} while (err == B_INTERRUPTED && !fQuitting);
-		}
-		if (fQuitting)
-			return B_OK;
-		switch (err) {
-			case B_OK:
-			case B_TIMED_OUT:
-				// execute updates
-				if (fInterface->LockParallelAccess()) {
-					if (Lock()) {
-						int32 count = fUpdateRegion.CountRects();
-						if (count > 0) {
-							TRACE("CopyBackToFront() - rects: %ld\n", count);
-							// NOTE: not using the BRegion version, since that
-							// doesn't take care of leaving out and compositing
-							// the cursor.
-							for (int32 i = 0; i < count; i++)
-								fInterface->CopyBackToFront(
-									fUpdateRegion.RectAt(i));
-							fUpdateRegion.MakeEmpty();
-						}
-						Unlock();
-					}
-					fInterface->UnlockParallelAccess();
-				}
-				break;
-			default:
-				return err;
+	while (_WaitForRefresh()) {
+		if (!Lock())
+			break;
+		bool hasUpdates = fUpdateRegion.CountRects() > 0;
+		Unlock();
+
+		if (!hasUpdates)
+			continue;
+
+		// The exclusive lock makes sure that no drawing operation is in
+		// progress, so only complete drawing is transferred. Our own lock
+		// is not held during the transfer, as CopyBackToFront() needs the
+		// cursor lock, which is held by MoveCursorTo() when it calls
+		// AddRect().
+		if (!fInterface->LockExclusiveAccess())
+			continue;
+
+		BRegion region;
+		if (Lock()) {
+			region = fUpdateRegion;
+			fUpdateRegion.MakeEmpty();
+			Unlock();
 		}
+
+		int32 count = region.CountRects();
+		TRACE("CopyBackToFront() - rects: %ld\n", count);
+		// NOTE: not using the BRegion version, since that
+		// doesn't take care of leaving out and compositing
+		// the cursor.
+		for (int32 i = 0; i < count; i++)
+			fInterface->CopyBackToFront(region.RectAt(i));
+
+		fInterface->UnlockExclusiveAccess();
 	}
 	return B_OK;
 }
-
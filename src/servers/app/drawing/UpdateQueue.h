@@ -24,8 +24,12 @@ class UpdateQueue : public BLocker, public HWInterfaceListener {
 			void				Shutdown();
 
 			void				AddRect(const BRect& rect);
+			void				RemoveRegion(const BRegion& region);
 
  private:
+			void				_UpdateTiming();
+			bool				_WaitForRefresh();
+
 	static	int32				_ExecuteUpdatesEntry(void *cookie);
 			int32				_ExecuteUpdates();
 
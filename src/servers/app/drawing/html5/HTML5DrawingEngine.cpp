@@ -667,6 +667,14 @@ HTML5DrawingEngine::FillRegion(BRegion& region, const BGradient& gradient)
 }
 
 
+void
+HTML5DrawingEngine::FillRects(const BRect* rects, int32 count)
+{
+	for (int32 i = 0; i < count; i++)
+		FillRect(rects[i]);
+}
+
+
 void
 HTML5DrawingEngine::DrawRoundRect(BRect rect, float xRadius, float yRadius,
 	bool filled)
@@ -666,6 +666,14 @@ RemoteDrawingEngine::FillRegion(BRegion& region, const BGradient& gradient)
 }
 
 
+void
+RemoteDrawingEngine::FillRects(const BRect* rects, int32 count)
+{
+	for (int32 i = 0; i < count; i++)
+		FillRect(rects[i]);
+}
+
+
 void
 RemoteDrawingEngine::DrawRoundRect(BRect rect, float xRadius, float yRadius,
 	bool filled)
@@ -99,6 +99,7 @@ public:
 	virtual	void				FillRegion(BRegion& region);
 	virtual	void				FillRegion(BRegion& region,
 									const BGradient& gradient);
+	virtual	void				FillRects(const BRect* rects, int32 count);
 
 	virtual	void				DrawRoundRect(BRect rect, float xRadius,
 									float yRadius, bool filled);
@@ -108,6 +108,17 @@ FontCache::Recycle(FontCacheEntry* entry)
 		return;
 	entry->UpdateUsage();
 	entry->ReleaseReference();
+
+	if (FontCacheEntry::GlyphMemoryExceeded()) {
+		// Entries with only a few glyphs don't remove any themselves, so
+		// many of them could exceed the budget without ever creating a new
+		// entry. A single entry is left alone, it has to trim its glyphs.
+		AutoWriteLocker locker(this);
+		if (locker.IsLocked() && fFontCacheEntries.Size() > 1
+			&& FontCacheEntry::GlyphMemoryExceeded()) {
+			_RemoveUnusedEntry();
+		}
+	}
 }
 
 static const int32 kMaxEntryCount = 30;
@@ -123,7 +134,11 @@ void
 FontCache::_ConstrainEntryCount()
 {
 	// this function is only ever called with the WriteLock held
-	if (fFontCacheEntries.Size() < kMaxEntryCount)
+	// NOTE: when the glyphs use too much memory, the least used entry is
+	// removed as well; its memory is freed once it is no longer in use.
+	if (fFontCacheEntries.Size() < kMaxEntryCount
+		&& (fFontCacheEntries.Size() == 0
+			|| !FontCacheEntry::GlyphMemoryExceeded()))
 		return;
 //printf("FontCache::_ConstrainEntryCount()\n");
 
@@ -159,3 +174,43 @@ FontCache::_ConstrainEntryCount()
 		}
 	}
 }
+
+// _RemoveUnusedEntry
+void
+FontCache::_RemoveUnusedEntry()
+{
+	// this function is only ever called with the WriteLock held
+	// NOTE: only entries that are not in use are considered, since their
+	// glyph memory is freed right away. The memory of an entry that is
+	// still in use would keep the budget exceeded, and let every following
+	// Recycle() remove another entry.
+	FontCacheEntry* leastUsedEntry = NULL;
+	double leastUsageIndex = 0;
+	bigtime_t now = system_time();
+
+	FontMap::Iterator iterator = fFontCacheEntries.GetIterator();
+	while (iterator.HasNext()) {
+		FontCacheEntry* entry = iterator.Next().value;
+		if (entry->CountReferences() > 1)
+			continue;
+
+		double usageIndex = usage_index(entry->UsedCount(),
+			now - entry->LastUsed());
+		if (leastUsedEntry == NULL || usageIndex < leastUsageIndex) {
+			leastUsedEntry = entry;
+			leastUsageIndex = usageIndex;
+		}
+	}
+
+	if (leastUsedEntry == NULL)
+		return;
+
+	iterator = fFontCacheEntries.GetIterator();
+	while (iterator.HasNext()) {
+		if (iterator.Next().value == leastUsedEntry) {
+			iterator.Remove();
+			leastUsedEntry->ReleaseReference();
+			break;
+		}
+	}
+}
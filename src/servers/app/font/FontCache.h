@@ -29,6 +29,7 @@ class FontCache : public MultiLocker {
 
  private:
 			void				_ConstrainEntryCount();
+			void				_RemoveUnusedEntry();
 
 	static	FontCache			sDefaultInstance;
 
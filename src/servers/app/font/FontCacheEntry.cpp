@@ -34,12 +34,28 @@
 
 #include <agg_array.h>
 #include <utf8_functions.h>
+#include <util/DoublyLinkedList.h>
 #include <util/OpenHashTable.h>
 
 #include "GlobalSubpixelSettings.h"
 
 
+// The memory all cached glyphs of all entries may use together. When it is
+// exceeded, an entry that needs to create a new glyph removes its least
+// recently used ones first, and the FontCache removes whole entries when
+// they are recycled.
+static const int32 kGlyphMemoryBudget = 8 * 1024 * 1024;
+
+
 BLocker FontCacheEntry::sUsageUpdateLock("FontCacheEntry usage lock");
+vint32 FontCacheEntry::sGlyphMemory = 0;
+
+
+static inline int32
+glyph_memory(const GlyphCache* glyph)
+{
+	return sizeof(GlyphCache) + glyph->data_size;
+}
 
 
 class FontCacheEntry::GlyphCachePool {
@@ -94,9 +110,21 @@ public:
 		return fGlyphTable.Lookup(glyphIndex);
 	}
 
+	const GlyphCache* UseGlyph(uint32 glyphIndex, uint32 usage)
+	{
+		GlyphCache* glyph = fGlyphTable.Lookup(glyphIndex);
+		if (glyph != NULL) {
+			// NOTE: this is done with only the read lock held, but it does
+			// not matter which of several concurrent users wins.
+			glyph->last_used = usage;
+		}
+		return glyph;
+	}
+
 	GlyphCache* CacheGlyph(uint32 glyphIndex,
 		uint32 dataSize, glyph_data_type dataType, const agg::rect_i& bounds,
-		float advanceX, float advanceY, float insetLeft, float insetRight)
+		float advanceX, float advanceY, float insetLeft, float insetRight,
+		uint32 usage)
 	{
 		GlyphCache* glyph = fGlyphTable.Lookup(glyphIndex);
 		if (glyph != NULL)
@@ -109,14 +137,49 @@ public:
 			return NULL;
 		}
 
-		// TODO: The HashTable grows without bounds. We should cleanup
-		// older entries from time to time.
-
+		glyph->last_used = usage;
 		fGlyphTable.Insert(glyph);
 
 		return glyph;
 	}
 
+	/*!	Removes the least recently used glyphs until at least \a bytesToFree
+		bytes have been freed. Glyphs that have been used during the current
+		\a usage are never removed, since they may still be referenced by
+		the string being laid out. Returns the number of bytes freed.
+	*/
+	int32 RemoveUnusedGlyphs(uint32 usage, int32 bytesToFree)
+	{
+		uint32 oldestAge = 0;
+		GlyphTable::Iterator iterator = fGlyphTable.GetIterator();
+		while (iterator.HasNext()) {
+			uint32 age = usage - iterator.Next()->last_used;
+			if (age > oldestAge)
+				oldestAge = age;
+		}
+
+		// Remove the older half of the age range at a time, until enough
+		// has been freed
+		int32 freed = 0;
+		uint32 minAge = oldestAge;
+		while (freed < bytesToFree && minAge > 1) {
+			minAge = (minAge + 1) / 2;
+
+			iterator.Rewind();
+			while (iterator.HasNext()) {
+				GlyphCache* glyph = iterator.Next();
+				if (usage - glyph->last_used < minAge)
+					continue;
+
+				fGlyphTable.RemoveUnchecked(glyph);
+				freed += glyph_memory(glyph);
+				delete glyph;
+			}
+		}
+
+		return freed;
+	}
+
 private:
 	typedef BOpenHashTable<GlyphHashTableDefinition> GlyphTable;
 
@@ -127,11 +190,188 @@ private:
 // #pragma mark -
 
 
+/*!	Remembers the widths of the strings that were measured most recently
+	with this font. Applications tend to measure the same labels and cells
+	over and over again during layout. Unlike the glyph cache, this one has
+	its own lock, as lookups happen with only the read lock of the entry
+	held.
+*/
+class FontCacheEntry::StringWidthCache {
+	struct Width : DoublyLinkedListLinkImpl<Width> {
+		Width(const char* string, int32 length, uint8 spacing, uint32 hash)
+			:
+			string((char*)malloc(length)),
+			length(length),
+			spacing(spacing),
+			hash(hash),
+			width(0.0f),
+			hash_link(NULL)
+		{
+			if (this->string != NULL)
+				memcpy(this->string, string, length);
+		}
+
+		~Width()
+		{
+			free(string);
+		}
+
+		char*	string;
+		int32	length;
+		uint8	spacing;
+		uint32	hash;
+		float	width;
+		Width*	hash_link;
+	};
+
+	struct Key {
+		Key(const char* string, int32 length, uint8 spacing)
+			:
+			string(string),
+			length(length),
+			spacing(spacing),
+			hash(_Hash(string, length, spacing))
+		{
+		}
+
+		const char*	string;
+		int32		length;
+		uint8		spacing;
+		uint32		hash;
+
+	private:
+		static uint32 _Hash(const char* string, int32 length, uint8 spacing)
+		{
+			uint32 hash = spacing;
+			for (int32 i = 0; i < length; i++)
+				hash = (hash << 5) + (hash >> 27) + (uint8)string[i];
+			return hash;
+		}
+	};
+
+	struct WidthHashTableDefinition {
+		typedef Key		KeyType;
+		typedef	Width	ValueType;
+
+		size_t HashKey(const Key& key) const
+		{
+			return key.hash;
+		}
+
+		size_t Hash(Width* value) const
+		{
+			return value->hash;
+		}
+
+		bool Compare(const Key& key, Width* value) const
+		{
+			return value->hash == key.hash && value->length == key.length
+				&& value->spacing == key.spacing
+				&& memcmp(value->string, key.string, key.length) == 0;
+		}
+
+		Width*& GetLink(Width* value) const
+		{
+			return value->hash_link;
+		}
+	};
+
+	typedef BOpenHashTable<WidthHashTableDefinition> WidthTable;
+	typedef DoublyLinkedList<Width> WidthList;
+
+	enum {
+		kMaxWidths			= 512,
+		kMaxStringLength	= 256
+	};
+
+public:
+	StringWidthCache()
+		:
+		fLock("string width cache")
+	{
+	}
+
+	~StringWidthCache()
+	{
+		while (Width* width = fLRUList.RemoveHead())
+			delete width;
+	}
+
+	status_t Init()
+	{
+		return fTable.Init();
+	}
+
+	bool Lookup(const char* string, int32 length, uint8 spacing,
+		float* _width)
+	{
+		if (length > kMaxStringLength)
+			return false;
+
+		BAutolock _(fLock);
+
+		Width* width = fTable.Lookup(Key(string, length, spacing));
+		if (width == NULL)
+			return false;
+
+		// move to the end of the LRU list
+		fLRUList.Remove(width);
+		fLRUList.Add(width);
+
+		*_width = width->width;
+		return true;
+	}
+
+	void Insert(const char* string, int32 length, uint8 spacing,
+		float stringWidth)
+	{
+		if (length > kMaxStringLength)
+			return;
+
+		BAutolock _(fLock);
+
+		Key key(string, length, spacing);
+		if (fTable.Lookup(key) != NULL)
+			return;
+
+		if (fTable.CountElements() >= kMaxWidths) {
+			Width* oldest = fLRUList.RemoveHead();
+			fTable.Remove(oldest);
+			delete oldest;
+		}
+
+		Width* width = new(std::nothrow) Width(string, length, spacing,
+			key.hash);
+		if (width == NULL || width->string == NULL) {
+			delete width;
+			return;
+		}
+
+		width->width = stringWidth;
+		if (fTable.Insert(width) != B_OK) {
+			delete width;
+			return;
+		}
+		fLRUList.Add(width);
+	}
+
+private:
+	BLocker		fLock;
+	WidthTable	fTable;
+	WidthList	fLRUList;
+};
+
+
+// #pragma mark -
+
+
 FontCacheEntry::FontCacheEntry()
 	:
 	MultiLocker("FontCacheEntry lock"),
 	fGlyphCache(new(std::nothrow) GlyphCachePool()),
+	fStringWidthCache(new(std::nothrow) StringWidthCache()),
 	fEngine(),
+	fGlyphMemory(0),
 	fLastUsedTime(LONGLONG_MIN),
 	fUseCounter(0)
 {
@@ -142,13 +382,15 @@ FontCacheEntry::~FontCacheEntry()
 {
 //printf("~FontCacheEntry()\n");
 	delete fGlyphCache;
+	delete fStringWidthCache;
+	atomic_add(&sGlyphMemory, -fGlyphMemory);
 }
 
 
 bool
 FontCacheEntry::Init(const ServerFont& font)
 {
-	if (fGlyphCache == NULL)
+	if (fGlyphCache == NULL || fStringWidthCache == NULL)
 		return false;
 
 	glyph_rendering renderingType = _RenderTypeFor(font);
@@ -163,7 +405,7 @@ FontCacheEntry::Init(const ServerFont& font)
 			"file %s\n", font.Path());
 		return false;
 	}
-	if (fGlyphCache->Init() != B_OK) {
+	if (fGlyphCache->Init() != B_OK || fStringWidthCache->Init() != B_OK) {
 		fprintf(stderr, "FontCacheEntry::Init() - failed to allocate "
 			"GlyphCache table for font file %s\n", font.Path());
 		return false;
@@ -260,7 +502,7 @@ const GlyphCache*
 FontCacheEntry::CachedGlyph(uint32 glyphCode)
 {
 	// Only requires a read lock.
-	return fGlyphCache->FindGlyph(glyphCode);
+	return fGlyphCache->UseGlyph(glyphCode, (uint32)fUseCounter);
 }
 
 
@@ -276,10 +518,18 @@ FontCacheEntry::CreateGlyph(uint32 glyphCode, FontCacheEntry* fallbackEntry)
 	// NOTE: Both this and the fallback FontCacheEntry are expected to be
 	// write-locked!
 
-	const GlyphCache* glyph = fGlyphCache->FindGlyph(glyphCode);
+	const GlyphCache* glyph = fGlyphCache->UseGlyph(glyphCode,
+		(uint32)fUseCounter);
 	if (glyph != NULL)
 		return glyph;
 
+	if (GlyphMemoryExceeded() && fGlyphMemory > kGlyphMemoryBudget / 16) {
+		// make room by removing half of our glyphs that have not been used
+		// recently; smaller entries are left to the FontCache to remove
+		_AddGlyphMemory(-fGlyphCache->RemoveUnusedGlyphs((uint32)fUseCounter,
+			fGlyphMemory / 2));
+	}
+
 	FontEngine* engine = &fEngine;
 	uint32 glyphIndex = engine->GlyphIndexForGlyphCode(glyphCode);
 	if (glyphIndex == 0 && fallbackEntry != NULL) {
@@ -292,8 +542,11 @@ FontCacheEntry::CreateGlyph(uint32 glyphCode, FontCacheEntry* fallbackEntry)
 	if (glyphIndex == 0) {
 		if (render_as_zero_width(glyphCode)) {
 			// cache and return a zero width glyph
-			return fGlyphCache->CacheGlyph(glyphCode, 0, glyph_data_invalid,
-				agg::rect_i(0, 0, -1, -1), 0, 0, 0, 0);
+			glyph = fGlyphCache->CacheGlyph(glyphCode, 0, glyph_data_invalid,
+				agg::rect_i(0, 0, -1, -1), 0, 0, 0, 0, (uint32)fUseCounter);
+			if (glyph != NULL)
+				_AddGlyphMemory(glyph_memory(glyph));
+			return glyph;
 		}
 
 		// reset to our engine
@@ -310,10 +563,12 @@ FontCacheEntry::CreateGlyph(uint32 glyphCode, FontCacheEntry* fallbackEntry)
 		glyph = fGlyphCache->CacheGlyph(glyphCode,
 			engine->DataSize(), engine->DataType(), engine->Bounds(),
 			engine->AdvanceX(), engine->AdvanceY(),
-			engine->InsetLeft(), engine->InsetRight());
+			engine->InsetLeft(), engine->InsetRight(), (uint32)fUseCounter);
 
-		if (glyph != NULL)
+		if (glyph != NULL) {
 			engine->WriteGlyphTo(glyph->data);
+			_AddGlyphMemory(glyph_memory(glyph));
+		}
 	}
 
 	return glyph;
@@ -360,6 +615,28 @@ FontCacheEntry::GetKerning(uint32 glyphCode1, uint32 glyphCode2,
 }
 
 
+/*!	Returns the width of the string as cached by CacheStringWidth() before,
+	if it is still known. Only requires a read lock.
+*/
+bool
+FontCacheEntry::CachedStringWidth(const char* string, int32 length,
+	uint8 spacing, float* _width)
+{
+	return fStringWidthCache->Lookup(string, length, spacing, _width);
+}
+
+
+/*!	Remembers the width of the given string, as measured without any
+	escapement delta. Only requires a read lock.
+*/
+void
+FontCacheEntry::CacheStringWidth(const char* string, int32 length,
+	uint8 spacing, float width)
+{
+	fStringWidthCache->Insert(string, length, spacing, width);
+}
+
+
 /*static*/ void
 FontCacheEntry::GenerateSignature(char* signature, size_t signatureSize,
 	const ServerFont& font)
@@ -392,6 +669,24 @@ FontCacheEntry::UpdateUsage()
 }
 
 
+/*!	Returns whether the cached glyphs of all entries together use more memory
+	than they should.
+*/
+/*static*/ bool
+FontCacheEntry::GlyphMemoryExceeded()
+{
+	return sGlyphMemory > kGlyphMemoryBudget;
+}
+
+
+void
+FontCacheEntry::_AddGlyphMemory(int32 size)
+{
+	fGlyphMemory += size;
+	atomic_add(&sGlyphMemory, size);
+}
+
+
 /*static*/ glyph_rendering
 FontCacheEntry::_RenderTypeFor(const ServerFont& font)
 {
@@ -54,6 +54,7 @@ struct GlyphCache {
 		advance_y(advanceY),
 		inset_left(insetLeft),
 		inset_right(insetRight),
+		last_used(0),
 		hash_link(NULL)
 	{
 	}
@@ -73,6 +74,7 @@ struct GlyphCache {
 	float			inset_left;
 	float			inset_right;
 
+	uint32			last_used;
 	GlyphCache*		hash_link;
 };
 
@@ -118,6 +120,12 @@ class FontCacheEntry : public MultiLocker, public BReferenceable {
 			bool				GetKerning(uint32 glyphCode1,
 									uint32 glyphCode2, double* x, double* y);
 
+			bool				CachedStringWidth(const char* string,
+									int32 length, uint8 spacing,
+									float* _width);
+			void				CacheStringWidth(const char* string,
+									int32 length, uint8 spacing, float width);
+
 	static	void				GenerateSignature(char* signature,
 									size_t signatureSize,
 									const ServerFont& font);
@@ -129,16 +137,24 @@ class FontCacheEntry : public MultiLocker, public BReferenceable {
 			uint64				UsedCount() const
 									{ return fUseCounter; }
 
+	static	bool				GlyphMemoryExceeded();
+
  private:
 								FontCacheEntry(const FontCacheEntry&);
 			const FontCacheEntry& operator=(const FontCacheEntry&);
 
 	static	glyph_rendering		_RenderTypeFor(const ServerFont& font);
 
+			void				_AddGlyphMemory(int32 size);
+
 			class GlyphCachePool;
+			class StringWidthCache;
 
 			GlyphCachePool*		fGlyphCache;
+			StringWidthCache*	fStringWidthCache;
 			FontEngine			fEngine;
+			int32				fGlyphMemory;
+	static	vint32				sGlyphMemory;
 
 	static	BLocker				sUsageUpdateLock;
 			bigtime_t			fLastUsedTime;
@@ -11,6 +11,8 @@
 #include <errno.h>
 #include <limits.h>
 
+#include <new>
+
 #include <module.h>
 
 #include <AutoDeleter.h>
@@ -31,6 +33,8 @@
 #define MAX_SOCKET_ADDRESS_LENGTH	(sizeof(sockaddr_storage))
 #define MAX_SOCKET_OPTION_LENGTH	128
 #define MAX_ANCILLARY_DATA_LENGTH	1024
+#define MAX_MULTIPLE_MESSAGES		1024
+#define MAX_RECEIVE_BATCH			64
 
 #define GET_SOCKET_FD_OR_RETURN(fd, kernel, descriptor)	\
 	do {												\
@@ -217,6 +221,145 @@ get_socket_descriptor(int fd, bool kernel, file_descriptor*& descriptor)
 }
 
 
+/*!	The userland pointers of a message that is being received, and the
+	kernel buffers that replace them during the receive.
+*/
+struct userland_receive {
+	msghdr*			userMessage;
+	iovec*			userVecs;
+	MemoryDeleter	vecsDeleter;
+	void*			userAddress;
+	void*			userAncillary;
+	MemoryDeleter	ancillaryDeleter;
+	char			address[MAX_SOCKET_ADDRESS_LENGTH];
+};
+
+
+static status_t
+prepare_userland_receive(struct msghdr *userMessage, msghdr& message,
+	userland_receive& receive)
+{
+	// copy message from userland
+	receive.userMessage = userMessage;
+	status_t error = prepare_userland_msghdr(userMessage, message,
+		receive.userVecs, receive.vecsDeleter, receive.userAddress,
+		receive.address);
+	if (error != B_OK)
+		return error;
+
+	// prepare a buffer for ancillary data
+	receive.userAncillary = message.msg_control;
+	if (receive.userAncillary != NULL) {
+		if (!IS_USER_ADDRESS(receive.userAncillary))
+			return B_BAD_ADDRESS;
+		if (message.msg_controllen < 0)
+			return B_BAD_VALUE;
+		if (message.msg_controllen > MAX_ANCILLARY_DATA_LENGTH)
+			message.msg_controllen = MAX_ANCILLARY_DATA_LENGTH;
+
+		message.msg_control = malloc(message.msg_controllen);
+		if (message.msg_control == NULL)
+			return B_NO_MEMORY;
+
+		receive.ancillaryDeleter.SetTo(message.msg_control);
+	}
+
+	return B_OK;
+}
+
+
+static status_t
+finish_userland_receive(msghdr& message, userland_receive& receive)
+{
+	// copy the address, the ancillary data, and the message header back to
+	// userland
+	void* ancillary = message.msg_control;
+	message.msg_name = receive.userAddress;
+	message.msg_iov = receive.userVecs;
+	message.msg_control = receive.userAncillary;
+	if ((receive.userAddress != NULL && user_memcpy(receive.userAddress,
+				receive.address, message.msg_namelen) != B_OK)
+		|| (receive.userAncillary != NULL && user_memcpy(
+				receive.userAncillary, ancillary, message.msg_controllen)
+					!= B_OK)
+		|| user_memcpy(receive.userMessage, &message, sizeof(msghdr))
+			!= B_OK) {
+		return B_BAD_ADDRESS;
+	}
+
+	return B_OK;
+}
+
+
+static ssize_t
+user_recvmsg(net_socket* socket, struct msghdr *userMessage, int flags)
+{
+	msghdr message;
+	userland_receive receive;
+	status_t error = prepare_userland_receive(userMessage, message, receive);
+	if (error != B_OK)
+		return error;
+
+	// recvmsg()
+	ssize_t result = sStackInterface->recvmsg(socket, &message, flags);
+	if (result < 0)
+		return result;
+
+	if (finish_userland_receive(message, receive) != B_OK)
+		return B_BAD_ADDRESS;
+
+	return result;
+}
+
+
+static ssize_t
+user_sendmsg(net_socket* socket, const struct msghdr *userMessage, int flags)
+{
+	// copy message from userland
+	msghdr message;
+	iovec* userVecs;
+	MemoryDeleter vecsDeleter;
+	void* userAddress;
+	char address[MAX_SOCKET_ADDRESS_LENGTH];
+
+	status_t error = prepare_userland_msghdr(userMessage, message, userVecs,
+		vecsDeleter, userAddress, address);
+	if (error != B_OK)
+		return error;
+
+	// copy the address from userland
+	if (userAddress != NULL
+			&& user_memcpy(address, userAddress, message.msg_namelen) != B_OK) {
+		return B_BAD_ADDRESS;
+	}
+
+	// copy ancillary data from userland
+	MemoryDeleter ancillaryDeleter;
+	void* userAncillary = message.msg_control;
+	if (userAncillary != NULL) {
+		if (!IS_USER_ADDRESS(userAncillary))
+			return B_BAD_ADDRESS;
+		if (message.msg_controllen < 0
+				|| message.msg_controllen > MAX_ANCILLARY_DATA_LENGTH) {
+			return B_BAD_VALUE;
+		}
+
+		message.msg_control = malloc(message.msg_controllen);
+		if (message.msg_control == NULL)
+			return B_NO_MEMORY;
+		ancillaryDeleter.SetTo(message.msg_control);
+
+		if (user_memcpy(message.msg_control, userAncillary,
+				message.msg_controllen) != B_OK) {
+			return B_BAD_ADDRESS;
+		}
+	}
+
+	// sendmsg()
+	return sStackInterface->sendmsg(socket, &message, flags);
+}
+
+
 // #pragma mark - socket file descriptor
 
 
@@ -959,58 +1102,98 @@ _user_recvfrom(int socket, void *data, size_t length, int flags,
 ssize_t
 _user_recvmsg(int socket, struct msghdr *userMessage, int flags)
 {
-	// copy message from userland
-	msghdr message;
-	iovec* userVecs;
-	MemoryDeleter vecsDeleter;
-	void* userAddress;
-	char address[MAX_SOCKET_ADDRESS_LENGTH];
+	file_descriptor* descriptor;
+	GET_SOCKET_FD_OR_RETURN(socket, false, descriptor);
+	FDPutter _(descriptor);
 
-	status_t error = prepare_userland_msghdr(userMessage, message, userVecs,
-		vecsDeleter, userAddress, address);
-	if (error != B_OK)
-		return error;
+	SyscallRestartWrapper<ssize_t> result;
+	return result = user_recvmsg(descriptor->u.socket, userMessage, flags);
+}
 
-	// prepare a buffer for ancillary data
-	MemoryDeleter ancillaryDeleter;
-	void* ancillary = NULL;
-	void* userAncillary = message.msg_control;
-	if (userAncillary != NULL) {
-		if (!IS_USER_ADDRESS(userAncillary))
-			return B_BAD_ADDRESS;
-		if (message.msg_controllen < 0)
-			return B_BAD_VALUE;
-		if (message.msg_controllen > MAX_ANCILLARY_DATA_LENGTH)
-			message.msg_controllen = MAX_ANCILLARY_DATA_LENGTH;
 
-		message.msg_control = ancillary = malloc(message.msg_controllen);
-		if (message.msg_control == NULL)
-			return B_NO_MEMORY;
+ssize_t
+_user_recvmmsg(int socket, struct mmsghdr *userMessages, uint32 count,
+	int flags, bigtime_t timeout)
+{
+	if (userMessages == NULL || !IS_USER_ADDRESS(userMessages))
+		return B_BAD_ADDRESS;
+	if (count > MAX_MULTIPLE_MESSAGES)
+		count = MAX_MULTIPLE_MESSAGES;
 
-		ancillaryDeleter.SetTo(ancillary);
-	}
+	// the descriptor is only looked up once for the whole batch
+	file_descriptor* descriptor;
+	GET_SOCKET_FD_OR_RETURN(socket, false, descriptor);
+	FDPutter _(descriptor);
+
+	// the messages are handed to the stack in batches, so that it can take
+	// them out of the endpoint's queue at once
+	uint32 batchSize = min_c(count, MAX_RECEIVE_BATCH);
+	mmsghdr* messages = new(std::nothrow) mmsghdr[batchSize];
+	userland_receive* receives = new(std::nothrow) userland_receive[batchSize];
+	ArrayDeleter<mmsghdr> messagesDeleter(messages);
+	ArrayDeleter<userland_receive> receivesDeleter(receives);
+	if (messages == NULL || receives == NULL)
+		return B_NO_MEMORY;
+
+	bigtime_t deadline = timeout >= 0
+		? system_time() + timeout : B_INFINITE_TIMEOUT;
+	bool waitForOne = (flags & MSG_WAITFORONE) != 0;
+	flags &= ~MSG_WAITFORONE;
 
-	// recvmsg()
 	SyscallRestartWrapper<ssize_t> result;
 
-	result = common_recvmsg(socket, &message, flags, false);
-	if (result < 0)
-		return result;
+	uint32 received = 0;
+	status_t error = B_OK;
+	while (received < count && error == B_OK) {
+		uint32 batch = min_c(count - received, batchSize);
+		for (uint32 i = 0; i < batch; i++) {
+			error = prepare_userland_receive(
+				&userMessages[received + i].msg_hdr, messages[i].msg_hdr,
+				receives[i]);
+			if (error != B_OK) {
+				// receive the messages before this one first
+				batch = i;
+				break;
+			}
+		}
+		if (batch == 0)
+			break;
+
+		ssize_t batchReceived = sStackInterface->recvmmsg(
+			descriptor->u.socket, messages, batch, flags);
+		if (batchReceived < 0) {
+			error = batchReceived;
+			break;
+		}
 
-	// copy the address, the ancillary data, and the message header back to
-	// userland
-	message.msg_name = userAddress;
-	message.msg_iov = userVecs;
-	message.msg_control = userAncillary;
-	if ((userAddress != NULL && user_memcpy(userAddress, address,
-				message.msg_namelen) != B_OK)
-		|| (userAncillary != NULL && user_memcpy(userAncillary, ancillary,
-				message.msg_controllen) != B_OK)
-		|| user_memcpy(userMessage, &message, sizeof(msghdr)) != B_OK) {
-		return B_BAD_ADDRESS;
+		for (uint32 i = 0; i < (uint32)batchReceived; i++) {
+			unsigned int length = messages[i].msg_len;
+			if (finish_userland_receive(messages[i].msg_hdr, receives[i])
+					!= B_OK
+				|| user_memcpy(&userMessages[received].msg_len, &length,
+					sizeof(length)) != B_OK) {
+				error = B_BAD_ADDRESS;
+				break;
+			}
+			received++;
+		}
+
+		if (waitForOne) {
+			// the queue is empty if the batch could not be filled
+			if ((uint32)batchReceived < batch)
+				break;
+			flags |= MSG_DONTWAIT;
+		}
+		if (system_time() >= deadline)
+			break;
 	}
 
-	return result;
+	// If we already got something, report that instead of the error -- it
+	// will be reported again on the next call
+	if (received > 0)
+		return result = received;
+
+	return result = error;
 }
 
 
@@ -1057,50 +1240,51 @@ _user_sendto(int socket, const void *data, size_t length, int flags,
 ssize_t
 _user_sendmsg(int socket, const struct msghdr *userMessage, int flags)
 {
-	// copy message from userland
-	msghdr message;
-	iovec* userVecs;
-	MemoryDeleter vecsDeleter;
-	void* userAddress;
-	char address[MAX_SOCKET_ADDRESS_LENGTH];
+	file_descriptor* descriptor;
+	GET_SOCKET_FD_OR_RETURN(socket, false, descriptor);
+	FDPutter _(descriptor);
 
-	status_t error = prepare_userland_msghdr(userMessage, message, userVecs,
-		vecsDeleter, userAddress, address);
-	if (error != B_OK)
-		return error;
+	SyscallRestartWrapper<ssize_t> result;
+	return result = user_sendmsg(descriptor->u.socket, userMessage, flags);
+}
 
-	// copy the address from userland
-	if (userAddress != NULL
-			&& user_memcpy(address, userAddress, message.msg_namelen) != B_OK) {
+
+ssize_t
+_user_sendmmsg(int socket, struct mmsghdr *userMessages, uint32 count,
+	int flags)
+{
+	if (userMessages == NULL || !IS_USER_ADDRESS(userMessages))
 		return B_BAD_ADDRESS;
-	}
+	if (count > MAX_MULTIPLE_MESSAGES)
+		count = MAX_MULTIPLE_MESSAGES;
 
-	// copy ancillary data from userland
-	MemoryDeleter ancillaryDeleter;
-	void* userAncillary = message.msg_control;
-	if (userAncillary != NULL) {
-		if (!IS_USER_ADDRESS(userAncillary))
-			return B_BAD_ADDRESS;
-		if (message.msg_controllen < 0
-				|| message.msg_controllen > MAX_ANCILLARY_DATA_LENGTH) {
-			return B_BAD_VALUE;
-		}
+	file_descriptor* descriptor;
+	GET_SOCKET_FD_OR_RETURN(socket, false, descriptor);
+	FDPutter _(descriptor);
 
-		message.msg_control = malloc(message.msg_controllen);
-		if (message.msg_control == NULL)
-			return B_NO_MEMORY;
-		ancillaryDeleter.SetTo(message.msg_control);
+	SyscallRestartWrapper<ssize_t> result;
 
-		if (user_memcpy(message.msg_control, userAncillary,
-				message.msg_controllen) != B_OK) {
-			return B_BAD_ADDRESS;
+	uint32 sent = 0;
+	while (sent < count) {
+		ssize_t bytesSent = user_sendmsg(descriptor->u.socket,
+			&userMessages[sent].msg_hdr, flags);
+		if (bytesSent < 0) {
+			if (sent > 0)
+				break;
+			return result = bytesSent;
 		}
-	}
 
-	// sendmsg()
-	SyscallRestartWrapper<ssize_t> result;
+		unsigned int length = bytesSent;
+		if (user_memcpy(&userMessages[sent].msg_len, &length,
+				sizeof(length)) != B_OK) {
+			if (sent > 0)
+				break;
+			return result = B_BAD_ADDRESS;
+		}
+		sent++;
+	}
 
-	return result = common_sendmsg(socket, &message, flags, false);
+	return result = sent;
 }
 
 
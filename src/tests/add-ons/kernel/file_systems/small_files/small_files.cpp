@@ -0,0 +1,233 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+/*!	Measures how many small files per second a file system can create (and
+	remove again), optionally with several threads at once, and with an
+	fsync() after every file, as mail spools and version control systems
+	tend to do.
+
+	Only uses POSIX calls, so that it can also be run against a file system
+	mounted via FUSE.
+*/
+
+
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+
+static const char* kProgramName = "small_files";
+
+static const int kDefaultFileCount = 1000;
+static const int kDefaultFileSize = 512;
+static const int kMaxThreadCount = 64;
+
+
+struct thread_info {
+	pthread_t	thread;
+	int			index;
+	int			count;
+};
+
+
+static const char* sBaseDir = ".";
+static int sFileSize = kDefaultFileSize;
+static bool sSync = false;
+static bool sKeep = false;
+static char* sBuffer;
+
+
+static void
+usage(int status)
+{
+	fprintf(stderr,
+		"Usage: %s [options]\n"
+		"Creates, and removes many small files, and reports how many files\n"
+		"per second have been processed.\n"
+		"\n"
+		"  -f, --file-count=<count>\tThe number of files per thread. "
+			"Defaults to %d.\n"
+		"  -s, --file-size=<size>\tThe size of every file. Defaults to %d.\n"
+		"  -t, --threads=<count>\t\tThe number of threads creating files.\n"
+		"\t\t\t\tDefaults to 1.\n"
+		"  -b, --base-dir=<path>\t\tThe directory to create the files in.\n"
+		"\t\t\t\tDefaults to the current directory.\n"
+		"  -y, --sync\t\t\tCall fsync() after writing each file.\n"
+		"  -k, --keep\t\t\tDo not remove the files again.\n",
+		kProgramName, kDefaultFileCount, kDefaultFileSize);
+
+	exit(status);
+}
+
+
+static double
+current_time()
+{
+	struct timeval time;
+	gettimeofday(&time, NULL);
+	return time.tv_sec + time.tv_usec / 1000000.0;
+}
+
+
+static void
+file_name(char* buffer, size_t size, int thread, int index)
+{
+	snprintf(buffer, size, "%s/small-%d-%d", sBaseDir, thread, index);
+}
+
+
+static void*
+create_files(void* _info)
+{
+	thread_info* info = (thread_info*)_info;
+	char name[PATH_MAX];
+
+	for (int i = 0; i < info->count; i++) {
+		file_name(name, sizeof(name), info->index, i);
+
+		int fd = open(name, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+		if (fd < 0) {
+			fprintf(stderr, "%s: could not create \"%s\": %s\n", kProgramName,
+				name, strerror(errno));
+			exit(1);
+		}
+
+		if (write(fd, sBuffer, sFileSize) != sFileSize) {
+			fprintf(stderr, "%s: could not write \"%s\": %s\n", kProgramName,
+				name, strerror(errno));
+			exit(1);
+		}
+
+		if (sSync && fsync(fd) != 0) {
+			fprintf(stderr, "%s: could not sync \"%s\": %s\n", kProgramName,
+				name, strerror(errno));
+			exit(1);
+		}
+
+		close(fd);
+	}
+
+	return NULL;
+}
+
+
+static void*
+remove_files(void* _info)
+{
+	thread_info* info = (thread_info*)_info;
+	char name[PATH_MAX];
+
+	for (int i = 0; i < info->count; i++) {
+		file_name(name, sizeof(name), info->index, i);
+		unlink(name);
+	}
+
+	return NULL;
+}
+
+
+static void
+run(const char* action, void* (*function)(void*), thread_info* threads,
+	int threadCount)
+{
+	double start = current_time();
+
+	for (int i = 0; i < threadCount; i++)
+		pthread_create(&threads[i].thread, NULL, function, &threads[i]);
+	for (int i = 0; i < threadCount; i++)
+		pthread_join(threads[i].thread, NULL);
+
+	double elapsed = current_time() - start;
+	int files = threads[0].count * threadCount;
+
+	printf("%s %d files in %.3f s: %.1f files/s\n", action, files, elapsed,
+		elapsed > 0 ? files / elapsed : 0.0);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	const struct option kOptions[] = {
+		{"file-count", required_argument, 0, 'f'},
+		{"file-size", required_argument, 0, 's'},
+		{"threads", required_argument, 0, 't'},
+		{"base-dir", required_argument, 0, 'b'},
+		{"sync", no_argument, 0, 'y'},
+		{"keep", no_argument, 0, 'k'},
+		{"help", no_argument, 0, 'h'},
+		{NULL}
+	};
+
+	int fileCount = kDefaultFileCount;
+	int threadCount = 1;
+
+	int c;
+	while ((c = getopt_long(argc, argv, "f:s:t:b:ykh", kOptions, NULL))
+			!= -1) {
+		switch (c) {
+			case 'f':
+				fileCount = atoi(optarg);
+				if (fileCount < 1)
+					fileCount = 1;
+				break;
+			case 's':
+				sFileSize = atoi(optarg);
+				if (sFileSize < 0)
+					sFileSize = 0;
+				break;
+			case 't':
+				threadCount = atoi(optarg);
+				if (threadCount < 1)
+					threadCount = 1;
+				else if (threadCount > kMaxThreadCount)
+					threadCount = kMaxThreadCount;
+				break;
+			case 'b':
+				sBaseDir = optarg;
+				break;
+			case 'y':
+				sSync = true;
+				break;
+			case 'k':
+				sKeep = true;
+				break;
+			case 'h':
+				usage(0);
+				break;
+			default:
+				usage(1);
+				break;
+		}
+	}
+
+	sBuffer = (char*)malloc(sFileSize + 1);
+	if (sBuffer == NULL) {
+		fprintf(stderr, "%s: out of memory\n", kProgramName);
+		return 1;
+	}
+	memset(sBuffer, 'x', sFileSize);
+
+	thread_info threads[kMaxThreadCount];
+	for (int i = 0; i < threadCount; i++) {
+		threads[i].index = i;
+		threads[i].count = fileCount;
+	}
+
+	run("created", &create_files, threads, threadCount);
+	if (!sKeep)
+		run("removed", &remove_files, threads, threadCount);
+
+	free(sBuffer);
+	return 0;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+/*!	Measures the BRegion operations the way the app_server uses them when
+	a window is moved around on a crowded desktop: the visible region of
+	each window is its frame minus the frames of all windows above it, the
+	visible regions of its views are clipped against it, and the dirty
+	region of the move is intersected with all of them.
+*/
+
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <OS.h>
+#include <Region.h>
+
+
+static const int32 kWindowCount = 24;
+static const int32 kViewsPerWindow = 8;
+static const int32 kMoveCount = 500;
+static const int32 kScreenWidth = 1600;
+static const int32 kScreenHeight = 1200;
+
+
+static BRect sWindowFrames[kWindowCount];
+static BRect sViewFrames[kWindowCount][kViewsPerWindow];
+
+
+static int32
+random_between(int32 min, int32 max)
+{
+	return min + rand() % (max - min + 1);
+}
+
+
+static void
+init_desktop()
+{
+	srand(42);
+
+	for (int32 i = 0; i < kWindowCount; i++) {
+		int32 width = random_between(200, 800);
+		int32 height = random_between(150, 600);
+		int32 left = random_between(0, kScreenWidth - width);
+		int32 top = random_between(0, kScreenHeight - height);
+		sWindowFrames[i].Set(left, top, left + width - 1, top + height - 1);
+
+		// a tool bar, a list, a scroll bar, a status bar, and a few
+		// controls
+		BRect frame = sWindowFrames[i];
+		for (int32 j = 0; j < kViewsPerWindow; j++) {
+			int32 viewLeft = random_between(0, width / 2);
+			int32 viewTop = random_between(0, height / 2);
+			sViewFrames[i][j].Set(frame.left + viewLeft, frame.top + viewTop,
+				frame.left + random_between(viewLeft, width - 1),
+				frame.top + random_between(viewTop, height - 1));
+		}
+	}
+}
+
+
+static int32
+rebuild_clipping(const BRegion& dirty)
+{
+	BRegion covered;
+	int32 rects = 0;
+
+	// from the front most window to the back
+	for (int32 i = kWindowCount - 1; i >= 0; i--) {
+		BRegion visible(sWindowFrames[i]);
+		visible.Exclude(&covered);
+		covered.Include(sWindowFrames[i]);
+
+		BRegion windowDirty(dirty);
+		windowDirty.IntersectWith(&visible);
+		if (windowDirty.CountRects() == 0)
+			continue;
+
+		BRegion childrenCovered;
+		for (int32 j = kViewsPerWindow - 1; j >= 0; j--) {
+			BRegion viewVisible(sViewFrames[i][j]);
+			viewVisible.IntersectWith(&visible);
+			viewVisible.Exclude(&childrenCovered);
+			childrenCovered.Include(sViewFrames[i][j]);
+
+			viewVisible.IntersectWith(&windowDirty);
+			rects += viewVisible.CountRects();
+		}
+	}
+
+	return rects;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	init_desktop();
+
+	BRect& moving = sWindowFrames[kWindowCount / 2];
+	int32 rects = 0;
+
+	bigtime_t start = system_time();
+
+	for (int32 i = 0; i < kMoveCount; i++) {
+		// move the window a bit, and redraw what it covered before
+		BRegion dirty(moving);
+		int32 offset = (i / 50) % 2 == 0 ? 4 : -4;
+		moving.OffsetBy(offset, offset / 2);
+		for (int32 j = 0; j < kViewsPerWindow; j++)
+			sViewFrames[kWindowCount / 2][j].OffsetBy(offset, offset / 2);
+		dirty.Include(moving);
+
+		rects += rebuild_clipping(dirty);
+	}
+
+	bigtime_t time = system_time() - start;
+
+	printf("%" B_PRId32 " window moves in %" B_PRId64 " usecs, %g usecs per "
+		"move (%" B_PRId32 " rects)\n", kMoveCount, time,
+		(double)time / kMoveCount, rects);
+	return 0;
+}
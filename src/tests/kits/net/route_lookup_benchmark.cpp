@@ -0,0 +1,134 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+//!	Measures route lookups and UDP sends against a large synthetic table
+
+
+#include <arpa/inet.h>
+#include <net/if.h>
+#include <net/route.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/sockio.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const char* kInterface = "loop";
+
+
+static void
+set_address(sockaddr_in& address, uint32 ip)
+{
+	memset(&address, 0, sizeof(address));
+	address.sin_len = sizeof(address);
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(ip);
+}
+
+
+static uint32
+route_destination(int index)
+{
+	// 10.x.y.0/24 networks
+	return 0x0a000000 | ((uint32)index << 8);
+}
+
+
+static bool
+change_route(int socket, int index, bool add)
+{
+	sockaddr_in destination;
+	sockaddr_in mask;
+	set_address(destination, route_destination(index));
+	set_address(mask, 0xffffff00);
+
+	ifreq request;
+	strlcpy(request.ifr_name, kInterface, IF_NAMESIZE);
+	memset(&request.ifr_route, 0, sizeof(route_entry));
+	request.ifr_route.destination = (sockaddr*)&destination;
+	request.ifr_route.mask = (sockaddr*)&mask;
+	request.ifr_route.flags = RTF_STATIC;
+
+	return ioctl(socket, add ? SIOCADDRT : SIOCDELRT, &request,
+		sizeof(request)) == 0;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int routeCount = 10000;
+	if (argc > 1)
+		routeCount = atoi(argv[1]);
+	int lookups = 1000000;
+	if (argc > 2)
+		lookups = atoi(argv[2]);
+	int destinationCount = 16;
+	if (argc > 3)
+		destinationCount = atoi(argv[3]);
+
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		perror("socket");
+		return 1;
+	}
+
+	for (int i = 0; i < routeCount; i++) {
+		if (!change_route(fd, i, true)) {
+			fprintf(stderr, "adding route %d failed: %s\n", i,
+				strerror(errno));
+			routeCount = i;
+			break;
+		}
+	}
+
+	// Lookups only cycle through a few destinations, as a busy server
+	// would; the routes at the end of the table are the expensive ones.
+	sockaddr_in destinations[destinationCount];
+	for (int i = 0; i < destinationCount; i++) {
+		set_address(destinations[i],
+			route_destination(routeCount - 1 - i % routeCount) | 1);
+		destinations[i].sin_port = htons(9);
+	}
+
+	bigtime_t start = system_time();
+	for (int i = 0; i < lookups; i++) {
+		ifreq request;
+		memset(&request, 0, sizeof(request));
+		request.ifr_route.destination
+			= (sockaddr*)&destinations[i % destinationCount];
+		if (ioctl(fd, SIOCGETRT, &request, sizeof(request)) != 0) {
+			fprintf(stderr, "route lookup failed: %s\n", strerror(errno));
+			break;
+		}
+	}
+	bigtime_t time = system_time() - start;
+	printf("%d routes: %d lookups in %lld usecs, %.2f usecs/lookup\n",
+		routeCount, lookups, time, (double)time / lookups);
+
+	char data[32] = {};
+	start = system_time();
+	for (int i = 0; i < lookups; i++) {
+		sendto(fd, data, sizeof(data), 0,
+			(sockaddr*)&destinations[i % destinationCount],
+			sizeof(sockaddr_in));
+	}
+	time = system_time() - start;
+	printf("%d routes: %d sends in %lld usecs, %.2f usecs/send\n",
+		routeCount, lookups, time, (double)time / lookups);
+
+	for (int i = 0; i < routeCount; i++)
+		change_route(fd, i, false);
+
+	close(fd);
+	return 0;
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+//! Measures TCP connections per second over loopback
+
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const int kMaxThreads = 32;
+
+static int sPort;
+static int sConnectionsPerThread = 10000;
+static int32 sAccepted;
+
+
+static int
+create_listener(bool reusePort)
+{
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		perror("socket");
+		exit(1);
+	}
+
+	int enable = 1;
+	if (reusePort
+		&& setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &enable,
+			sizeof(enable)) != 0) {
+		perror("setsockopt");
+		exit(1);
+	}
+
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_len = sizeof(address);
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = sPort;
+	if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+		perror("bind");
+		exit(1);
+	}
+
+	socklen_t length = sizeof(address);
+	getsockname(fd, (sockaddr*)&address, &length);
+	sPort = address.sin_port;
+
+	if (listen(fd, 128) != 0) {
+		perror("listen");
+		exit(1);
+	}
+
+	return fd;
+}
+
+
+static void*
+accept_thread(void* _listener)
+{
+	int listener = (int)(addr_t)_listener;
+
+	while (true) {
+		int fd = accept(listener, NULL, NULL);
+		if (fd < 0)
+			break;
+
+		close(fd);
+		atomic_add(&sAccepted, 1);
+	}
+
+	return NULL;
+}
+
+
+static void*
+connect_thread(void*)
+{
+	sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_len = sizeof(address);
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = sPort;
+
+	for (int i = 0; i < sConnectionsPerThread; i++) {
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (fd < 0) {
+			perror("socket");
+			exit(1);
+		}
+		if (connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+			fprintf(stderr, "connect %d failed: %s\n", i, strerror(errno));
+			exit(1);
+		}
+		close(fd);
+	}
+
+	return NULL;
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int threadCount = 4;
+	if (argc > 1)
+		threadCount = atoi(argv[1]);
+	if (argc > 2)
+		sConnectionsPerThread = atoi(argv[2]);
+	bool shareListener = argc > 3 && !strcmp(argv[3], "shared");
+
+	if (threadCount < 1 || threadCount > kMaxThreads) {
+		fprintf(stderr, "usage: %s [threads [connections [shared]]]\n",
+			argv[0]);
+		return 1;
+	}
+
+	// Unless asked to share a single listener, every accept thread gets its
+	// own SO_REUSEPORT listener
+	int listeners[kMaxThreads];
+	pthread_t acceptThreads[kMaxThreads];
+	pthread_t connectThreads[kMaxThreads];
+
+	for (int i = 0; i < threadCount; i++) {
+		if (i == 0 || !shareListener)
+			listeners[i] = create_listener(!shareListener);
+		else
+			listeners[i] = listeners[0];
+
+		pthread_create(&acceptThreads[i], NULL, &accept_thread,
+			(void*)(addr_t)listeners[i]);
+	}
+
+	bigtime_t start = system_time();
+
+	for (int i = 0; i < threadCount; i++)
+		pthread_create(&connectThreads[i], NULL, &connect_thread, NULL);
+	for (int i = 0; i < threadCount; i++)
+		pthread_join(connectThreads[i], NULL);
+
+	bigtime_t time = system_time() - start;
+	int total = threadCount * sConnectionsPerThread;
+
+	printf("%d threads, %d connections (%ld accepted) in %lld usecs: "
+		"%.0f connections/s\n", threadCount, total, sAccepted, time,
+		total * 1000000.0 / time);
+
+	for (int i = 0; i < threadCount; i++) {
+		if (i == 0 || !shareListener)
+			close(listeners[i]);
+	}
+
+	return 0;
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+//! Compares single datagram send/recv with sendmmsg()/recvmmsg() on loopback
+
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const int kDatagramSize = 64;
+static const int kBatchSize = 64;
+
+
+static int
+create_socket(sockaddr_in& address)
+{
+	int fd = socket(AF_INET, SOCK_DGRAM, 0);
+	if (fd < 0) {
+		perror("socket");
+		exit(1);
+	}
+
+	memset(&address, 0, sizeof(address));
+	address.sin_len = sizeof(address);
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+	if (bind(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+		perror("bind");
+		exit(1);
+	}
+
+	socklen_t length = sizeof(address);
+	if (getsockname(fd, (sockaddr*)&address, &length) != 0) {
+		perror("getsockname");
+		exit(1);
+	}
+
+	int bufferSize = 4 * 1024 * 1024;
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &bufferSize, sizeof(bufferSize));
+
+	return fd;
+}
+
+
+static void
+print_result(const char* name, int packets, bigtime_t time)
+{
+	printf("%-10s %8d packets in %8lld usecs, %10.0f pps\n", name, packets,
+		time, packets * 1000000.0 / time);
+}
+
+
+static void
+run_single(int sender, int receiver, const sockaddr_in& target, int count)
+{
+	char buffer[kDatagramSize];
+	memset(buffer, 'x', sizeof(buffer));
+
+	int received = 0;
+	bigtime_t start = system_time();
+
+	for (int sent = 0; sent < count; sent += kBatchSize) {
+		for (int i = 0; i < kBatchSize; i++) {
+			if (sendto(sender, buffer, sizeof(buffer), 0,
+					(const sockaddr*)&target, sizeof(target)) < 0) {
+				perror("sendto");
+				exit(1);
+			}
+		}
+		for (int i = 0; i < kBatchSize; i++) {
+			if (recv(receiver, buffer, sizeof(buffer), 0) < 0) {
+				perror("recv");
+				exit(1);
+			}
+			received++;
+		}
+	}
+
+	print_result("single", received, system_time() - start);
+}
+
+
+static void
+run_batched(int sender, int receiver, const sockaddr_in& target, int count)
+{
+	char buffers[kBatchSize][kDatagramSize];
+	iovec vecs[kBatchSize];
+	mmsghdr messages[kBatchSize];
+
+	memset(buffers, 'x', sizeof(buffers));
+	memset(messages, 0, sizeof(messages));
+	for (int i = 0; i < kBatchSize; i++) {
+		vecs[i].iov_base = buffers[i];
+		vecs[i].iov_len = kDatagramSize;
+		messages[i].msg_hdr.msg_iov = &vecs[i];
+		messages[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	int received = 0;
+	bigtime_t start = system_time();
+
+	for (int sent = 0; sent < count; sent += kBatchSize) {
+		for (int i = 0; i < kBatchSize; i++) {
+			messages[i].msg_hdr.msg_name = (void*)&target;
+			messages[i].msg_hdr.msg_namelen = sizeof(target);
+		}
+		int batchSent = sendmmsg(sender, messages, kBatchSize, 0);
+		if (batchSent < 0) {
+			perror("sendmmsg");
+			exit(1);
+		}
+
+		for (int i = 0; i < kBatchSize; i++) {
+			messages[i].msg_hdr.msg_name = NULL;
+			messages[i].msg_hdr.msg_namelen = 0;
+		}
+		int batchReceived = 0;
+		while (batchReceived < batchSent) {
+			int result = recvmmsg(receiver, messages + batchReceived,
+				batchSent - batchReceived, MSG_WAITFORONE, NULL);
+			if (result < 0) {
+				perror("recvmmsg");
+				exit(1);
+			}
+			batchReceived += result;
+		}
+		received += batchReceived;
+	}
+
+	print_result("batched", received, system_time() - start);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int count = 500000;
+	if (argc > 1)
+		count = atoi(argv[1]);
+
+	sockaddr_in senderAddress;
+	sockaddr_in receiverAddress;
+	int sender = create_socket(senderAddress);
+	int receiver = create_socket(receiverAddress);
+
+	run_single(sender, receiver, receiverAddress, count);
+	run_batched(sender, receiver, receiverAddress, count);
+
+	close(sender);
+	close(receiver);
+	return 0;
+}
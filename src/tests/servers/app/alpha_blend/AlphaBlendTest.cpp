@@ -0,0 +1,136 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+/*!	Checks that blend_row_alpha_sse2() gives exactly the same result as the
+	C code in blend_row_alpha() for all combinations of source, destination,
+	and alpha values. The rows are split the way the Painter does it, so
+	that rows that are too short for the SSE2 routine, and the one to three
+	pixels it leaves at their end, are covered as well. Rows don't start at
+	aligned addresses, either.
+*/
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include <OS.h>
+
+#include "AlphaBlending.h"
+
+
+static const int32 kMaxRowLength = 256 + 3;
+static const int32 kMaxOffset = 3;
+
+static uint8 sSource[(kMaxRowLength + kMaxOffset) * 4];
+static uint8 sScalar[(kMaxRowLength + kMaxOffset) * 4];
+static uint8 sSIMD[(kMaxRowLength + kMaxOffset) * 4];
+
+
+static bool
+has_sse2()
+{
+	cpuid_info info;
+	if (get_cpuid(&info, 1, 0) != B_OK)
+		return false;
+
+	return (info.regs.edx & (1 << 26)) != 0;
+}
+
+
+/*!	Blends the row like copy_bitmap_row_bgr32_alpha() in Painter.cpp. */
+static void
+blend_row_simd(uint8* dst, const uint8* src, int32 numPixels)
+{
+	int32 simdPixels = numPixels & ~3;
+	if (simdPixels > 0)
+		blend_row_alpha_sse2(dst, src, simdPixels);
+
+	if (numPixels > simdPixels) {
+		blend_row_alpha(dst + simdPixels * 4, src + simdPixels * 4,
+			numPixels - simdPixels);
+	}
+}
+
+
+/*!	Fills a row whose pixel \a i has the source value \a value and the
+	destination value \a i in its first channel, so that a row covers all
+	destination values. The other channels use other combinations, and the
+	destination alpha varies as well.
+*/
+static void
+fill_row(uint8* src, uint8* dst, int32 numPixels, uint8 value, uint8 alpha)
+{
+	for (int32 i = 0; i < numPixels; i++) {
+		src[i * 4 + 0] = value;
+		src[i * 4 + 1] = 255 - value;
+		src[i * 4 + 2] = value ^ 0x5a;
+		src[i * 4 + 3] = alpha;
+
+		dst[i * 4 + 0] = i;
+		dst[i * 4 + 1] = 255 - i;
+		dst[i * 4 + 2] = (i * 7) ^ 0xa5;
+		dst[i * 4 + 3] = i * 13;
+	}
+}
+
+
+static bool
+test_row(int32 numPixels, int32 offset, uint8 value, uint8 alpha)
+{
+	uint8* src = sSource + offset * 4;
+	uint8* scalar = sScalar + offset * 4;
+	uint8* simd = sSIMD + offset * 4;
+
+	fill_row(src, scalar, numPixels, value, alpha);
+	memcpy(simd, scalar, numPixels * 4);
+
+	blend_row_alpha(scalar, src, numPixels);
+	blend_row_simd(simd, src, numPixels);
+
+	if (memcmp(scalar, simd, numPixels * 4) == 0)
+		return true;
+
+	for (int32 i = 0; i < numPixels * 4; i++) {
+		if (scalar[i] == simd[i])
+			continue;
+
+		printf("Mismatch in a row of %" B_PRId32 " pixels at offset %"
+			B_PRId32 ", source value %u, alpha %u: byte %" B_PRId32 " is %u, "
+			"should be %u\n", numPixels, offset, value, alpha, i, simd[i],
+			scalar[i]);
+		break;
+	}
+	return false;
+}
+
+
+int
+main()
+{
+	if (!has_sse2()) {
+		printf("The CPU does not support SSE2, nothing to test.\n");
+		return 0;
+	}
+
+	int32 rows = 0;
+	for (int32 alpha = 0; alpha < 256; alpha++) {
+		for (int32 value = 0; value < 256; value++) {
+			int32 offset = (alpha + value) % (kMaxOffset + 1);
+
+			// all destination values, with a tail of up to three pixels
+			if (!test_row(256 + value % 4, offset, value, alpha))
+				return 1;
+
+			// rows too short for the SSE2 routine alone
+			if (!test_row(1 + value % 7, offset, value, alpha))
+				return 1;
+
+			rows += 2;
+		}
+	}
+
+	printf("All %" B_PRId32 " rows blended identically.\n", rows);
+	return 0;
+}
@@ -0,0 +1,221 @@
+/*
+ * Copyright 2013, Haiku, Inc. All Rights Reserved.
+ * Distributed under the terms of the MIT License.
+ */
+
+
+//!	Compares latency and throughput of unix sockets, pipes, and ports
+
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <OS.h>
+
+
+static const int kLatencyIterations = 100000;
+static const size_t kThroughputChunkSize = 65536;
+static const size_t kThroughputTotal = 1024 * 1024 * 1024;
+
+
+class Channel {
+public:
+	virtual						~Channel() {}
+
+	virtual	ssize_t				Write(int side, const void* buffer,
+									size_t size) = 0;
+	virtual	ssize_t				Read(int side, void* buffer, size_t size) = 0;
+};
+
+
+class FDChannel : public Channel {
+public:
+	// fds[0] is used by side 0 to write, fds[1] by side 1
+	FDChannel(int toOne[2], int toZero[2])
+	{
+		fWrite[0] = toOne[1];
+		fRead[1] = toOne[0];
+		fWrite[1] = toZero[1];
+		fRead[0] = toZero[0];
+	}
+
+	virtual ssize_t Write(int side, const void* buffer, size_t size)
+	{
+		return write(fWrite[side], buffer, size);
+	}
+
+	virtual ssize_t Read(int side, void* buffer, size_t size)
+	{
+		return read(fRead[side], buffer, size);
+	}
+
+private:
+	int	fWrite[2];
+	int	fRead[2];
+};
+
+
+class PortChannel : public Channel {
+public:
+	PortChannel()
+	{
+		fPorts[0] = create_port(16, "ipcbench side 0");
+		fPorts[1] = create_port(16, "ipcbench side 1");
+	}
+
+	virtual ~PortChannel()
+	{
+		delete_port(fPorts[0]);
+		delete_port(fPorts[1]);
+	}
+
+	virtual ssize_t Write(int side, const void* buffer, size_t size)
+	{
+		status_t status = write_port(fPorts[1 - side], 0, buffer, size);
+		return status == B_OK ? (ssize_t)size : status;
+	}
+
+	virtual ssize_t Read(int side, void* buffer, size_t size)
+	{
+		int32 code;
+		return read_port(fPorts[side], &code, buffer, size);
+	}
+
+private:
+	port_id	fPorts[2];
+};
+
+
+static Channel* sChannel;
+static bool sThroughput;
+
+
+static status_t
+peer_thread(void*)
+{
+	char* buffer = (char*)malloc(kThroughputChunkSize);
+
+	if (sThroughput) {
+		size_t total = 0;
+		while (total < kThroughputTotal) {
+			ssize_t bytesRead = sChannel->Read(1, buffer, kThroughputChunkSize);
+			if (bytesRead <= 0)
+				break;
+			total += bytesRead;
+		}
+		sChannel->Write(1, buffer, 1);
+	} else {
+		for (int i = 0; i < kLatencyIterations; i++) {
+			if (sChannel->Read(1, buffer, 1) != 1
+				|| sChannel->Write(1, buffer, 1) != 1)
+				break;
+		}
+	}
+
+	free(buffer);
+	return B_OK;
+}
+
+
+static void
+run(const char* name, Channel* channel)
+{
+	sChannel = channel;
+	char* buffer = (char*)malloc(kThroughputChunkSize);
+	memset(buffer, 0, kThroughputChunkSize);
+
+	// latency
+	sThroughput = false;
+	thread_id peer = spawn_thread(&peer_thread, "peer", B_NORMAL_PRIORITY,
+		NULL);
+	resume_thread(peer);
+
+	bigtime_t start = system_time();
+	for (int i = 0; i < kLatencyIterations; i++) {
+		if (channel->Write(0, buffer, 1) != 1
+			|| channel->Read(0, buffer, 1) != 1) {
+			fprintf(stderr, "%s: round trip failed: %s\n", name,
+				strerror(errno));
+			exit(1);
+		}
+	}
+	bigtime_t latency = system_time() - start;
+
+	status_t status;
+	wait_for_thread(peer, &status);
+
+	// throughput
+	sThroughput = true;
+	peer = spawn_thread(&peer_thread, "peer", B_NORMAL_PRIORITY, NULL);
+	resume_thread(peer);
+
+	start = system_time();
+	for (size_t total = 0; total < kThroughputTotal;
+			total += kThroughputChunkSize) {
+		if (channel->Write(0, buffer, kThroughputChunkSize) < 0) {
+			fprintf(stderr, "%s: write failed: %s\n", name, strerror(errno));
+			exit(1);
+		}
+	}
+	channel->Read(0, buffer, 1);
+	bigtime_t time = system_time() - start;
+
+	wait_for_thread(peer, &status);
+
+	printf("%-8s round trip %6.2f us, throughput %8.1f MB/s\n", name,
+		(double)latency / kLatencyIterations,
+		kThroughputTotal / 1048576.0 / (time / 1000000.0));
+
+	free(buffer);
+}
+
+
+int
+main(int argc, char** argv)
+{
+	int toOne[2];
+	int toZero[2];
+
+	// unix stream sockets
+	if (socketpair(AF_UNIX, SOCK_STREAM, 0, toOne) != 0) {
+		fprintf(stderr, "socketpair() failed: %s\n", strerror(errno));
+		return 1;
+	}
+	// a socket pair is bidirectional
+	toZero[0] = toOne[1];
+	toZero[1] = toOne[0];
+
+	int bufferSize = 128 * 1024;
+	setsockopt(toOne[0], SOL_SOCKET, SO_RCVBUF, &bufferSize,
+		sizeof(bufferSize));
+	setsockopt(toOne[1], SOL_SOCKET, SO_RCVBUF, &bufferSize,
+		sizeof(bufferSize));
+
+	FDChannel socketChannel(toOne, toZero);
+	run("unix", &socketChannel);
+	close(toOne[0]);
+	close(toOne[1]);
+
+	// pipes
+	if (pipe(toOne) != 0 || pipe(toZero) != 0) {
+		fprintf(stderr, "pipe() failed: %s\n", strerror(errno));
+		return 1;
+	}
+
+	FDChannel pipeChannel(toOne, toZero);
+	run("pipe", &pipeChannel);
+	close(toOne[0]);
+	close(toOne[1]);
+	close(toZero[0]);
+	close(toZero[1]);
+
+	// ports
+	PortChannel portChannel;
+	run("port", &portChannel);
+
+	return 0;
+}
@@ -5,6 +5,7 @@
 
 #define FUSE_USE_VERSION 27
 
+#include <fcntl.h>
 #include <fuse/fuse.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -24,6 +25,7 @@
 #include "fssh_node_monitor.h"
 #include "fssh_stat.h"
 #include "fssh_string.h"
+#include "fssh_time.h"
 #include "fssh_type_constants.h"
 #include "module.h"
 #include "syscalls.h"
@@ -38,6 +40,10 @@ namespace FSShell {
 
 const char* kMountPoint = "/myfs";
 
+// The largest write request we ask the kernel to send us (with "big_writes"),
+// instead of splitting all writes into single pages.
+static const int kMaxWriteSize = 128 * 1024;
+
 static mode_t sUmask = 0022;
 
 #define PRINTD(x) if (gIsDebug) fprintf(stderr, x)
@@ -130,6 +136,36 @@ fromFsshStatToStat(struct fssh_stat* f_stbuf, struct stat* stbuf)
 #define _ERR(x) (-1 * fssh_to_host_error(x))
 
 
+static int
+to_fssh_open_mode(int flags)
+{
+	int openMode = 0;
+
+	switch (flags & O_ACCMODE) {
+		case O_RDONLY:
+			openMode = FSSH_O_RDONLY;
+			break;
+		case O_WRONLY:
+			openMode = FSSH_O_WRONLY;
+			break;
+		default:
+			openMode = FSSH_O_RDWR;
+			break;
+	}
+
+	if ((flags & O_CREAT) != 0)
+		openMode |= FSSH_O_CREAT;
+	if ((flags & O_EXCL) != 0)
+		openMode |= FSSH_O_EXCL;
+	if ((flags & O_TRUNC) != 0)
+		openMode |= FSSH_O_TRUNC;
+	if ((flags & O_APPEND) != 0)
+		openMode |= FSSH_O_APPEND;
+
+	return openMode;
+}
+
+
 // pragma mark - FUSE functions
 
 
@@ -147,6 +183,19 @@ fuse_getattr(const char* path, struct stat* stbuf)
 }
 
 
+static int
+fuse_fgetattr(const char* path, struct stat* stbuf, struct fuse_file_info* fi)
+{
+	PRINTD("##fgetattr\n");
+	struct fssh_stat f_stbuf;
+	fssh_status_t status = _kern_read_stat((int)fi->fh, NULL, false, &f_stbuf,
+		sizeof(f_stbuf));
+	if (status == FSSH_B_OK)
+		fromFsshStatToStat(&f_stbuf, stbuf);
+	return _ERR(status);
+}
+
+
 static int
 fuse_access(const char* path, int mask)
 {
@@ -288,34 +337,96 @@ fuse_chown(const char* path, uid_t uid, gid_t gid)
 }
 
 
+static int
+fuse_truncate(const char* path, off_t size)
+{
+	PRINTD("##truncate\n");
+	fssh_struct_stat st;
+	st.fssh_st_size = size;
+	return _ERR(_kern_write_stat(-1, path, false, &st, sizeof(st),
+			FSSH_B_STAT_SIZE));
+}
+
+
+static int
+fuse_ftruncate(const char* path, off_t size, struct fuse_file_info* fi)
+{
+	PRINTD("##ftruncate\n");
+	fssh_struct_stat st;
+	st.fssh_st_size = size;
+	return _ERR(_kern_write_stat((int)fi->fh, NULL, false, &st, sizeof(st),
+			FSSH_B_STAT_SIZE));
+}
+
+
+static int
+fuse_utimens(const char* path, const struct timespec times[2])
+{
+	PRINTD("##utimens\n");
+	fssh_struct_stat st;
+	st.fssh_st_atim.tv_sec = times[0].tv_sec;
+	st.fssh_st_atim.tv_nsec = times[0].tv_nsec;
+	st.fssh_st_mtim.tv_sec = times[1].tv_sec;
+	st.fssh_st_mtim.tv_nsec = times[1].tv_nsec;
+	return _ERR(_kern_write_stat(-1, path, false, &st, sizeof(st),
+			FSSH_B_STAT_ACCESS_TIME | FSSH_B_STAT_MODIFICATION_TIME));
+}
+
+
+/*!	The file descriptors opened here stay open until fuse_release(), so that
+	reads and writes don't have to resolve the path, and open and close the
+	file again for every single request.
+*/
 static int
 fuse_open(const char* path, struct fuse_file_info* fi)
 {
 	PRINTD("##open\n");
-	// TODO: Do we have a syscall similar to the open syscall in linux which
-	// takes only two args: path and flags with no mask/perms?
-	int fd = _kern_open(-1, path, fi->flags,
+	int fd = _kern_open(-1, path, to_fssh_open_mode(fi->flags),
 		(FSSH_S_IRWXU | FSSH_S_IRWXG | FSSH_S_IRWXO) & ~sUmask);
-	_kern_close(fd);
 	if (fd < FSSH_B_OK)
 		return _ERR(fd);
-	else
-		return 0;
+
+	fi->fh = fd;
+	return 0;
 }
 
 
 static int
-fuse_read(const char* path, char* buf, size_t size, off_t offset,
-	struct fuse_file_info* fi)
+fuse_create(const char* path, mode_t mode, struct fuse_file_info* fi)
 {
-	PRINTD("##read\n");
-	int fd = _kern_open(-1, path, FSSH_O_RDONLY,
-		(FSSH_S_IRWXU | FSSH_S_IRWXG | FSSH_S_IRWXO) & ~sUmask);
+	PRINTD("##create\n");
+	int fd = _kern_open(-1, path, to_fssh_open_mode(fi->flags) | FSSH_O_CREAT,
+		mode & ~sUmask);
 	if (fd < FSSH_B_OK)
 		return _ERR(fd);
 
-	int res = _kern_read(fd, offset, buf, size);
-	_kern_close(fd);
+	fi->fh = fd;
+	return 0;
+}
+
+
+static int
+fuse_release(const char* path, struct fuse_file_info* fi)
+{
+	PRINTD("##release\n");
+	return _ERR(_kern_close((int)fi->fh));
+}
+
+
+static int
+fuse_fsync(const char* path, int dataSync, struct fuse_file_info* fi)
+{
+	PRINTD("##fsync\n");
+	return _ERR(_kern_fsync((int)fi->fh));
+}
+
+
+static int
+fuse_read(const char* path, char* buf, size_t size, off_t offset,
+	struct fuse_file_info* fi)
+{
+	PRINTD("##read\n");
+	int res = _kern_read((int)fi->fh, offset, buf, size);
 	if (res < FSSH_B_OK)
 		res = _ERR(res);
 	return res;
@@ -327,13 +438,7 @@ fuse_write(const char* path, const char* buf, size_t size, off_t offset,
 	struct fuse_file_info* fi)
 {
 	PRINTD("##write\n");
-	int fd = _kern_open(-1, path, FSSH_O_WRONLY,
-		(FSSH_S_IRWXU | FSSH_S_IRWXG | FSSH_S_IRWXO) & ~sUmask);
-	if (fd < FSSH_B_OK)
-		return _ERR(fd);
-
-	int res = _kern_write(fd, offset, buf, size);
-	_kern_close(fd);
+	int res = _kern_write((int)fi->fh, offset, buf, size);
 	if (res < FSSH_B_OK)
 		res = _ERR(res);
 	return res;
@@ -389,6 +494,7 @@ static void
 initialiseFuseOps(struct fuse_operations* fuseOps)
 {
 	fuseOps->getattr	= fuse_getattr;
+	fuseOps->fgetattr	= fuse_fgetattr;
 	fuseOps->access		= fuse_access;
 	fuseOps->readlink	= fuse_readlink;
 	fuseOps->readdir	= fuse_readdir;
@@ -401,14 +507,16 @@ initialiseFuseOps(struct fuse_operations* fuseOps)
 	fuseOps->link		= fuse_link;
 	fuseOps->chmod		= fuse_chmod;
 	fuseOps->chown		= fuse_chown;
-	fuseOps->truncate	= NULL;
-	fuseOps->utimens	= NULL;
+	fuseOps->truncate	= fuse_truncate;
+	fuseOps->ftruncate	= fuse_ftruncate;
+	fuseOps->utimens	= fuse_utimens;
 	fuseOps->open		= fuse_open;
+	fuseOps->create		= fuse_create;
 	fuseOps->read		= fuse_read;
 	fuseOps->write		= fuse_write;
 	fuseOps->statfs		= fuse_statfs;
-	fuseOps->release	= NULL;
-	fuseOps->fsync		= NULL;
+	fuseOps->release	= fuse_release;
+	fuseOps->fsync		= fuse_fsync;
 	fuseOps->destroy	= fuse_destroy;
 }
 
@@ -483,9 +591,13 @@ fssh_fuse_session(const char* device, const char* mntPoint, const char* fsName,
 
 	// default FUSE options
 	char* fsNameOption = NULL;
+	char* maxWriteOption = NULL;
 	if (fuse_opt_add_opt(&fuseOptions, "allow_other") < 0
 		|| asprintf(&fsNameOption, "fsname=%s", device) < 0
-		|| fuse_opt_add_opt(&fuseOptions, fsNameOption) < 0) {
+		|| fuse_opt_add_opt(&fuseOptions, fsNameOption) < 0
+		|| fuse_opt_add_opt(&fuseOptions, "big_writes") < 0
+		|| asprintf(&maxWriteOption, "max_write=%d", kMaxWriteSize) < 0
+		|| fuse_opt_add_opt(&fuseOptions, maxWriteOption) < 0) {
 		unmount_volume(device, mntPoint);
 		return 1;
 	}
@@ -510,6 +622,9 @@ fssh_fuse_session(const char* device, const char* mntPoint, const char* fsName,
 	}
 
  	// Run the fuse_main() loop.
+	// The kernel emulation is single-threaded: the semaphores and
+	// find_thread() of the build platform's libroot are fakes that cannot
+	// block, so requests must not be handled by more than one thread ("-s").
 	if (fuse_opt_add_arg(&fuseArgs, "-s") < 0
 		|| fuse_opt_add_arg(&fuseArgs, "-o") < 0
 		|| fuse_opt_add_arg(&fuseArgs, fuseOptions) < 0) {